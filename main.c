@@ -13,8 +13,13 @@
 #include "tests/r2_heap_test.h"
 #include "tests/r2_unionfind_test.h"
 #include "tests/r2_sort_test.h"
+#include "tests/r2_sort_bench.h"
 #include "tests/r2_string_test.h"
+#include "tests/r2_string_bench.h"
 #include "tests/r2_trie_test.h"
+#include "tests/r2_suffixarray_test.h"
+#include "tests/r2_fmindex_test.h"
+#include "tests/r2_chunker_test.h"
 #include <stdio.h>
 #include <time.h>
 #include <stdlib.h>
@@ -32,6 +37,9 @@ int main()
         test_r2_list_run();
         test_r2_ring_run();
         test_r2_trie_run();
+        test_r2_suffixarray_run();
+        test_r2_fmindex_run();
+        test_r2_chunker_run();
         test_r2_pq_run();
         
         //test_r2_avltree_run();
@@ -42,6 +50,8 @@ int main()
         //test_r2_unionfind_run(); 
         //test_r2_graph_run();
         //r2_sort_test_run();
+        //r2_sort_bench_run(1000000, R2_BENCH_CSV, "sort_bench.csv");
+        //r2_string_bench_run(4000000, R2_BENCH_CSV, "string_bench.csv");
 
         
         return 0;
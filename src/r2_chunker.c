@@ -0,0 +1,321 @@
+#include "r2_chunker.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#define MIN(a, b) ((a) < (b)? (a) : (b))
+#define GEAR_SEED 0x2545F4914F6CDD1DULL/*seed of the Gear table, boundaries only match between chunkers with the same table*/
+#define P1 0x9E3779B185EBCA87ULL
+#define P2 0xC2B2AE3D27D4EB4FULL
+#define P3 0x165667B19E3779F9ULL
+#define P4 0x85EBCA77C2B2AE63ULL
+#define ROTL(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+static r2_uint64 gear_scan(const r2_uint64 *, const r2_uc *, r2_uint64, r2_uint64 *, r2_uint64);
+static void fp_update(struct r2_chunker *, const r2_uc *, r2_uint64, r2_uint64);
+static inline r2_uint64 fp_round(r2_uint64, r2_uint64);
+static inline r2_uint64 fp_read(const r2_uc *);
+static r2_uint64 chunk_emit(struct r2_chunker *, r2_act, void *);
+static void chunk_start(struct r2_chunker *);
+
+/**
+ * @brief                       Creates a content-defined chunker.
+ *
+ *                              The Gear hash is updated with h = 2h + gear[byte], so bit k of the hash depends on the 
+ *                              last k + 1 bytes and the high bits of the mask cover a window of up to 64 bytes without
+ *                              removing the byte that leaves the window as a Rabin fingerprint does. The first min bytes 
+ *                              of a chunk aren't hashed since no boundary can be placed there. Before avg bytes the mask
+ *                              has two more bits than log2(avg), after avg bytes two fewer (normalized chunking), which
+ *                              keeps most chunk lengths close to avg. A chunk is cut at max bytes when no boundary is found.
+ *
+ * @param min                   Minimum length of a chunk.
+ * @param avg                   Expected length of a chunk, at least 8.
+ * @param max                   Maximum length of a chunk.
+ * @return struct r2_chunker*   Returns the chunker, else NULL when min <= avg <= max doesn't hold.
+ */
+struct r2_chunker* r2_create_chunker(r2_uint64 min, r2_uint64 avg, r2_uint64 max)
+{
+        struct r2_chunker *ck = NULL;
+        r2_uint64 bits = 0, x = GEAR_SEED, z;
+        if(avg < 8 || min > avg || avg > max)
+                return NULL;
+
+        ck = malloc(sizeof(struct r2_chunker));
+        if(ck == NULL)
+                return NULL;
+
+        /*mask_s shifts by bits + 2, which must stay below 64.*/
+        while(bits < 61 && (avg >> (bits + 1)) != 0)
+                ++bits;
+        ck->min    = min;
+        ck->avg    = avg;
+        ck->max    = max;
+        ck->mask_s = ~((r2_uint64)-1 >> (bits + 2));
+        ck->mask_l = ~((r2_uint64)-1 >> (bits - 2));
+        /*The table is filled by splitmix64 so every chunker splits the same content the same way.*/
+        for(r2_uint64 i = 0; i < 256; ++i){
+                x += 0x9E3779B97F4A7C15ULL;
+                z  = x;
+                z  = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+                z  = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+                ck->gear[i] = z ^ (z >> 31);
+        }
+        r2_chunker_reset(ck);
+        return ck;
+}
+
+/**
+ * @brief                       Destroys a chunker.
+ *
+ * @param ck                    Chunker.
+ * @return struct r2_chunker*   Returns NULL.
+ */
+struct r2_chunker* r2_destroy_chunker(struct r2_chunker *ck)
+{
+        free(ck);
+        return NULL;
+}
+
+/**
+ * @brief               Drops the current chunk and starts a new stream at offset 0.
+ *
+ * @param ck            Chunker.
+ */
+void r2_chunker_reset(struct r2_chunker *ck)
+{
+        ck->offset = 0;
+        chunk_start(ck);
+}
+
+/**
+ * @brief               Feeds the next buffer of a stream to a chunker. For every chunk that ends in the buffer 
+ *                      action is called with a struct r2_chunk. The bytes after the last boundary stay in the 
+ *                      current chunk, which is continued by the next buffer or ended by r2_chunker_finish. 
+ *                      Only the hash and the fingerprint of the current chunk are kept, the buffer isn't copied.
+ *
+ * @param ck            Chunker.
+ * @param buf           Buffer.
+ * @param len           Length of buffer.
+ * @param action        A callback function called for every chunk, can be NULL.
+ * @param arg           Argument passed to action.
+ * @return r2_uint64    Returns the number of chunks that ended in the buffer.
+ */
+r2_uint64 r2_chunker_feed(struct r2_chunker *ck, const r2_c *buf, r2_uint64 len, r2_act action, void *arg)
+{
+        assert(ck != NULL && (buf != NULL || len == 0));
+        const r2_uc *t = (const r2_uc *)buf;
+        r2_uint64 count = 0;
+        r2_uint64 i = 0, b, s, r;
+        r2_uint16 cut;
+        while(i < len){
+                b   = i;
+                cut = FALSE;
+                if(ck->pos < ck->min){
+                        s = MIN(ck->min - ck->pos, len - i);
+                        i += s;
+                        ck->pos += s;
+                }
+
+                if(ck->pos >= ck->min && ck->pos < ck->avg && i < len){
+                        s = MIN(ck->avg - ck->pos, len - i);
+                        r = gear_scan(ck->gear, &t[i], s, &ck->hash, ck->mask_s);
+                        cut = r != 0;
+                        s = cut? r : s;
+                        i += s;
+                        ck->pos += s;
+                }
+
+                if(!cut && ck->pos >= ck->avg && ck->pos < ck->max && i < len){
+                        s = MIN(ck->max - ck->pos, len - i);
+                        r = gear_scan(ck->gear, &t[i], s, &ck->hash, ck->mask_l);
+                        cut = r != 0;
+                        s = cut? r : s;
+                        i += s;
+                        ck->pos += s;
+                }
+
+                fp_update(ck, &t[b], i - b, ck->pos - (i - b));
+                if(cut || ck->pos == ck->max)
+                        count += chunk_emit(ck, action, arg);
+        }
+        return count;
+}
+
+/**
+ * @brief               Ends the stream. The bytes after the last boundary are reported as the last chunk, which 
+ *                      can be shorter than min. The chunker is then reset for a new stream.
+ *
+ * @param ck            Chunker.
+ * @param action        A callback function called for the last chunk, can be NULL.
+ * @param arg           Argument passed to action.
+ * @return r2_uint64    Returns 1 when the stream ended with a chunk, 0 when it was empty or ended on a boundary.
+ */
+r2_uint64 r2_chunker_finish(struct r2_chunker *ck, r2_act action, void *arg)
+{
+        r2_uint64 count = ck->pos > 0? chunk_emit(ck, action, arg) : 0;
+        r2_chunker_reset(ck);
+        return count;
+}
+
+/**
+ * @brief               Rolls the Gear hash over a buffer until the hash has no bit of mask set.
+ *
+ * @param gear          Gear table.
+ * @param t             Buffer.
+ * @param n             Length of buffer.
+ * @param hash          Gear hash, updated with every byte read.
+ * @param mask          Mask.
+ * @return r2_uint64    Returns the number of bytes read up to and including the boundary, else 0.
+ */
+static r2_uint64 gear_scan(const r2_uint64 *gear, const r2_uc *t, r2_uint64 n, r2_uint64 *hash, r2_uint64 mask)
+{
+        r2_uint64 h = *hash;
+        r2_uint64 i = 0;
+        /*Unrolled so every byte costs a load, a table lookup, an add and a test, the loop is bound by instruction throughput.*/
+        for(; i + 4 <= n; i += 4){
+                h = h + h + gear[t[i]];
+                if((h & mask) == 0)
+                        goto FOUND;
+                h = h + h + gear[t[i + 1]];
+                if((h & mask) == 0){
+                        i += 1;
+                        goto FOUND;
+                }
+                h = h + h + gear[t[i + 2]];
+                if((h & mask) == 0){
+                        i += 2;
+                        goto FOUND;
+                }
+                h = h + h + gear[t[i + 3]];
+                if((h & mask) == 0){
+                        i += 3;
+                        goto FOUND;
+                }
+        }
+
+        for(; i < n; ++i){
+                h = h + h + gear[t[i]];
+                if((h & mask) == 0)
+                        goto FOUND;
+        }
+        *hash = h;
+        return 0;
+FOUND:
+        *hash = h;
+        return i + 1;
+}
+
+/**
+ * @brief               Adds bytes to the fingerprint of the current chunk. The fingerprint is built from xxHash64
+ *                      rounds: the word at position w of the chunk is mixed into lane w % 4, so the four lanes don't
+ *                      wait on each other and 32 bytes are mixed per round. Bytes are read as little endian words and
+ *                      words cut by the end of a buffer are completed by the next one, so the fingerprint doesn't 
+ *                      depend on how the stream is split.
+ *
+ * @param ck            Chunker.
+ * @param t             Bytes.
+ * @param n             Number of bytes.
+ * @param pos           Position of the first byte in the chunk.
+ */
+static void fp_update(struct r2_chunker *ck, const r2_uc *t, r2_uint64 n, r2_uint64 pos)
+{
+        r2_uint64 *v = ck->lanes;
+        while(n > 0 && pos % 8 != 0){
+                ck->word |= (r2_uint64)*t++ << (8*(pos % 8));
+                ++pos;
+                --n;
+                if(pos % 8 == 0){
+                        v[(pos/8 - 1) % 4] = fp_round(v[(pos/8 - 1) % 4], ck->word);
+                        ck->word = 0;
+                }
+        }
+
+        for(; n >= 8 && (pos/8) % 4 != 0; t += 8, pos += 8, n -= 8)
+                v[(pos/8) % 4] = fp_round(v[(pos/8) % 4], fp_read(t));
+
+        /*The lanes are kept in locals, stores through v could alias the bytes and would be reloaded every round.*/
+        r2_uint64 v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3];
+        for(; n >= 32; t += 32, pos += 32, n -= 32){
+                v0 = fp_round(v0, fp_read(t));
+                v1 = fp_round(v1, fp_read(t + 8));
+                v2 = fp_round(v2, fp_read(t + 16));
+                v3 = fp_round(v3, fp_read(t + 24));
+        }
+        v[0] = v0;
+        v[1] = v1;
+        v[2] = v2;
+        v[3] = v3;
+
+        for(; n >= 8; t += 8, pos += 8, n -= 8)
+                v[(pos/8) % 4] = fp_round(v[(pos/8) % 4], fp_read(t));
+
+        for(; n > 0; ++t, ++pos, --n)
+                ck->word |= (r2_uint64)*t << (8*(pos % 8));
+}
+
+/**
+ * @brief               Mixes a word into a lane.
+ */
+static inline r2_uint64 fp_round(r2_uint64 acc, r2_uint64 word)
+{
+        acc += word*P2;
+        acc  = ROTL(acc, 31);
+        return acc*P1;
+}
+
+/**
+ * @brief               Reads 8 bytes as a little endian word.
+ */
+static inline r2_uint64 fp_read(const r2_uc *t)
+{
+        return (r2_uint64)t[0] | (r2_uint64)t[1] << 8 | (r2_uint64)t[2] << 16 | (r2_uint64)t[3] << 24 |
+               (r2_uint64)t[4] << 32 | (r2_uint64)t[5] << 40 | (r2_uint64)t[6] << 48 | (r2_uint64)t[7] << 56;
+}
+
+/**
+ * @brief               Reports the current chunk and starts the next one.
+ *
+ * @param ck            Chunker.
+ * @param action        A callback function called with the chunk, can be NULL.
+ * @param arg           Argument passed to action.
+ * @return r2_uint64    Returns 1.
+ */
+static r2_uint64 chunk_emit(struct r2_chunker *ck, r2_act action, void *arg)
+{
+        const r2_uint64 *v = ck->lanes;
+        struct r2_chunk chunk;
+        r2_uint64 h = ROTL(v[0], 1) + ROTL(v[1], 7) + ROTL(v[2], 12) + ROTL(v[3], 18);
+        for(r2_uint64 i = 0; i < 4; ++i)
+                h = (h ^ fp_round(0, v[i]))*P1 + P4;
+        h += ck->pos;
+        if(ck->pos % 8 != 0)
+                h = ROTL(h ^ fp_round(0, ck->word), 27)*P1 + P4;
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+
+        chunk.offset      = ck->offset;
+        chunk.len         = ck->pos;
+        chunk.fingerprint = h;
+        ck->offset += ck->pos;
+        chunk_start(ck);
+        if(action != NULL)
+                action(&chunk, arg);
+        return 1;
+}
+
+/**
+ * @brief               Clears the hash and the fingerprint for a new chunk.
+ *
+ * @param ck            Chunker.
+ */
+static void chunk_start(struct r2_chunker *ck)
+{
+        ck->hash     = 0;
+        ck->pos      = 0;
+        ck->word     = 0;
+        ck->lanes[0] = P1 + P2;
+        ck->lanes[1] = P2;
+        ck->lanes[2] = 0;
+        ck->lanes[3] = -P1;
+}
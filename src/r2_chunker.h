@@ -0,0 +1,36 @@
+#ifndef R2_CHUNKER_H_
+#define R2_CHUNKER_H_
+#include "r2_types.h"
+
+/**
+ * @brief A chunker splits a stream into content-defined chunks for deduplication (FastCDC). A boundary is placed 
+ * after a byte when a Gear rolling hash of the bytes before it has its high bits set to 0, so boundaries depend on the
+ * content and not on offsets, and inserting or deleting bytes only changes the chunks around the edit. The stream is 
+ * fed one buffer at a time and the chunks don't depend on how it's split into buffers.
+ */
+struct r2_chunker{
+        r2_uint64 min;/*minimum length of a chunk*/
+        r2_uint64 avg;/*expected length of a chunk*/
+        r2_uint64 max;/*maximum length of a chunk*/
+        r2_uint64 mask_s;/*mask used before avg bytes, it has more bits so boundaries are less likely*/
+        r2_uint64 mask_l;/*mask used after avg bytes, it has fewer bits so boundaries are more likely*/
+        r2_uint64 gear[256];/*random value of every byte*/
+        r2_uint64 hash;/*Gear hash of the current chunk*/
+        r2_uint64 pos;/*number of bytes of the current chunk fed so far*/
+        r2_uint64 offset;/*offset of the current chunk in the stream*/
+        r2_uint64 lanes[4];/*fingerprint state of the current chunk*/
+        r2_uint64 word;/*bytes of the current chunk that don't fill a word yet*/
+};
+
+struct r2_chunk{
+        r2_uint64 offset;/*offset of the chunk in the stream*/
+        r2_uint64 len;/*length of the chunk*/
+        r2_uint64 fingerprint;/*64-bit hash of the bytes of the chunk*/
+};
+
+struct r2_chunker* r2_create_chunker(r2_uint64, r2_uint64, r2_uint64);
+struct r2_chunker* r2_destroy_chunker(struct r2_chunker *);
+void r2_chunker_reset(struct r2_chunker *);
+r2_uint64 r2_chunker_feed(struct r2_chunker *, const r2_c *, r2_uint64, r2_act, void *);
+r2_uint64 r2_chunker_finish(struct r2_chunker *, r2_act, void *);
+#endif
\ No newline at end of file
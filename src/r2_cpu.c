@@ -0,0 +1,57 @@
+#include "r2_cpu.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        #define R2_CPU_X86
+#elif defined(_MSC_VER) && defined(_M_X64)
+        #include <intrin.h>
+        #include <immintrin.h>
+        #define R2_CPU_X86
+#endif
+static r2_uint16 simd_cpu = R2_CPU_AVX512 + 1;/*best instruction set supported, detected on first use*/
+static r2_uint16 simd_detect();
+
+/**
+ * @brief               Returns the best instruction set supported by the processor and the operating system.
+ *
+ * @return r2_uint16    R2_CPU_SCALAR, R2_CPU_SSE2, R2_CPU_AVX2 or R2_CPU_AVX512.
+ */
+r2_uint16 r2_cpu_simd()
+{
+        if(simd_cpu > R2_CPU_AVX512)
+                simd_cpu = simd_detect();
+        return simd_cpu;
+}
+
+/**
+ * @brief               Queries the processor.
+ *
+ * @return r2_uint16    R2_CPU_SCALAR, R2_CPU_SSE2, R2_CPU_AVX2 or R2_CPU_AVX512.
+ */
+static r2_uint16 simd_detect()
+{
+        r2_uint16 level = R2_CPU_SCALAR;
+        #if defined(R2_CPU_X86) && defined(_MSC_VER)
+                int info[4];
+                level = R2_CPU_SSE2;/*every x64 processor has SSE2*/
+                __cpuid(info, 0);
+                r2_int64 max = info[0];
+                __cpuid(info, 1);
+                /*The operating system must save the AVX registers on a context switch.*/
+                if(max >= 7 && (info[2] & (1 << 27)) != 0){
+                        unsigned __int64 xcr = _xgetbv(0);
+                        __cpuidex(info, 7, 0);
+                        if((xcr & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0)
+                                level = R2_CPU_AVX2;
+                        if((xcr & 0xe6) == 0xe6 && (info[1] & (1 << 16)) != 0 && level == R2_CPU_AVX2)
+                                level = R2_CPU_AVX512;
+                }
+        #elif defined(R2_CPU_X86)
+                __builtin_cpu_init();
+                if(__builtin_cpu_supports("sse2"))
+                        level = R2_CPU_SSE2;
+                if(__builtin_cpu_supports("avx2") && level == R2_CPU_SSE2)
+                        level = R2_CPU_AVX2;
+                if(__builtin_cpu_supports("avx512f") && level == R2_CPU_AVX2)
+                        level = R2_CPU_AVX512;
+        #endif
+        return level;
+}
@@ -0,0 +1,15 @@
+#ifndef R2_CPU_H_
+#define R2_CPU_H_
+#include "r2_types.h"
+#define R2_CPU_SCALAR 0
+#define R2_CPU_SSE2   1
+#define R2_CPU_AVX2   2
+#define R2_CPU_AVX512 3
+
+/**
+ * @brief Runtime detection of the x86 instruction sets used by the SIMD code of the library. An instruction set is only 
+ * reported when both the processor supports it and the operating system saves its registers on a context switch. 
+ * The processor is queried on the first call and the answer is reused afterwards. Other platforms report R2_CPU_SCALAR.
+ */
+r2_uint16 r2_cpu_simd();
+#endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef R2_FMINDEX_H_
+#define R2_FMINDEX_H_
+#include "r2_types.h"
+
+/**
+ * @brief A bitvector that counts the ones before any position in constant time.
+ *
+ */
+struct r2_bitrank{
+        r2_uint64 n;/*number of bits*/
+        r2_uint64 *bits;/*bits, 64 per word*/
+        r2_uint64 *ranks;/*number of ones before every block of 512 bits*/
+};
+
+/**
+ * @brief An FM-index is a compressed full-text index. It stores the Burrows-Wheeler transform (BWT) of the text,
+ * the byte before every suffix in suffix array order, in a wavelet matrix so the number of times a byte occurs
+ * before any row can be counted quickly. Counting the occurrences of a pattern then takes O(m log sigma) time by
+ * extending the pattern one byte at a time from the right (backward search). The text isn't kept, every sample-th
+ * suffix position is stored to locate occurrences and every sample-th row of a text position to extract text.
+ *
+ */
+struct r2_fmindex{
+        r2_uint64 n;/*length of text*/
+        r2_uint64 primary;/*row of the whole text, its BWT byte is the sentinel and isn't stored*/
+        r2_uint64 sample;/*sampling rate of suffix positions*/
+        r2_uint16 sigma;/*number of distinct bytes*/
+        r2_uint16 levels;/*number of bits of a code*/
+        r2_uc code[256];/*code of every byte, codes keep the order of bytes*/
+        r2_uc byte[256];/*byte of every code*/
+        r2_uint64 C[257];/*first row of the suffixes starting with every code*/
+        r2_uint64 start[256];/*start of every code in the last level of the wavelet matrix*/
+        r2_uint64 zeros[8];/*number of zeros in every level*/
+        struct r2_bitrank wm[8];/*wavelet matrix of the BWT without the sentinel*/
+        struct r2_bitrank marked;/*rows whose suffix position is sampled*/
+        r2_uint64 *sa;/*sampled suffix positions in row order*/
+        r2_uint64 *isa;/*isa[k] is the row of the suffix at k*sample*/
+};
+
+struct r2_fmindex* r2_create_fmindex(const r2_c *, r2_uint64, r2_uint64);
+struct r2_fmindex* r2_destroy_fmindex(struct r2_fmindex *);
+r2_uint64 r2_fmindex_count(const struct r2_fmindex *, const r2_c *, r2_uint64);
+r2_uint64 r2_fmindex_locate(const struct r2_fmindex *, const r2_c *, r2_uint64, r2_uint64 *, r2_uint64);
+r2_uint16 r2_fmindex_extract(const struct r2_fmindex *, r2_uint64, r2_uint64, r2_c *);
+r2_uint64 r2_fmindex_size(const struct r2_fmindex *);
+#endif
\ No newline at end of file
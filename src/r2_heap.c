@@ -1,13 +1,41 @@
 #include "r2_heap.h"
+#include "r2_cpu.h"
 #include <stdlib.h>
 #include <assert.h>
+#include <string.h>
 #define  PQSIZE 16
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        #include <immintrin.h>
+        #define R2_HEAP_SIMD
+        #define R2_AVX2 __attribute__((target("avx2")))
+        #define R2_SSE2 __attribute__((target("sse2")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+        #include <immintrin.h>
+        #define R2_HEAP_SIMD
+        #define R2_AVX2
+        #define R2_SSE2
+#endif
 
 /********************File scope functions************************/
 static void r2_bubble_down(struct r2_pq *, r2_uint64);
 static void r2_bubble_up(struct r2_pq *, r2_uint64);
 static void r2_free_data(r2_fd, struct r2_locator *);
 static r2_uint16  r2_pq_resize(struct r2_pq *, r2_uint64);
+static r2_uint16 r2_mmheap_resize(struct r2_mmheap *, r2_uint64);
+static r2_uint16 r2_mmheap_minlevel(r2_uint64);
+static r2_uint16 r2_mmheap_before(struct r2_mmheap *, r2_uint64, r2_uint64, r2_uint16);
+static void r2_mmheap_swap(struct r2_mmheap *, r2_uint64, r2_uint64);
+static void r2_mmheap_bubble_up(struct r2_mmheap *, r2_uint64);
+static void r2_mmheap_trickle_down(struct r2_mmheap *, r2_uint64);
+static r2_uint64 r2_mmheap_maxpos(const struct r2_mmheap *);
+static r2_uint16 r2_topk_worse(const struct r2_topk *, const void *, const void *);
+static void r2_topk_bubble_up(struct r2_topk *, void **, r2_uint64);
+static void r2_topk_bubble_down(const struct r2_topk *, void **, r2_uint64, r2_uint64);
+#if defined(R2_HEAP_SIMD)
+R2_AVX2 static r2_uint64 avx2_filter_dbl(struct r2_topk *, r2_dbl *, r2_uint64, r2_uint64);
+R2_SSE2 static r2_uint64 sse2_filter_dbl(struct r2_topk *, r2_dbl *, r2_uint64, r2_uint64);
+R2_AVX2 static r2_uint64 avx2_filter_int64(struct r2_topk *, r2_int64 *, r2_uint64, r2_uint64);
+#endif
 /********************File scope functions************************/
 
 /**
@@ -257,4 +285,677 @@ static void r2_free_data(r2_fd fd, struct r2_locator *l)
 void r2_pq_adjust(struct r2_pq *pq, struct r2_locator *loc, r2_uint16 adjust)
 {
         adjust == 0? r2_bubble_up(pq, loc->pos) : r2_bubble_down(pq, loc->pos);
+}
+
+/**
+ * @brief                       Creates an empty extendable min-max heap.
+ * 
+ * @param hsize                 Heap size.
+ * @param kcmp                  A comparison callback function.
+ * @param fd                    A callback function that frees memory used by data.
+ * @param kcpy                  A callback function to copy key.
+ * @return struct r2_mmheap*    Returns min-max heap, else NULL.
+ */
+struct r2_mmheap* r2_create_mmheap(r2_uint64 hsize, r2_cmp kcmp, r2_fd fd, r2_cpy kcpy)
+{
+        assert(kcmp != NULL);
+        hsize = (PQSIZE > hsize? PQSIZE : hsize);
+        struct r2_mmheap *heap = malloc(sizeof(struct r2_mmheap));
+        if(heap != NULL){
+                /*We add 1 because heap->data[0] is never used.*/
+                heap->data   = calloc((hsize + 1), sizeof(void *));
+                heap->fd     = fd;
+                heap->hsize  = hsize;
+                heap->kcmp   = kcmp;
+                heap->cpy    = kcpy;
+                heap->ncount = 0;
+                #ifdef PROFILE_HEAP
+                        heap->ncomp = 0;
+                #endif
+                if(heap->data == NULL){
+                        free(heap);
+                        heap = NULL;
+                }
+        }
+        return heap;
+}
+
+/**
+ * @brief                       Destroys min-max heap.
+ * 
+ * @param heap                  Min-max heap.
+ * @return struct r2_mmheap*    Returns NULL whenever min-max heap is destroyed properly.
+ */
+struct r2_mmheap* r2_destroy_mmheap(struct r2_mmheap *heap)
+{
+        if(heap->fd != NULL)
+                for(r2_uint64 i = 1; i <= heap->ncount; ++i)
+                        heap->fd(heap->data[i]);
+
+        free(heap->data);
+        free(heap);
+        return NULL;
+}
+
+/**
+ * @brief               Checks whether a min-max heap is empty.
+ * 
+ * @param heap          Min-max heap.
+ * @return r2_uint16    Returns TRUE when min-max heap is empty, else FALSE.
+ */
+r2_uint16 r2_mmheap_empty(const struct r2_mmheap *heap)
+{
+        return heap->ncount == 0;
+}
+
+/**
+ * @brief               Returns the smallest element.
+ * 
+ * @param heap          Min-max heap.
+ * @return void*        Returns smallest element, else NULL when heap is empty.
+ */
+void* r2_mmheap_min(const struct r2_mmheap *heap)
+{
+        return heap->ncount == 0? NULL : heap->data[1];
+}
+
+/**
+ * @brief               Returns the largest element.
+ * 
+ * @param heap          Min-max heap.
+ * @return void*        Returns largest element, else NULL when heap is empty.
+ */
+void* r2_mmheap_max(const struct r2_mmheap *heap)
+{
+        return heap->ncount == 0? NULL : heap->data[r2_mmheap_maxpos(heap)];
+}
+
+/**
+ * @brief               Inserts an element in the min-max heap.
+ * 
+ * @param heap          Min-max heap.
+ * @param data          Data.
+ * @return r2_uint16    Returns TRUE whenever the element was inserted, else FALSE.
+ */
+r2_uint16 r2_mmheap_insert(struct r2_mmheap *heap, void *data)
+{
+        assert(data != NULL);
+        r2_uint16 RESIZE = TRUE;
+        #ifdef PROFILE_HEAP
+                heap->ncomp = 0;
+        #endif
+        if(heap->ncount == heap->hsize)
+                RESIZE = r2_mmheap_resize(heap, heap->hsize * 2);
+
+        if(RESIZE == TRUE){
+                ++heap->ncount;
+                heap->data[heap->ncount] = data;
+                r2_mmheap_bubble_up(heap, heap->ncount);
+        }
+        return RESIZE;
+}
+
+/**
+ * @brief               Removes the smallest element.
+ * 
+ * @param heap          Min-max heap.
+ * @return r2_uint16    Returns TRUE whenever the element was deleted properly, else FALSE.
+ */
+r2_uint16 r2_mmheap_remove_min(struct r2_mmheap *heap)
+{
+        r2_uint16 SUCCESS = FALSE;
+        #ifdef PROFILE_HEAP
+                heap->ncomp = 0;
+        #endif
+        if(r2_mmheap_empty(heap) != TRUE){
+                if(heap->fd != NULL)
+                        heap->fd(heap->data[1]);
+                heap->data[1] = heap->data[heap->ncount];
+                heap->data[heap->ncount] = NULL;
+                --heap->ncount;
+                r2_mmheap_trickle_down(heap, 1);
+                if(heap->ncount > PQSIZE && heap->ncount <= (heap->hsize / 4))
+                        r2_mmheap_resize(heap, heap->hsize / 2);
+                SUCCESS = TRUE;
+        }
+        return SUCCESS;
+}
+
+/**
+ * @brief               Removes the largest element.
+ * 
+ * @param heap          Min-max heap.
+ * @return r2_uint16    Returns TRUE whenever the element was deleted properly, else FALSE.
+ */
+r2_uint16 r2_mmheap_remove_max(struct r2_mmheap *heap)
+{
+        r2_uint16 SUCCESS = FALSE;
+        #ifdef PROFILE_HEAP
+                heap->ncomp = 0;
+        #endif
+        if(r2_mmheap_empty(heap) != TRUE){
+                r2_uint64 pos = r2_mmheap_maxpos(heap);
+                if(heap->fd != NULL)
+                        heap->fd(heap->data[pos]);
+                heap->data[pos] = heap->data[heap->ncount];
+                heap->data[heap->ncount] = NULL;
+                --heap->ncount;
+                if(pos <= heap->ncount)
+                        r2_mmheap_trickle_down(heap, pos);
+                if(heap->ncount > PQSIZE && heap->ncount <= (heap->hsize / 4))
+                        r2_mmheap_resize(heap, heap->hsize / 2);
+                SUCCESS = TRUE;
+        }
+        return SUCCESS;
+}
+
+/**
+ * @brief               Returns the position of the largest element.
+ *                      The largest element is either the root or one of its children.
+ * 
+ * @param heap          Min-max heap.
+ * @return r2_uint64    Position of largest element.
+ */
+static r2_uint64 r2_mmheap_maxpos(const struct r2_mmheap *heap)
+{
+        if(heap->ncount <= 2)
+                return heap->ncount;
+
+        return heap->kcmp(heap->data[2], heap->data[3]) >= 0? 2 : 3;
+}
+
+/**
+ * @brief               Checks whether position belongs to a min level.
+ * 
+ * @param pos           Position.
+ * @return r2_uint16    Returns TRUE when pos is on a min level, else FALSE.
+ */
+static r2_uint16 r2_mmheap_minlevel(r2_uint64 pos)
+{
+        r2_uint16 level = 0;
+        while(pos > 1){
+                pos >>= 1;
+                ++level;
+        }
+        return (level & 1) == 0;
+}
+
+/**
+ * @brief               Checks whether the element at a must be placed above the element at b.
+ * 
+ * @param heap          Min-max heap.
+ * @param a             Position of first element.
+ * @param b             Position of second element.
+ * @param min           TRUE when comparing on a min level, else FALSE.
+ * @return r2_uint16    Returns TRUE when a is placed above b, else FALSE.
+ */
+static r2_uint16 r2_mmheap_before(struct r2_mmheap *heap, r2_uint64 a, r2_uint64 b, r2_uint16 min)
+{
+        #ifdef PROFILE_HEAP
+                ++heap->ncomp;
+        #endif
+        r2_int16 result = heap->kcmp(heap->data[a], heap->data[b]);
+        return min == TRUE? result < 0 : result > 0;
+}
+
+/**
+ * @brief               Swaps two elements in the min-max heap.
+ * 
+ * @param heap          Min-max heap.
+ * @param a             Position of first element.
+ * @param b             Position of second element.
+ */
+static void r2_mmheap_swap(struct r2_mmheap *heap, r2_uint64 a, r2_uint64 b)
+{
+        void *temp    = heap->data[a];
+        heap->data[a] = heap->data[b];
+        heap->data[b] = temp;
+}
+
+/**
+ * @brief               Repairs a min-max heap that has been violated due to insertion.
+ * 
+ * @param heap          Min-max heap.
+ * @param root          Root.
+ */
+static void r2_mmheap_bubble_up(struct r2_mmheap *heap, r2_uint64 root)
+{
+        if(root == 1)
+                return;
+
+        r2_uint16 min = r2_mmheap_minlevel(root);
+        /**
+         * If the new element belongs on the other kind of level we swap it with its parent
+         * and continue bubbling up on the parent's levels.
+         */
+        if(r2_mmheap_before(heap, root / 2, root, min) == TRUE){
+                r2_mmheap_swap(heap, root, root / 2);
+                root = root / 2;
+                min  = !min;
+        }
+
+        /*Move up two levels at a time comparing against grandparents.*/
+        while(root >= 4 && r2_mmheap_before(heap, root, root / 4, min) == TRUE){
+                r2_mmheap_swap(heap, root, root / 4);
+                root = root / 4;
+        }
+}
+
+/**
+ * @brief               Repairs a min-max heap after deletion.
+ * 
+ * @param heap          Min-max heap.
+ * @param root          Root.
+ */
+static void r2_mmheap_trickle_down(struct r2_mmheap *heap, r2_uint64 root)
+{
+        r2_uint16 min   = r2_mmheap_minlevel(root);
+        r2_uint64 best  = 0;/*smallest or largest among children and grandchildren*/
+        r2_uint64 first = 0;
+        r2_uint64 last  = 0;
+        while(2 * root <= heap->ncount){
+                best = 2 * root;
+                if(best + 1 <= heap->ncount && r2_mmheap_before(heap, best + 1, best, min) == TRUE)
+                        best = best + 1;
+
+                first = 4 * root;
+                last  = 4 * root + 3;
+                for(r2_uint64 i = first; i <= last && i <= heap->ncount; ++i)
+                        if(r2_mmheap_before(heap, i, best, min) == TRUE)
+                                best = i;
+
+                if(r2_mmheap_before(heap, best, root, min) != TRUE)
+                        break;
+
+                r2_mmheap_swap(heap, best, root);
+                /*A child can't have descendants that are out of order so we are done.*/
+                if(best < first)
+                        break;
+
+                /*The element we moved down may belong on the parent's level instead.*/
+                if(r2_mmheap_before(heap, best / 2, best, min) == TRUE)
+                        r2_mmheap_swap(heap, best, best / 2);
+                root = best;
+        }
+}
+
+/**
+ * @brief               Resize min-max heap.
+ * 
+ * @param heap          Min-max heap.
+ * @param size          Size.
+ * @return r2_uint16    Returns TRUE whenever resize is successful, else FALSE.
+ */
+static r2_uint16 r2_mmheap_resize(struct r2_mmheap *heap, r2_uint64 size)
+{
+        r2_uint16 RESIZE = FALSE;
+        void **data = realloc(heap->data, (size + 1) * sizeof(void *));
+        if(data != NULL){
+                RESIZE = TRUE;
+                heap->data  = data;
+                heap->hsize = size;
+        }
+        return RESIZE;
+}
+
+/**
+ * @brief                       Creates an empty top-k.
+ * 
+ * @param k                     Number of elements to keep.
+ * @param type                  0 keeps the k smallest elements or 1 keeps the k largest elements.
+ * @param kcmp                  A comparison callback function.
+ * @param fd                    A callback function that frees memory used by data.
+ * @param kcpy                  A callback function to copy key.
+ * @return struct r2_topk*      Returns top-k, else NULL.
+ */
+struct r2_topk* r2_create_topk(r2_uint64 k, r2_uint16 type, r2_cmp kcmp, r2_fd fd, r2_cpy kcpy)
+{
+        assert(type == 0 || type == 1);
+        assert(kcmp != NULL && k > 0);
+        struct r2_topk *topk = malloc(sizeof(struct r2_topk));
+        if(topk != NULL){
+                /*We add 1 because topk->data[0] is never used.*/
+                topk->data   = calloc((k + 1), sizeof(void *));
+                topk->type   = type;
+                topk->k      = k;
+                topk->ncount = 0;
+                topk->kcmp   = kcmp;
+                topk->fd     = fd;
+                topk->cpy    = kcpy;
+                #ifdef PROFILE_HEAP
+                        topk->nreject = 0;
+                #endif
+                if(topk->data == NULL){
+                        free(topk);
+                        topk = NULL;
+                }
+        }
+        return topk;
+}
+
+/**
+ * @brief                       Destroys top-k.
+ * 
+ * @param topk                  Top-k.
+ * @return struct r2_topk*      Returns NULL whenever top-k is destroyed properly.
+ */
+struct r2_topk* r2_destroy_topk(struct r2_topk *topk)
+{
+        r2_topk_reset(topk);
+        free(topk->data);
+        free(topk);
+        return NULL;
+}
+
+/**
+ * @brief               Removes every element from the top-k so it can be reused for another stream.
+ * 
+ * @param topk          Top-k.
+ */
+void r2_topk_reset(struct r2_topk *topk)
+{
+        if(topk->fd != NULL)
+                for(r2_uint64 i = 1; i <= topk->ncount; ++i)
+                        topk->fd(topk->data[i]);
+
+        topk->ncount = 0;
+}
+
+/**
+ * @brief               Returns the threshold i.e. the worst element we're keeping.
+ * 
+ * @param topk          Top-k.
+ * @return void*        Returns threshold, else NULL when top-k is empty.
+ */
+void* r2_topk_threshold(const struct r2_topk *topk)
+{
+        return topk->ncount == 0? NULL : topk->data[1];
+}
+
+/**
+ * @brief               Pushes an element from the stream into the top-k.
+ *                      
+ *                      When the top-k is full the element is only kept if it beats the threshold. 
+ *                      A rejected element is left untouched and still belongs to the caller, the 
+ *                      element that it replaces is released with fd.
+ * 
+ * @param topk          Top-k.
+ * @param data          Data.
+ * @return r2_uint16    Returns TRUE when the element was kept, else FALSE.
+ */
+r2_uint16 r2_topk_push(struct r2_topk *topk, void *data)
+{
+        assert(data != NULL);
+        if(topk->ncount < topk->k){
+                ++topk->ncount;
+                topk->data[topk->ncount] = data;
+                r2_topk_bubble_up(topk, topk->data, topk->ncount);
+                return TRUE;
+        }
+
+        /*Fast path, the element doesn't beat the threshold.*/
+        if(r2_topk_worse(topk, topk->data[1], data) != TRUE){
+                #ifdef PROFILE_HEAP
+                        ++topk->nreject;
+                #endif
+                return FALSE;
+        }
+
+        if(topk->fd != NULL)
+                topk->fd(topk->data[1]);
+        topk->data[1] = data;
+        r2_topk_bubble_down(topk, topk->data, 1, topk->ncount);
+        return TRUE;
+}
+
+/**
+ * @brief               Pushes every element of an array into the top-k.
+ *                      The top-k stores pointers into the array.
+ * 
+ * @param topk          Top-k.
+ * @param arr           Array.
+ * @param as            Array size.
+ * @param es            Element size.
+ */
+void r2_topk_push_many(struct r2_topk *topk, void *arr, r2_uint64 as, r2_uint64 es)
+{
+        char *seq = arr;
+        for(r2_uint64 i = 0; i < as; ++i)
+                r2_topk_push(topk, &seq[i*es]);
+}
+
+/**
+ * @brief               Pushes an array of doubles into the top-k.
+ *                      
+ *                      The keys are compared against the threshold several at a time and only 
+ *                      the keys that beat it are pushed. The top-k stores pointers into keys so 
+ *                      keys must outlive the top-k and fd must be NULL. kcmp must order doubles naturally.
+ * 
+ * @param topk          Top-k.
+ * @param keys          Keys.
+ * @param as            Array size.
+ */
+void r2_topk_push_dbl(struct r2_topk *topk, r2_dbl *keys, r2_uint64 as)
+{
+        assert(topk->fd == NULL);
+        r2_uint64 i = 0;
+        for(;i < as && topk->ncount < topk->k; ++i)
+                r2_topk_push(topk, &keys[i]);
+
+        if(i == as)
+                return;
+
+        #if defined(R2_HEAP_SIMD)
+                r2_uint16 cpu = r2_cpu_simd();
+                if(cpu >= R2_CPU_AVX2)
+                        i = avx2_filter_dbl(topk, keys, i, as);
+                else if(cpu == R2_CPU_SSE2)
+                        i = sse2_filter_dbl(topk, keys, i, as);
+        #endif
+        r2_dbl t = *(r2_dbl *)topk->data[1];/*threshold*/
+        for(;i < as; ++i){
+                if(topk->type == 1? keys[i] > t : keys[i] < t){
+                        r2_topk_push(topk, &keys[i]);
+                        t = *(r2_dbl *)topk->data[1];
+                }
+        }
+}
+
+/**
+ * @brief               Pushes an array of 64 bit integers into the top-k.
+ *                      
+ *                      The keys are compared against the threshold several at a time and only 
+ *                      the keys that beat it are pushed. The top-k stores pointers into keys so 
+ *                      keys must outlive the top-k and fd must be NULL. kcmp must order integers naturally.
+ * 
+ * @param topk          Top-k.
+ * @param keys          Keys.
+ * @param as            Array size.
+ */
+void r2_topk_push_int64(struct r2_topk *topk, r2_int64 *keys, r2_uint64 as)
+{
+        assert(topk->fd == NULL);
+        r2_uint64 i = 0;
+        for(;i < as && topk->ncount < topk->k; ++i)
+                r2_topk_push(topk, &keys[i]);
+
+        if(i == as)
+                return;
+
+        #if defined(R2_HEAP_SIMD)
+                if(r2_cpu_simd() >= R2_CPU_AVX2)
+                        i = avx2_filter_int64(topk, keys, i, as);
+        #endif
+        r2_int64 t = *(r2_int64 *)topk->data[1];/*threshold*/
+        for(;i < as; ++i){
+                if(topk->type == 1? keys[i] > t : keys[i] < t){
+                        r2_topk_push(topk, &keys[i]);
+                        t = *(r2_int64 *)topk->data[1];
+                }
+        }
+}
+
+#if defined(R2_HEAP_SIMD)
+/**
+ * @brief               Compares four doubles at a time against the threshold and pushes the ones that beat it.
+ *
+ * @param topk          Top-k, it must be full.
+ * @param keys          Keys.
+ * @param i             Position of the first key.
+ * @param as            Array size.
+ * @return r2_uint64    Position of the first key that wasn't looked at.
+ */
+R2_AVX2 static r2_uint64 avx2_filter_dbl(struct r2_topk *topk, r2_dbl *keys, r2_uint64 i, r2_uint64 as)
+{
+        r2_dbl t = *(r2_dbl *)topk->data[1];
+        r2_uint16 mask = 0;
+        for(;i + 4 <= as; i += 4){
+                __m256d v  = _mm256_loadu_pd(&keys[i]);
+                __m256d tv = _mm256_set1_pd(t);
+                mask = _mm256_movemask_pd(topk->type == 1? _mm256_cmp_pd(v, tv, _CMP_GT_OQ) : _mm256_cmp_pd(v, tv, _CMP_LT_OQ));
+                if(mask == 0)
+                        continue;
+                for(r2_uint16 j = 0; j < 4; ++j)
+                        if((mask >> j) & 1)
+                                r2_topk_push(topk, &keys[i+j]);
+                t = *(r2_dbl *)topk->data[1];
+        }
+        return i;
+}
+
+/**
+ * @brief               Compares two doubles at a time against the threshold and pushes the ones that beat it.
+ *
+ * @param topk          Top-k, it must be full.
+ * @param keys          Keys.
+ * @param i             Position of the first key.
+ * @param as            Array size.
+ * @return r2_uint64    Position of the first key that wasn't looked at.
+ */
+R2_SSE2 static r2_uint64 sse2_filter_dbl(struct r2_topk *topk, r2_dbl *keys, r2_uint64 i, r2_uint64 as)
+{
+        r2_dbl t = *(r2_dbl *)topk->data[1];
+        r2_uint16 mask = 0;
+        for(;i + 2 <= as; i += 2){
+                __m128d v  = _mm_loadu_pd(&keys[i]);
+                __m128d tv = _mm_set1_pd(t);
+                mask = _mm_movemask_pd(topk->type == 1? _mm_cmpgt_pd(v, tv) : _mm_cmplt_pd(v, tv));
+                if(mask == 0)
+                        continue;
+                for(r2_uint16 j = 0; j < 2; ++j)
+                        if((mask >> j) & 1)
+                                r2_topk_push(topk, &keys[i+j]);
+                t = *(r2_dbl *)topk->data[1];
+        }
+        return i;
+}
+
+/**
+ * @brief               Compares four 64 bit integers at a time against the threshold and pushes the ones that beat it.
+ *
+ * @param topk          Top-k, it must be full.
+ * @param keys          Keys.
+ * @param i             Position of the first key.
+ * @param as            Array size.
+ * @return r2_uint64    Position of the first key that wasn't looked at.
+ */
+R2_AVX2 static r2_uint64 avx2_filter_int64(struct r2_topk *topk, r2_int64 *keys, r2_uint64 i, r2_uint64 as)
+{
+        r2_int64 t = *(r2_int64 *)topk->data[1];
+        r2_uint16 mask = 0;
+        for(;i + 4 <= as; i += 4){
+                __m256i v  = _mm256_loadu_si256((const __m256i *)&keys[i]);
+                __m256i tv = _mm256_set1_epi64x(t);
+                __m256i gt = topk->type == 1? _mm256_cmpgt_epi64(v, tv) : _mm256_cmpgt_epi64(tv, v);
+                mask = _mm256_movemask_pd(_mm256_castsi256_pd(gt));
+                if(mask == 0)
+                        continue;
+                for(r2_uint16 j = 0; j < 4; ++j)
+                        if((mask >> j) & 1)
+                                r2_topk_push(topk, &keys[i+j]);
+                t = *(r2_int64 *)topk->data[1];
+        }
+        return i;
+}
+#endif
+
+/**
+ * @brief               Returns the elements of the top-k ordered from best to worst.
+ *                      N.B Caller is responsible for freeing memory. 
+ * 
+ * @param topk          Top-k.
+ * @return void**       Returns an array of topk->ncount elements, else NULL.
+ */
+void** r2_topk_sorted(const struct r2_topk *topk)
+{
+        void **data = malloc((topk->ncount + 1) * sizeof(void *));
+        void **sorted = NULL;
+        if(data != NULL){
+                memcpy(data, topk->data, (topk->ncount + 1) * sizeof(void *));
+                /*Repeatedly moving the worst element to the end leaves the best element at the front.*/
+                for(r2_uint64 end = topk->ncount; end > 1; --end){
+                        void *temp = data[1];
+                        data[1]    = data[end];
+                        data[end]  = temp;
+                        r2_topk_bubble_down(topk, data, 1, end - 1);
+                }
+                sorted = memmove(data, &data[1], topk->ncount * sizeof(void *));
+        }
+        return sorted;
+}
+
+/**
+ * @brief               Checks whether a is worse than b.
+ * 
+ * @param topk          Top-k.
+ * @param a             First element.
+ * @param b             Second element.
+ * @return r2_uint16    Returns TRUE when a is worse than b, else FALSE.
+ */
+static r2_uint16 r2_topk_worse(const struct r2_topk *topk, const void *a, const void *b)
+{
+        r2_int16 result = topk->kcmp(a, b);
+        return topk->type == 1? result < 0 : result > 0;
+}
+
+/**
+ * @brief               Repairs the top-k heap after insertion.
+ * 
+ * @param topk          Top-k.
+ * @param data          Heap.
+ * @param root          Root.
+ */
+static void r2_topk_bubble_up(struct r2_topk *topk, void **data, r2_uint64 root)
+{
+        void *temp = data[root];
+        while(root > 1 && r2_topk_worse(topk, temp, data[root / 2]) == TRUE){
+                data[root] = data[root / 2];
+                root = root / 2;
+        }
+        data[root] = temp;
+}
+
+/**
+ * @brief               Repairs the top-k heap after the root was replaced.
+ * 
+ * @param topk          Top-k.
+ * @param data          Heap.
+ * @param root          Root.
+ * @param end           Last position in the heap.
+ */
+static void r2_topk_bubble_down(const struct r2_topk *topk, void **data, r2_uint64 root, r2_uint64 end)
+{
+        void *temp = data[root];
+        r2_uint64 child = 0;
+        while(2 * root <= end){
+                child = 2 * root;
+                if(child + 1 <= end && r2_topk_worse(topk, data[child + 1], data[child]) == TRUE)
+                        child = child + 1;
+
+                if(r2_topk_worse(topk, data[child], temp) != TRUE)
+                        break;
+                data[root] = data[child];
+                root = child;
+        }
+        data[root] = temp;
 }
\ No newline at end of file
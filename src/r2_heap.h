@@ -74,4 +74,78 @@ struct r2_locator* r2_pq_first(struct r2_pq *);
 r2_uint16 r2_pq_remove(struct r2_pq *, struct r2_locator *);
 r2_uint16 r2_pq_empty(const struct r2_pq *);
 void r2_pq_adjust(struct r2_pq *, struct r2_locator *, r2_uint16);
+
+/**
+ * A min-max heap is a double ended priority queue. It gives us constant time access to both the smallest and 
+ * the largest element and logarithmic time removal of either end, while still being stored in a single array. 
+ * 
+ * A min-max heap is a complete binary tree, just like a binary heap, but the heap property alternates between levels. 
+ * Every node on an even level (the root is at level 0) is <= all of its descendants and every node on an odd level 
+ * is >= all of its descendants. The smallest element is therefore always at the root and the largest element is 
+ * always one of the root's children. 
+ * 
+ * Inserting an element places it at the end of the array and bubbles it up through either the min levels or 
+ * the max levels (moving two levels at a time) depending on how it compares with its parent. Removing the smallest or 
+ * largest element replaces it with the last element of the array and trickles that element down, again moving two levels 
+ * at a time while checking the children and grandchildren. 
+ * 
+ * See Min-Max Heaps and Generalized Priority Queues by Atkinson, Sack, Santoro and Strothotte.
+ * 
+ * Unlike r2_pq, kcmp follows the usual convention: it returns < 0, 0 or > 0 when a < b, a == b or a > b.
+ */
+struct r2_mmheap{
+        void **data;/*stores data, data[0] is never used*/
+        r2_uint64 ncount;/*current number of elements*/
+        r2_uint64 hsize;/*size of heap*/
+        r2_cmp kcmp;/*A callback comparison function*/
+        r2_fd  fd;/*A callback function frees memory used by data*/
+        r2_cpy cpy;/*A callback function to copy key*/
+        #ifdef PROFILE_HEAP
+                r2_uint64 ncomp;/*number of comparison*/
+        #endif
+};
+
+struct r2_mmheap* r2_create_mmheap(r2_uint64, r2_cmp, r2_fd, r2_cpy);
+struct r2_mmheap* r2_destroy_mmheap(struct r2_mmheap *);
+r2_uint16 r2_mmheap_insert(struct r2_mmheap *, void *);
+void* r2_mmheap_min(const struct r2_mmheap *);
+void* r2_mmheap_max(const struct r2_mmheap *);
+r2_uint16 r2_mmheap_remove_min(struct r2_mmheap *);
+r2_uint16 r2_mmheap_remove_max(struct r2_mmheap *);
+r2_uint16 r2_mmheap_empty(const struct r2_mmheap *);
+
+/**
+ * A top-k keeps the k best elements seen in a stream. It's a bounded binary heap of size k where the root is the 
+ * worst element that we're currently keeping, the threshold. A new element must beat the threshold to get in, 
+ * and when it does it replaces the root and is bubbled down, so a full top-k never grows and never allocates. 
+ * Most elements in a long stream lose against the threshold, so the common case is a single comparison and no heap operation. 
+ * 
+ * The typed batch functions (r2_topk_push_dbl, r2_topk_push_int64) filter an array of primitive keys against the threshold
+ * several keys at a time using SSE2/AVX2 when they're available and only push the survivors.
+ * 
+ * Similar to r2_pq, type selects the order: 0 keeps the k smallest elements and 1 keeps the k largest elements.
+ * kcmp follows the usual convention: it returns < 0, 0 or > 0 when a < b, a == b or a > b.
+ */
+struct r2_topk{
+        void **data;/*stores data, data[0] is never used*/
+        r2_uint16 type;/*0 keeps the k smallest, 1 keeps the k largest*/
+        r2_uint64 k;/*number of elements to keep*/
+        r2_uint64 ncount;/*current number of elements*/
+        r2_cmp kcmp;/*A callback comparison function*/
+        r2_fd  fd;/*A callback function frees memory used by data*/
+        r2_cpy cpy;/*A callback function to copy key*/
+        #ifdef PROFILE_HEAP
+                r2_uint64 nreject;/*number of elements rejected by the threshold*/
+        #endif
+};
+
+struct r2_topk* r2_create_topk(r2_uint64, r2_uint16, r2_cmp, r2_fd, r2_cpy);
+struct r2_topk* r2_destroy_topk(struct r2_topk *);
+r2_uint16 r2_topk_push(struct r2_topk *, void *);
+void r2_topk_push_many(struct r2_topk *, void *, r2_uint64, r2_uint64);
+void r2_topk_push_dbl(struct r2_topk *, r2_dbl *, r2_uint64);
+void r2_topk_push_int64(struct r2_topk *, r2_int64 *, r2_uint64);
+void* r2_topk_threshold(const struct r2_topk *);
+void** r2_topk_sorted(const struct r2_topk *);
+void r2_topk_reset(struct r2_topk *);
 #endif
@@ -1,17 +1,206 @@
 #include "r2_sort.h"
+#include "r2_cpu.h"
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <limits.h>
+#if defined(_WIN32)
+        #include <windows.h>
+#else
+        #include <pthread.h>
+        #include <unistd.h>
+#endif
 #define CUT_OFF 32
+#define RADIX 256
+#define DIGITS 8
+#define PAR_CUT_OFF 8192
+#define PDQ_CUT_OFF 24
+#define PDQ_NINTHER 128
+#define PDQ_PARTIAL 8
+#define PDQ_BLOCK 64
+#define XBLOCK 65536
+#define XFANIN 500
+#define TIM_MIN_GALLOP 7
+#define TIM_MAX_RUNS 85
+#if defined(NDEBUG) && !defined(R2_SORT_NO_VERIFY)
+        #define R2_SORT_NO_VERIFY
+#endif
+#if defined(R2_SORT_STATS)
+        #define R2_MOVE(n) (moved += (n))
+#else
+        #define R2_MOVE(n)
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        #include <immintrin.h>
+        #define R2_SORT_SIMD
+        #define R2_AVX2   __attribute__((target("avx2,popcnt")))
+        #define R2_AVX512 __attribute__((target("avx512f,popcnt")))
+        #define R2_POPCNT(x) __builtin_popcount(x)
+#elif defined(_MSC_VER) && defined(_M_X64)
+        #include <intrin.h>
+        #include <immintrin.h>
+        #define R2_SORT_SIMD
+        #define R2_AVX2
+        #define R2_AVX512
+        #define R2_POPCNT(x) __popcnt(x)
+#endif
+
+/**
+ * @brief State shared by all the threads working on one parallel sort. 
+ * Threads are only started while there are idle workers, once every worker is busy 
+ * a task is performed by the thread that asked for it.
+ */
+struct r2_psort{
+        char *arr;/*array being sorted*/
+        char *aux;/*auxiliary array*/
+        r2_uint64 es;/*element size*/
+        r2_cmp cmp;/*comparison callback function*/
+        r2_uint64 grain;/*smallest number of elements that's worth handing to another thread*/
+        r2_uint64 idle;/*number of idle workers*/
+        #if defined(_WIN32)
+                SRWLOCK lock;
+        #else
+                pthread_mutex_t lock;
+        #endif
+};
+
+/**
+ * @brief A unit of work that's either performed by a new thread or by the caller.
+ */
+struct r2_ptask{
+        void (*fn)(struct r2_ptask *);/*work to be performed*/
+        struct r2_psort *ps;/*parallel sort*/
+        char *src;/*source array*/
+        char *dest;/*destination array*/
+        const char *pivot;/*pivot used to partition*/
+        r2_int64 lo;/*start of first range*/
+        r2_int64 hi;/*end of first range*/
+        r2_int64 lo2;/*start of second range*/
+        r2_int64 hi2;/*end of second range*/
+        r2_int64 out;/*where the output starts*/
+        r2_uint16 flag;/*task specific flag*/
+};
+
+/**
+ * @brief State used by pattern-defeating quicksort.
+ */
+struct r2_pdq{
+        char *arr;/*array being sorted*/
+        r2_uint64 es;/*element size*/
+        r2_cmp cmp;/*comparison callback function*/
+        char *pivot;/*copy of the pivot*/
+        char *tmp;/*temporary element*/
+};
+
+/**
+ * @brief A key extracted from a record and the position of the record.
+ */
+struct r2_kv{
+        r2_uint64 key;
+        r2_uint64 pos;
+};
+
+/**
+ * @brief A run waiting to be merged by timsort.
+ */
+struct r2_run{
+        r2_uint64 start;/*start of run*/
+        r2_uint64 len;/*length of run*/
+        r2_int64 power;/*power of the boundary between this run and the next one*/
+};
+
+/**
+ * @brief State used by timsort.
+ */
+struct r2_tim{
+        char *arr;/*array being sorted*/
+        r2_uint64 es;/*element size*/
+        r2_cmp cmp;/*comparison callback function*/
+        char *tmp;/*temporary buffer used by merges*/
+        r2_uint64 tsize;/*number of elements tmp can hold*/
+        r2_int64 gallop;/*number of consecutive wins before merges start galloping*/
+        char *key;/*temporary element*/
+        struct r2_run runs[TIM_MAX_RUNS];/*stack of pending runs*/
+        r2_uint64 nruns;/*number of pending runs*/
+};
+
+/**
+ * @brief State of the in-place merge sort.
+ */
+struct r2_imerge{
+        char *arr;/*first element of the sequence*/
+        r2_uint64 es;/*element size*/
+        r2_cmp cmp;/*comparison function*/
+        char *buf;/*buffer of about sqrt(n) elements*/
+        r2_uint64 cap;/*number of elements buf can hold*/
+};
+
+/**
+ * @brief A loser tree that merges k sorted runs.
+ */
+struct r2_ltree{
+        r2_uint64 k;/*number of runs*/
+        r2_uint64 *tree;/*tree[0] is the winner, tree[1...k-1] hold the loser of every match*/
+        const char **heads;/*next element of every run, NULL once the run is exhausted*/
+        r2_cmp cmp;/*NULL compares r2_int64 keys*/
+};
+
+/**
+ * @brief A sorted run of an external sort and its input buffer.
+ */
+struct r2_xrun{
+        FILE *fp;/*temporary file*/
+        char *buf;/*buffered records*/
+        r2_uint64 n;/*number of records in buf*/
+        r2_uint64 pos;/*position of next record in buf*/
+};
+
+/**
+ * @brief Describes an external sort. Records are read from the input and written to the output with read and write,
+ * runs are always stored as binary records.
+ */
+struct r2_xsort{
+        r2_uint64 es;/*record size*/
+        r2_uint64 mem;/*memory available for records*/
+        r2_cmp cmp;/*comparison callback function*/
+        void (*sort)(void *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);/*sorts a run in memory*/
+        r2_uint64 (*read)(struct r2_xsort *, FILE *, void *, r2_uint64);/*reads records from the input*/
+        r2_uint16 (*write)(FILE *, const void *, r2_uint64, r2_uint64);/*writes records to the output*/
+        r2_uint16 bad;/*TRUE when the input ends with a partial record or has a malformed token*/
+};
+
+/**
+ * @brief The thread performing a task. It's kept apart from the task because the task is read by the new thread.
+ */
+struct r2_pthread{
+        r2_uint16 spawned;/*TRUE when the task is performed by another thread*/
+        #if defined(_WIN32)
+                HANDLE thread;
+        #else
+                pthread_t thread;
+        #endif
+};
+
+static r2_uint64 nthreads = 0;/*number of threads used by parallel sorts, 0 means one per processor*/
+static r2_uint16 simd_max = R2_SORT_AVX512;/*best instruction set the SIMD sorts may use*/
+static r2_uint64 moved = 0;/*bytes moved by the sorts, only counted when built with R2_SORT_STATS*/
 
 static void swap(char *, char *, r2_uint64);
 static void cpy(void *, void *, r2_uint64);
+static void* mcpy(void *, const void *, r2_uint64);
+static void* mmove(void *, const void *, r2_uint64);
 static void merge(char *, char *, r2_uint64, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
 static void merge_sort(void *, void *, r2_uint64, r2_uint64 , r2_uint64 , r2_cmp );
 static void merge_sort_mod(void *, void*, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
 static void bmerge_sort(void *, void*, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
 static void bmerge_sort_mod(void *, void*, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
 static void is_sorted(void *, r2_uint64, r2_uint64, r2_uint64,r2_cmp);
+static void imerge_insertion_sort(struct r2_imerge *, r2_uint64, r2_uint64);
+static void imerge(struct r2_imerge *, r2_uint64, r2_uint64, r2_uint64);
+static r2_uint64 imerge_bound(struct r2_imerge *, r2_uint64, r2_uint64, const char *, r2_uint16);
+static void imerge_rotate(struct r2_imerge *, r2_uint64, r2_uint64, r2_uint64);
+static void imerge_swap(struct r2_imerge *, r2_uint64, r2_uint64, r2_uint64);
 static r2_int64 hoare(char*, r2_int64, r2_int64, r2_uint64, r2_cmp);
 static r2_int64 lomuto(char*, r2_uint64, r2_uint64, r2_int64, r2_cmp);
 static void quick_sort(void *, r2_int64, r2_int64, r2_uint64, r2_cmp);
@@ -19,6 +208,73 @@ static r2_int64 newell(char *, r2_int64, r2_int64, r2_int64, r2_cmp);
 static void bubble_up(char *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
 static void bubble_down(char *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
 static void quick_sort_mod(void *, r2_int64, r2_int64, r2_uint64, r2_cmp);
+static void radix_sort(r2_uint64 *, r2_uint64);
+static void pfork(struct r2_ptask *, struct r2_pthread *);
+static void pjoin(struct r2_ptask *, struct r2_pthread *);
+static void pmerge_sort(struct r2_ptask *);
+static void pmerge(struct r2_ptask *);
+static void pquick_sort(struct r2_ptask *);
+static void ppartition(struct r2_ptask *);
+static void pblock(struct r2_ptask *);
+static r2_int64 partition_block(char *, r2_int64, r2_int64, r2_uint64, const char *, r2_uint16, r2_cmp);
+static r2_int64 median_of_three(char *, r2_int64, r2_int64, r2_int64, r2_uint64, r2_cmp);
+static void pdq_sort(char *, r2_int64, r2_int64, r2_uint64, r2_cmp);
+static void pdq_loop(struct r2_pdq *, r2_int64, r2_int64, r2_int64, r2_uint16);
+static void pdq_insertion_sort(struct r2_pdq *, r2_int64, r2_int64, r2_uint16);
+static r2_uint16 pdq_partial_insertion_sort(struct r2_pdq *, r2_int64, r2_int64);
+static void pdq_sort2(struct r2_pdq *, r2_int64, r2_int64);
+static void pdq_sort3(struct r2_pdq *, r2_int64, r2_int64, r2_int64);
+static r2_int64 pdq_partition_left(struct r2_pdq *, r2_int64, r2_int64);
+static r2_int64 pdq_partition_right(struct r2_pdq *, r2_int64, r2_int64, r2_uint16 *);
+static void pdq_swap_offsets(struct r2_pdq *, r2_int64, r2_int64, const r2_uc *, const r2_uc *, r2_uint64, r2_uint16);
+static void multi_select(char *, r2_int64, r2_int64, r2_uint64, const r2_int64 *, r2_uint64, r2_uint64, r2_cmp);
+static r2_int16 str_cmp(const char *, const char *, r2_uint64);
+static void str_insertion_sort(char **, r2_uint64, r2_uint64);
+static void mkqs_sort(char **, r2_uc *, r2_uint64, r2_uint64, r2_uint16);
+static void msd_sort(char **, char **, r2_uc *, r2_uint64, r2_uint64);
+static void arg_sort(const char *, r2_uint64 *, r2_uint64 *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
+static void kv_radix_sort(struct r2_kv *, r2_uint64);
+static r2_uint64 tim_minrun(r2_uint64);
+static r2_uint64 tim_count_run(struct r2_tim *, r2_uint64, r2_uint64);
+static void tim_binary_sort(struct r2_tim *, r2_uint64, r2_uint64, r2_uint64);
+static r2_int64 tim_power(r2_uint64, r2_uint64, r2_uint64, r2_uint64);
+static r2_int64 tim_gallop_left(struct r2_tim *, const char *, const char *, r2_int64, r2_int64);
+static r2_int64 tim_gallop_right(struct r2_tim *, const char *, const char *, r2_int64, r2_int64);
+static void tim_reserve(struct r2_tim *, r2_uint64);
+static void tim_merge_at(struct r2_tim *, r2_uint64);
+static void tim_merge_lo(struct r2_tim *, char *, r2_int64, char *, r2_int64);
+static void tim_merge_hi(struct r2_tim *, char *, r2_int64, char *, r2_int64);
+static void kway_merge(void **, const r2_uint64 *, r2_uint64, r2_uint64, void *, r2_cmp);
+static r2_uint16 ltree_less(const struct r2_ltree *, r2_uint64, r2_uint64);
+static r2_uint64 ltree_build(struct r2_ltree *, r2_uint64);
+static void ltree_init(struct r2_ltree *);
+static void ltree_replay(struct r2_ltree *, r2_uint64);
+static r2_uint16 xsort(struct r2_xsort *, const char *, const char *);
+static r2_uint16 xmerge(struct r2_xsort *, FILE **, r2_uint64, FILE *, r2_uint16 (*)(FILE *, const void *, r2_uint64, r2_uint64));
+static r2_uint64 xread(struct r2_xsort *, FILE *, void *, r2_uint64);
+static r2_uint16 xwrite(FILE *, const void *, r2_uint64, r2_uint64);
+static r2_uint64 xread_ints(struct r2_xsort *, FILE *, void *, r2_uint64);
+static r2_uint16 xwrite_ints(FILE *, const void *, r2_uint64, r2_uint64);
+static void xsort_ints(void *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
+static r2_int16 xint_cmp(const void *, const void *);
+static void flt_order(float *, r2_uint64);
+static void dbl_order(r2_dbl *, r2_uint64);
+static r2_uint64 simd_depth(r2_uint64);
+static void sort32(int *, r2_uint64);
+static void sort64(r2_int64 *, r2_uint64);
+static void scalar_sort32(int *, r2_uint64);
+#if defined(R2_SORT_SIMD)
+static void simd_sort32(int *, r2_uint64, r2_uint64, r2_uint64, r2_uint16);
+static void simd_sort64(r2_int64 *, r2_uint64, r2_uint64, r2_uint64, r2_uint16);
+R2_AVX2 static void avx2_network32(int *, r2_uint64);
+R2_AVX2 static void avx2_network64(r2_int64 *, r2_uint64);
+R2_AVX2 static r2_uint64 avx2_partition32(int *, r2_uint64, r2_uint64, int, r2_uint16);
+R2_AVX2 static r2_uint64 avx2_partition64(r2_int64 *, r2_uint64, r2_uint64, r2_int64, r2_uint16);
+R2_AVX512 static void avx512_network32(int *, r2_uint64);
+R2_AVX512 static void avx512_network64(r2_int64 *, r2_uint64);
+R2_AVX512 static r2_uint64 avx512_partition32(int *, r2_uint64, r2_uint64, int, r2_uint16);
+R2_AVX512 static r2_uint64 avx512_partition64(r2_int64 *, r2_uint64, r2_uint64, r2_int64, r2_uint16);
+#endif
 /**
  * @brief               Sorts a sequence in non-decreasing order using insertion sort. 
  *                
@@ -277,7 +533,7 @@ static void merge(char *seq, char *aux, r2_uint64 start, r2_uint64 mid, r2_uint6
          * @brief Copy contents of seq into aux.
          * 
          */
-        memcpy(&aux[start*es], &seq[start*es], (end - start + 1)*es);
+        mcpy(&aux[start*es], &seq[start*es], (end - start + 1)*es);
         for(r2_uint64 j = start, k = mid + 1, l = start; l <= end; ++l){  
                 if(j <= mid && k <= end){
                         if(cmp(&aux[j*es], &aux[k*es]) <= 0){
@@ -332,7 +588,7 @@ static void merge_sort_mod(void *arr, void *seq, r2_uint64 start, r2_uint64 as,
         if(as <= start) 
                 return; 
         else if((as - start) <= CUT_OFF){
-                r2_shell_sort(arr, start, as + 1, es, cmp);
+                r2_insertion_sort(arr, start, as + 1, es, cmp);
                 return;
         }
                 
@@ -430,6 +686,232 @@ static void bmerge_sort_mod(void *arr, void *seq, r2_uint64 start, r2_uint64 as,
         }        
 }
 
+/**
+ * @brief               Sorts a sequence in non-decreasing order using a stable merge sort that needs O(sqrt(n)) extra memory.
+ *
+ *                      Bottom up mergesort over runs sorted with insertion sort. A merge copies the shorter run to a 
+ *                      buffer of about sqrt(n) elements and merges it back when it fits. When neither run fits the 
+ *                      longer run is split in half, the position of its middle element is binary searched in the other 
+ *                      run and the two pieces between them are rotated, which leaves two independent smaller merges. 
+ *                      Rotations move blocks through the buffer as well.
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ * @param es            Element size.
+ * @param cmp           A callback comparison function that compares two elements a and b.
+ */
+void r2_inplace_merge_sort(void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, r2_cmp cmp)
+{
+        if(as <= start + 1)
+                return;
+
+        struct r2_imerge im;
+        r2_uint64 n = as - start;
+        r2_uint64 lo, mid, hi, width;
+        im.arr = (char *)arr + start*es;
+        im.es  = es;
+        im.cmp = cmp;
+        for(im.cap = CUT_OFF; im.cap * im.cap < n; im.cap <<= 1);
+        im.cap = im.cap > n? n : im.cap;
+        im.buf = malloc(im.cap * es);
+        assert(im.buf != NULL);
+
+        for(lo = 0; lo < n; lo += CUT_OFF)
+                imerge_insertion_sort(&im, lo, lo + CUT_OFF < n? lo + CUT_OFF : n);
+
+        for(width = CUT_OFF; width < n; width <<= 1){
+                for(lo = 0; lo + width < n; lo += 2*width){
+                        mid = lo + width;
+                        hi  = mid + width < n? mid + width : n;
+                        /*The runs are already in order.*/
+                        if(cmp(&im.arr[(mid - 1)*es], &im.arr[mid*es]) > 0)
+                                imerge(&im, lo, mid, hi);
+                }
+        }
+
+        free(im.buf);
+        is_sorted(arr, start, as, es, cmp);
+}
+
+/**
+ * @brief               Insertion sort that shifts elements with memmove.
+ *
+ * @param im            In-place merge sort.
+ * @param lo            Start.
+ * @param hi            End.
+ */
+static void imerge_insertion_sort(struct r2_imerge *im, r2_uint64 lo, r2_uint64 hi)
+{
+        char *arr = im->arr;
+        r2_uint64 es = im->es;
+        r2_uint64 j;
+        for(r2_uint64 i = lo + 1; i < hi; ++i){
+                if(im->cmp(&arr[(i - 1)*es], &arr[i*es]) <= 0)
+                        continue;
+
+                mcpy(im->buf, &arr[i*es], es);
+                for(j = i - 1; j > lo && im->cmp(&arr[(j - 1)*es], im->buf) > 0; --j);
+                mmove(&arr[(j + 1)*es], &arr[j*es], (i - j)*es);
+                mcpy(&arr[j*es], im->buf, es);
+        }
+}
+
+/**
+ * @brief               Merges arr[lo...mid-1] and arr[mid...hi-1] stably.
+ *
+ * @param im            In-place merge sort.
+ * @param lo            Start of left run.
+ * @param mid           Start of right run.
+ * @param hi            End of right run.
+ */
+static void imerge(struct r2_imerge *im, r2_uint64 lo, r2_uint64 mid, r2_uint64 hi)
+{
+        char *arr = im->arr;
+        r2_uint64 es = im->es;
+        r2_uint64 cut1, cut2, n1, n2;
+        r2_int64 l, r, k;
+        while(lo < mid && mid < hi){
+                n1 = mid - lo;
+                n2 = hi - mid;
+                if(n1 <= im->cap && n1 <= n2){
+                        /*Merge forwards from the buffer, ties take the left element.*/
+                        mcpy(im->buf, &arr[lo*es], n1*es);
+                        for(l = 0, r = mid, k = lo; l < (r2_int64)n1 && r < (r2_int64)hi; ++k){
+                                if(im->cmp(&arr[r*es], &im->buf[l*es]) < 0)
+                                        mcpy(&arr[k*es], &arr[(r++)*es], es);
+                                else    mcpy(&arr[k*es], &im->buf[(l++)*es], es);
+                        }
+                        mcpy(&arr[k*es], &im->buf[l*es], (n1 - l)*es);
+                        return;
+                }
+
+                if(n2 <= im->cap){
+                        /*Merge backwards from the buffer, ties take the right element.*/
+                        mcpy(im->buf, &arr[mid*es], n2*es);
+                        for(l = mid - 1, r = n2 - 1, k = hi - 1; l >= (r2_int64)lo && r >= 0; --k){
+                                if(im->cmp(&im->buf[r*es], &arr[l*es]) < 0)
+                                        mcpy(&arr[k*es], &arr[(l--)*es], es);
+                                else    mcpy(&arr[k*es], &im->buf[(r--)*es], es);
+                        }
+                        mcpy(&arr[lo*es], im->buf, (r + 1)*es);
+                        return;
+                }
+
+                /*Elements equal to the cut element stay on the same side of it, so the merge stays stable.*/
+                if(n1 >= n2){
+                        cut1 = lo + n1/2;
+                        cut2 = imerge_bound(im, mid, hi, &arr[cut1*es], FALSE);
+                }else{
+                        cut2 = mid + n2/2;
+                        cut1 = imerge_bound(im, lo, mid, &arr[cut2*es], TRUE);
+                }
+
+                imerge_rotate(im, cut1, mid, cut2);
+                mid = cut1 + (cut2 - mid);
+                /*We recurse on the smaller merge and loop on the larger one.*/
+                if(mid - lo < hi - mid){
+                        imerge(im, lo, cut1, mid);
+                        lo  = mid;
+                        mid = cut2;
+                }else{
+                        imerge(im, mid, cut2, hi);
+                        hi  = mid;
+                        mid = cut1;
+                }
+        }
+}
+
+/**
+ * @brief               Binary searches arr[lo...hi-1] for the first element greater than key (upper == TRUE)
+ *                      or the first element that isn't smaller than key (upper == FALSE).
+ *
+ * @param im            In-place merge sort.
+ * @param lo            Start.
+ * @param hi            End.
+ * @param key           Key.
+ * @param upper         TRUE for the upper bound, FALSE for the lower bound.
+ * @return r2_uint64    Returns the position found.
+ */
+static r2_uint64 imerge_bound(struct r2_imerge *im, r2_uint64 lo, r2_uint64 hi, const char *key, r2_uint16 upper)
+{
+        r2_uint64 m;
+        r2_int16 c;
+        while(lo < hi){
+                m = lo + (hi - lo)/2;
+                c = im->cmp(&im->arr[m*im->es], key);
+                if(c < 0 || (c == 0 && upper == TRUE))
+                        lo = m + 1;
+                else    hi = m;
+        }
+        return lo;
+}
+
+/**
+ * @brief               Swaps the blocks arr[lo...mid-1] and arr[mid...hi-1]. While both blocks are larger than the buffer
+ *                      the shorter block is swapped with the same number of elements of the longer one (Gries and Mills),
+ *                      which leaves a smaller rotation. Once a block fits in the buffer it's moved through the buffer.
+ *
+ * @param im            In-place merge sort.
+ * @param lo            Start of first block.
+ * @param mid           Start of second block.
+ * @param hi            End of second block.
+ */
+static void imerge_rotate(struct r2_imerge *im, r2_uint64 lo, r2_uint64 mid, r2_uint64 hi)
+{
+        char *arr = im->arr;
+        r2_uint64 es = im->es;
+        r2_uint64 n1 = mid - lo;
+        r2_uint64 n2 = hi - mid;
+        while(n1 > im->cap && n2 > im->cap){
+                if(n1 <= n2){
+                        imerge_swap(im, lo, mid, n1);
+                        lo  += n1;
+                        mid += n1;
+                        n2  -= n1;
+                }else{
+                        imerge_swap(im, mid - n2, mid, n2);
+                        hi  -= n2;
+                        mid -= n2;
+                        n1  -= n2;
+                }
+        }
+
+        if(n1 == 0 || n2 == 0)
+                return;
+
+        if(n1 <= n2 && n1 <= im->cap){
+                mcpy(im->buf, &arr[lo*es], n1*es);
+                mmove(&arr[lo*es], &arr[mid*es], n2*es);
+                mcpy(&arr[(lo + n2)*es], im->buf, n1*es);
+        }else{
+                mcpy(im->buf, &arr[mid*es], n2*es);
+                mmove(&arr[(lo + n2)*es], &arr[lo*es], n1*es);
+                mcpy(&arr[lo*es], im->buf, n2*es);
+        }
+}
+
+/**
+ * @brief               Swaps arr[a...a+n-1] and arr[b...b+n-1] through the buffer, the ranges can't overlap.
+ *
+ * @param im            In-place merge sort.
+ * @param a             Start of first range.
+ * @param b             Start of second range.
+ * @param n             Number of elements.
+ */
+static void imerge_swap(struct r2_imerge *im, r2_uint64 a, r2_uint64 b, r2_uint64 n)
+{
+        char *arr = im->arr;
+        r2_uint64 es = im->es;
+        r2_uint64 m;
+        for(; n > 0; n -= m, a += m, b += m){
+                m = n < im->cap? n : im->cap;
+                mcpy(im->buf, &arr[a*es], m*es);
+                mcpy(&arr[a*es], &arr[b*es], m*es);
+                mcpy(&arr[b*es], im->buf, m*es);
+        }
+}
+
 /**
  * @brief               Sorts a sequence in non-decreasing order using quicksort. 
  *             
@@ -805,21 +1287,3876 @@ void r2_quick_sort_mod(void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, r
 
 
 /**
- * @brief       Copies src into dest.
+ * @brief               Sorts a sequence in non-decreasing order using pattern-defeating quicksort (pdqsort). 
+ *                      
+ *                      pdqsort is an introspective quicksort by Orson Peters. It picks the median of three 
+ *                      (or the pseudomedian of nine for large subarrays) as pivot and partitions in blocks: the 
+ *                      outcome of each comparison is written to a block of offsets without branching on it and the 
+ *                      misplaced elements are swapped afterwards, which avoids the branch mispredictions of 
+ *                      Hoare's scheme. Subarrays that are partitioned badly have some elements shuffled to break 
+ *                      up patterns and after too many bad partitions we fall back to heapsort so the worst case is O(n log n). 
+ *                      When a partition didn't move any element we try to finish both sides with an insertion sort that 
+ *                      gives up after a few moves, which sorts nearly sorted input in linear time. Runs of equal elements 
+ *                      are put aside in one partition. Sorted and descending input are detected up front.
+ *                      See https://arxiv.org/abs/2106.05123. 
+ *          
+ * @param arr           Array. 
+ * @param start         Start.
+ * @param as            Array size. Example if we are sorting 10 numbers then array size should be 10.
+ * @param es            Element size. Example if we're sorting an array of 4 byte integers
+ *                      then es should be equal to 4.
+ * @param cmp           A callback comparison function that compares two elements a and b.
+ */
+void r2_pdq_sort(void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, r2_cmp cmp)
+{
+        if(as <= start + 1)
+                return;
+
+        char *seq = arr;
+        r2_uint64 asc  = start + 1;
+        r2_uint64 desc = start + 1;
+        for(;asc < as && cmp(&seq[(asc - 1)*es], &seq[asc*es]) <= 0; ++asc);
+        if(asc == as)
+                return;
+
+        for(;desc < as && cmp(&seq[(desc - 1)*es], &seq[desc*es]) >= 0; ++desc);
+        if(desc == as){
+                for(r2_uint64 l = start, r = as - 1; l < r; ++l, --r)
+                        swap(&seq[l*es], &seq[r*es], es);
+        }else
+                pdq_sort(arr, start, as, es, cmp);
+        is_sorted(arr, start, as, es, cmp);
+}
+
+/**
+ * @brief               Helper function for pdqsort. Sorts arr[lo...hi-1].
  * 
- * @param src   Src. 
- * @param dest  Dest.   
- * @param size  Number of bytes.
+ * @param arr           Array. 
+ * @param lo            Start.
+ * @param hi            End.
+ * @param es            Element size.
+ * @param cmp           A comparison callback function.
  */
-static inline void cpy(void *src, void *dest, r2_uint64 size)
+static void pdq_sort(char *arr, r2_int64 lo, r2_int64 hi, r2_uint64 es, r2_cmp cmp)
 {
-        memmove(dest, src, size);
+        char buffer[128] = {0};
+        char *buf = buffer;
+        if(es > 64)
+                buf = malloc(sizeof(char) * es * 2);
+        assert(buf != NULL);
+
+        struct r2_pdq pdq;
+        pdq.arr   = arr; 
+        pdq.es    = es; 
+        pdq.cmp   = cmp; 
+        pdq.pivot = buf;
+        pdq.tmp   = &buf[es];
+
+        /*We allow log2(n) bad partitions before switching to heapsort.*/
+        r2_int64 bad = 0;
+        for(r2_int64 n = hi - lo; n > 1; n >>= 1)
+                ++bad;
+
+        pdq_loop(&pdq, lo, hi, bad, TRUE);
+        if(buf != buffer)
+                free(buf);
 }
 
+/**
+ * @brief               Main loop of pdqsort. 
+ * 
+ * @param pdq           State.
+ * @param begin         Start.
+ * @param end           End.
+ * @param bad           Number of bad partitions allowed before switching to heapsort.
+ * @param leftmost      TRUE when arr[begin-1] doesn't belong to an earlier partition.
+ */
+static void pdq_loop(struct r2_pdq *pdq, r2_int64 begin, r2_int64 end, r2_int64 bad, r2_uint16 leftmost)
+{
+        char *arr = pdq->arr;
+        r2_uint64 es = pdq->es;
+        r2_int64 size, s2, pivot, lsize, rsize;
+        r2_uint16 partitioned = FALSE;
+        for(;;){
+                size = end - begin;
+                if(size < PDQ_CUT_OFF){
+                        pdq_insertion_sort(pdq, begin, end, leftmost);
+                        return;
+                }
+
+                /*Pivot is the median of three or the pseudomedian of nine and is moved to the start.*/
+                s2 = size / 2;
+                if(size > PDQ_NINTHER){
+                        pdq_sort3(pdq, begin, begin + s2, end - 1);
+                        pdq_sort3(pdq, begin + 1, begin + s2 - 1, end - 2);
+                        pdq_sort3(pdq, begin + 2, begin + s2 + 1, end - 3);
+                        pdq_sort3(pdq, begin + s2 - 1, begin + s2, begin + s2 + 1);
+                        swap(&arr[begin*es], &arr[(begin + s2)*es], es);
+                }else
+                        pdq_sort3(pdq, begin + s2, begin, end - 1);
 
-static void is_sorted(void *arr, r2_uint64 start ,r2_uint64 size, r2_uint64 ez,r2_cmp cmp)
+                /**
+                 * arr[begin-1] is the pivot of an earlier partition, so nothing in this subarray is smaller than it.
+                 * If our pivot is equal to it we put every element equal to the pivot on the left, that's already sorted.
+                 */
+                if(leftmost == FALSE && pdq->cmp(&arr[(begin - 1)*es], &arr[begin*es]) >= 0){
+                        begin = pdq_partition_left(pdq, begin, end) + 1;
+                        continue;
+                }
+
+                pivot = pdq_partition_right(pdq, begin, end, &partitioned);
+                lsize = pivot - begin; 
+                rsize = end - (pivot + 1);
+                if(lsize < size / 8 || rsize < size / 8){
+                        if(--bad == 0){
+                                r2_heap_sort(&arr[begin*es], 0, size, es, pdq->cmp);
+                                return;
+                        }
+
+                        /*Shuffle some elements to break up the pattern that caused the bad partition.*/
+                        if(lsize >= PDQ_CUT_OFF){
+                                swap(&arr[begin*es], &arr[(begin + lsize/4)*es], es);
+                                swap(&arr[(pivot - 1)*es], &arr[(pivot - lsize/4)*es], es);
+                                if(lsize > PDQ_NINTHER){
+                                        swap(&arr[(begin + 1)*es], &arr[(begin + lsize/4 + 1)*es], es);
+                                        swap(&arr[(begin + 2)*es], &arr[(begin + lsize/4 + 2)*es], es);
+                                        swap(&arr[(pivot - 2)*es], &arr[(pivot - (lsize/4 + 1))*es], es);
+                                        swap(&arr[(pivot - 3)*es], &arr[(pivot - (lsize/4 + 2))*es], es);
+                                }
+                        }
+
+                        if(rsize >= PDQ_CUT_OFF){
+                                swap(&arr[(pivot + 1)*es], &arr[(pivot + 1 + rsize/4)*es], es);
+                                swap(&arr[(end - 1)*es], &arr[(end - rsize/4)*es], es);
+                                if(rsize > PDQ_NINTHER){
+                                        swap(&arr[(pivot + 2)*es], &arr[(pivot + 2 + rsize/4)*es], es);
+                                        swap(&arr[(pivot + 3)*es], &arr[(pivot + 3 + rsize/4)*es], es);
+                                        swap(&arr[(end - 2)*es], &arr[(end - (1 + rsize/4))*es], es);
+                                        swap(&arr[(end - 3)*es], &arr[(end - (2 + rsize/4))*es], es);
+                                }
+                        }
+                }else if(partitioned == TRUE && pdq_partial_insertion_sort(pdq, begin, pivot) == TRUE 
+                                             && pdq_partial_insertion_sort(pdq, pivot + 1, end) == TRUE)
+                        return;
+
+                /*We recurse on the left side and loop on the right side.*/
+                pdq_loop(pdq, begin, pivot, bad, leftmost);
+                begin    = pivot + 1;
+                leftmost = FALSE;
+        }
+}
+
+/**
+ * @brief               Insertion sort used by pdqsort on small subarrays.
+ * 
+ * @param pdq           State.
+ * @param begin         Start.
+ * @param end           End.
+ * @param guarded       When FALSE arr[begin-1] is known to be <= every element so we don't check for begin.
+ */
+static void pdq_insertion_sort(struct r2_pdq *pdq, r2_int64 begin, r2_int64 end, r2_uint16 guarded)
 {
-        char *seq = arr;
-        for(r2_uint64 i = start; i < size -1; ++i)
-                assert(cmp(&seq[i*ez], &seq[(i+1)*ez]) <= 0);
+        char *arr = pdq->arr; 
+        r2_uint64 es = pdq->es;
+        r2_int64 sift;
+        for(r2_int64 cur = begin + 1; cur < end; ++cur){
+                if(pdq->cmp(&arr[cur*es], &arr[(cur - 1)*es]) < 0){
+                        cpy(&arr[cur*es], pdq->tmp, es);
+                        sift = cur;
+                        do{
+                                cpy(&arr[(sift - 1)*es], &arr[sift*es], es);
+                                --sift;
+                        }while((guarded == FALSE || sift != begin) && pdq->cmp(pdq->tmp, &arr[(sift - 1)*es]) < 0);
+                        cpy(pdq->tmp, &arr[sift*es], es);
+                }
+        }
+}
+
+/**
+ * @brief               Attempts to sort a subarray with insertion sort but gives up after a few moves.
+ * 
+ * @param pdq           State.
+ * @param begin         Start.
+ * @param end           End.
+ * @return r2_uint16    Returns TRUE whenever the subarray was sorted, else FALSE.
+ */
+static r2_uint16 pdq_partial_insertion_sort(struct r2_pdq *pdq, r2_int64 begin, r2_int64 end)
+{
+        char *arr = pdq->arr; 
+        r2_uint64 es = pdq->es;
+        r2_uint64 limit = 0;
+        r2_int64 sift;
+        if(begin == end)
+                return TRUE;
+
+        for(r2_int64 cur = begin + 1; cur < end; ++cur){
+                if(pdq->cmp(&arr[cur*es], &arr[(cur - 1)*es]) < 0){
+                        cpy(&arr[cur*es], pdq->tmp, es);
+                        sift = cur;
+                        do{
+                                cpy(&arr[(sift - 1)*es], &arr[sift*es], es);
+                                --sift;
+                        }while(sift != begin && pdq->cmp(pdq->tmp, &arr[(sift - 1)*es]) < 0);
+                        cpy(pdq->tmp, &arr[sift*es], es);
+                        limit += cur - sift;
+                }
+
+                if(limit > PDQ_PARTIAL)
+                        return FALSE;
+        }
+        return TRUE;
+}
+
+/**
+ * @brief               Orders two elements.
+ * 
+ * @param pdq           State.
+ * @param a             Position of first element.
+ * @param b             Position of second element.
+ */
+static void pdq_sort2(struct r2_pdq *pdq, r2_int64 a, r2_int64 b)
+{
+        if(pdq->cmp(&pdq->arr[b*pdq->es], &pdq->arr[a*pdq->es]) < 0)
+                swap(&pdq->arr[a*pdq->es], &pdq->arr[b*pdq->es], pdq->es);
+}
+
+/**
+ * @brief               Orders three elements.
+ * 
+ * @param pdq           State.
+ * @param a             Position of first element.
+ * @param b             Position of second element.
+ * @param c             Position of third element.
+ */
+static void pdq_sort3(struct r2_pdq *pdq, r2_int64 a, r2_int64 b, r2_int64 c)
+{
+        pdq_sort2(pdq, a, b);
+        pdq_sort2(pdq, b, c);
+        pdq_sort2(pdq, a, b);
+}
+
+/**
+ * @brief               Partitions arr[begin...end-1] around arr[begin], elements equal to the pivot go to the left.
+ * 
+ * @param pdq           State.
+ * @param begin         Start.
+ * @param end           End.
+ * @return r2_int64     Returns the final position of the pivot.
+ */
+static r2_int64 pdq_partition_left(struct r2_pdq *pdq, r2_int64 begin, r2_int64 end)
+{
+        char *arr = pdq->arr; 
+        r2_uint64 es = pdq->es;
+        char *pivot  = pdq->pivot;
+        r2_cmp cmp   = pdq->cmp;
+        r2_int64 first = begin; 
+        r2_int64 last  = end;
+        cpy(&arr[begin*es], pivot, es);
+
+        while(cmp(pivot, &arr[(--last)*es]) < 0);
+        if(last + 1 == end)
+                while(first < last && cmp(pivot, &arr[(++first)*es]) >= 0);
+        else
+                while(cmp(pivot, &arr[(++first)*es]) >= 0);
+
+        while(first < last){
+                swap(&arr[first*es], &arr[last*es], es);
+                while(cmp(pivot, &arr[(--last)*es]) < 0);
+                while(cmp(pivot, &arr[(++first)*es]) >= 0);
+        }
+
+        cpy(&arr[last*es], &arr[begin*es], es);
+        cpy(pivot, &arr[last*es], es);
+        return last;
+}
+
+/**
+ * @brief               Partitions arr[begin...end-1] around arr[begin] using block partitioning, 
+ *                      elements equal to the pivot go to the right.
+ * 
+ * @param pdq           State.
+ * @param begin         Start.
+ * @param end           End.
+ * @param partitioned   Set to TRUE whenever the subarray was already partitioned.
+ * @return r2_int64     Returns the final position of the pivot.
+ */
+static r2_int64 pdq_partition_right(struct r2_pdq *pdq, r2_int64 begin, r2_int64 end, r2_uint16 *partitioned)
+{
+        char *arr = pdq->arr; 
+        r2_uint64 es = pdq->es;
+        char *pivot  = pdq->pivot;
+        r2_cmp cmp   = pdq->cmp;
+        r2_int64 first = begin; 
+        r2_int64 last  = end;
+        cpy(&arr[begin*es], pivot, es);
+
+        /*The median of three guarantees these loops stop.*/
+        while(cmp(&arr[(++first)*es], pivot) < 0);
+        if(first - 1 == begin)
+                while(first < last && cmp(&arr[(--last)*es], pivot) >= 0);
+        else
+                while(cmp(&arr[(--last)*es], pivot) >= 0);
+
+        *partitioned = first >= last;
+        if(*partitioned == FALSE){
+                r2_uc loffsets[PDQ_BLOCK];/*offsets of elements on the left that belong on the right*/
+                r2_uc roffsets[PDQ_BLOCK];/*offsets of elements on the right that belong on the left*/
+                r2_uint64 nl = 0, nr = 0, sl = 0, sr = 0;
+                r2_uint64 num, unknown, lsplit, rsplit;
+                swap(&arr[first*es], &arr[last*es], es);
+                ++first;
+                r2_int64 lbase = first;
+                r2_int64 rbase = last;
+                while(first < last){
+                        unknown = last - first;
+                        lsplit  = nl == 0? (nr == 0? unknown / 2 : unknown) : 0;
+                        rsplit  = nr == 0? unknown - lsplit : 0;
+                        if(lsplit > PDQ_BLOCK)
+                                lsplit = PDQ_BLOCK;
+                        if(rsplit > PDQ_BLOCK)
+                                rsplit = PDQ_BLOCK;
+
+                        /*Record the outcome of each comparison without branching on it.*/
+                        for(r2_uint64 i = 0; i < lsplit; ++i, ++first){
+                                loffsets[nl] = (r2_uc)i;
+                                nl += cmp(&arr[first*es], pivot) >= 0;
+                        }
+
+                        for(r2_uint64 i = 0; i < rsplit;){
+                                roffsets[nr] = (r2_uc)++i;
+                                nr += cmp(&arr[(--last)*es], pivot) < 0;
+                        }
+
+                        num = nl < nr? nl : nr;
+                        pdq_swap_offsets(pdq, lbase, rbase, &loffsets[sl], &roffsets[sr], num, nl == nr);
+                        nl -= num; 
+                        nr -= num;
+                        sl += num; 
+                        sr += num;
+                        if(nl == 0){
+                                sl = 0;
+                                lbase = first;
+                        }
+                        if(nr == 0){
+                                sr = 0;
+                                rbase = last;
+                        }
+                }
+
+                /*Move whatever is left in the blocks next to the boundary.*/
+                if(nl != 0){
+                        while(nl-- > 0)
+                                swap(&arr[(lbase + loffsets[sl + nl])*es], &arr[(--last)*es], es);
+                        first = last;
+                }
+                if(nr != 0){
+                        while(nr-- > 0){
+                                swap(&arr[(rbase - roffsets[sr + nr])*es], &arr[first*es], es);
+                                ++first;
+                        }
+                        last = first;
+                }
+        }
+
+        r2_int64 pos = first - 1;
+        cpy(&arr[pos*es], &arr[begin*es], es);
+        cpy(pivot, &arr[pos*es], es);
+        return pos;
+}
+
+/**
+ * @brief               Swaps the elements recorded in the offset blocks.
+ * 
+ * @param pdq           State.
+ * @param lbase         Start of left block.
+ * @param rbase         End of right block.
+ * @param loffsets      Offsets from lbase.
+ * @param roffsets      Offsets from rbase.
+ * @param num           Number of elements to swap.
+ * @param swaps         Use swaps when TRUE, else a cyclic permutation.
+ */
+static void pdq_swap_offsets(struct r2_pdq *pdq, r2_int64 lbase, r2_int64 rbase, const r2_uc *loffsets, const r2_uc *roffsets, r2_uint64 num, r2_uint16 swaps)
+{
+        char *arr = pdq->arr; 
+        r2_uint64 es = pdq->es;
+        r2_int64 l, r;
+        if(swaps == TRUE){
+                /*Descending input needs real swaps to stay O(n).*/
+                for(r2_uint64 i = 0; i < num; ++i)
+                        swap(&arr[(lbase + loffsets[i])*es], &arr[(rbase - roffsets[i])*es], es);
+        }else if(num > 0){
+                l = lbase + loffsets[0];
+                r = rbase - roffsets[0];
+                cpy(&arr[l*es], pdq->tmp, es);
+                cpy(&arr[r*es], &arr[l*es], es);
+                for(r2_uint64 i = 1; i < num; ++i){
+                        l = lbase + loffsets[i];
+                        cpy(&arr[l*es], &arr[r*es], es);
+                        r = rbase - roffsets[i];
+                        cpy(&arr[r*es], &arr[l*es], es);
+                }
+                cpy(pdq->tmp, &arr[r*es], es);
+        }
+}
+
+/**
+ * @brief               Rearranges a sequence so that arr[nth] is the element that would be there if the sequence was sorted,
+ *                      no element before it is greater and no element after it is smaller (introselect).
+ *
+ *                      Quickselect partitions around the median of three with hoare's partition and only continues
+ *                      on the side that contains nth, so it takes O(n) time on average. When the partitions keep
+ *                      being bad, for example when there are many equal elements, the remaining range is sorted with
+ *                      pdqsort after 2*log2(n) partitions so the worst case is O(n log n).
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ * @param es            Element size.
+ * @param nth           Position of the element to select, start <= nth < as.
+ * @param cmp           A callback comparison function that compares two elements a and b.
+ */
+void r2_nth_element(void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, r2_uint64 nth, r2_cmp cmp)
+{
+        assert(nth >= start && nth < as);
+        r2_int64 rank = nth;
+        multi_select(arr, start, as - 1, es, &rank, 1, simd_depth(as - start), cmp);
+}
+
+/**
+ * @brief               Rearranges a sequence so that arr[start...mid-1] holds the mid - start smallest elements
+ *                      in non-decreasing order. The rest of the sequence is left in no particular order.
+ *                      It takes O(n + k log k) time where k = mid - start.
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param mid           End of sorted prefix.
+ * @param as            Array size.
+ * @param es            Element size.
+ * @param cmp           A callback comparison function that compares two elements a and b.
+ */
+void r2_partial_sort(void *arr, r2_uint64 start, r2_uint64 mid, r2_uint64 as, r2_uint64 es, r2_cmp cmp)
+{
+        assert(mid >= start && mid <= as);
+        if(mid == start)
+                return;
+
+        if(mid < as)
+                r2_nth_element(arr, start, as, es, mid - 1, cmp);
+        r2_pdq_sort(arr, start, mid, es, cmp);
+}
+
+/**
+ * @brief               Selects several ranks at once. Afterwards arr[ranks[i]] is the element that would be there if
+ *                      the sequence was sorted and the elements between two selected ranks lie between both elements.
+ *                      Each partition splits the ranks as well so selecting m ranks takes O(n log m) time.
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ * @param es            Element size.
+ * @param ranks         Positions to select, they can be in any order.
+ * @param nranks        Number of positions.
+ * @param cmp           A callback comparison function that compares two elements a and b.
+ */
+void r2_multi_select(void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, const r2_uint64 *ranks, r2_uint64 nranks, r2_cmp cmp)
+{
+        if(nranks == 0 || as <= start)
+                return;
+
+        r2_int64 *sorted = malloc(sizeof(r2_int64) * nranks);
+        assert(sorted != NULL);
+        for(r2_uint64 i = 0; i < nranks; ++i){
+                assert(ranks[i] >= start && ranks[i] < as);
+                sorted[i] = ranks[i];
+        }
+
+        r2_radix_sort_int64(sorted, 0, nranks);
+        multi_select(arr, start, as - 1, es, sorted, nranks, simd_depth(as - start), cmp);
+        free(sorted);
+}
+
+/**
+ * @brief               Selects quantiles of a sequence. The q quantile is the element of rank start + floor(q*(n-1))
+ *                      where n = as - start, so 0 selects the minimum, 0.5 the median and 1 the maximum.
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ * @param es            Element size.
+ * @param qs            Quantiles between 0 and 1.
+ * @param nqs           Number of quantiles.
+ * @param pos           Positions of the quantiles, the q[i] quantile ends up at arr[pos[i]].
+ * @param cmp           A callback comparison function that compares two elements a and b.
+ */
+void r2_quantiles(void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, const r2_dbl *qs, r2_uint64 nqs, r2_uint64 *pos, r2_cmp cmp)
+{
+        if(as <= start)
+                return;
+
+        r2_uint64 n = as - start;
+        for(r2_uint64 i = 0; i < nqs; ++i){
+                assert(qs[i] >= 0 && qs[i] <= 1);
+                pos[i] = start + (r2_uint64)(qs[i] * (n - 1));
+        }
+        r2_multi_select(arr, start, as, es, pos, nqs, cmp);
+}
+
+/**
+ * @brief               Helper function for selection. Places the elements of rank ranks[0...nranks-1] in arr[lo...hi].
+ *
+ * @param arr           Array.
+ * @param lo            Start.
+ * @param hi            End, inclusive.
+ * @param es            Element size.
+ * @param ranks         Sorted ranks between lo and hi.
+ * @param nranks        Number of ranks.
+ * @param depth         Number of partitions allowed before falling back to pdqsort.
+ * @param cmp           A comparison callback function.
+ */
+static void multi_select(char *arr, r2_int64 lo, r2_int64 hi, r2_uint64 es, const r2_int64 *ranks, r2_uint64 nranks, r2_uint64 depth, r2_cmp cmp)
+{
+        r2_int64 p;
+        r2_uint64 l, r, m;
+        while(nranks > 0 && lo < hi){
+                if(hi - lo < CUT_OFF){
+                        r2_insertion_sort(arr, lo, hi + 1, es, cmp);
+                        return;
+                }
+
+                if(depth-- == 0){
+                        pdq_sort(arr, lo, hi + 1, es, cmp);
+                        return;
+                }
+
+                /*hoare partitions around the last element.*/
+                p = median_of_three(arr, lo, lo + (hi - lo)/2, hi, es, cmp);
+                swap(&arr[p*es], &arr[hi*es], es);
+                p = hoare(arr, lo, hi, es, cmp);
+
+                /*Ranks [0, l) are left of the pivot, ranks [r, nranks) are right of it.*/
+                for(l = 0, r = nranks; l < r;){
+                        m = l + (r - l)/2;
+                        if(ranks[m] < p)
+                                l = m + 1;
+                        else    r = m;
+                }
+                for(r = l; r < nranks && ranks[r] == p; ++r);
+
+                /*We recurse on the side with fewer ranks and loop on the other side.*/
+                if(l <= nranks - r){
+                        multi_select(arr, lo, p - 1, es, ranks, l, depth, cmp);
+                        lo = p + 1;
+                        ranks  = &ranks[r];
+                        nranks = nranks - r;
+                }else{
+                        multi_select(arr, p + 1, hi, es, &ranks[r], nranks - r, depth, cmp);
+                        hi = p - 1;
+                        nranks = l;
+                }
+        }
+}
+
+/**
+ * @brief               Sorts a sequence in non-decreasing order using an adaptive natural merge sort (timsort with the powersort merge policy).
+ *
+ *                      The sequence is split into runs that are already sorted. Strictly descending runs are reversed and
+ *                      runs shorter than minrun (between 32 and 64) are extended with binary insertion sort. Each run
+ *                      is pushed on a stack and the powersort policy decides which runs to merge: the boundary between two
+ *                      runs gets a power, the depth of their midpoints in a binary tree over the whole sequence, and runs
+ *                      are merged while the boundary below the top of the stack has a larger power than the new one. This
+ *                      keeps the merges balanced, the cost is within n*H + O(n) comparisons where H is the entropy of the run lengths.
+ *                      Merges skip the prefix of the left run and suffix of the right run that are already in place and switch to
+ *                      galloping (exponential search) when one run keeps winning, so merging runs that barely overlap takes few
+ *                      comparisons. Sorted input takes n-1 comparisons, input that's mostly sorted takes nearly linear time.
+ *                      The sort is stable and uses at most n/2 elements of extra memory.
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size. Example if we are sorting 10 numbers then array size should be 10.
+ * @param es            Element size. Example if we're sorting an array of 4 byte integers
+ *                      then es should be equal to 4.
+ * @param cmp           A callback comparison function that compares two elements a and b.
+ */
+void r2_tim_sort(void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, r2_cmp cmp)
+{
+        if(as <= start + 1)
+                return;
+
+        struct r2_tim tim;
+        r2_uint64 n      = as - start;
+        r2_uint64 minrun = tim_minrun(n);
+        r2_uint64 lo     = start;
+        r2_uint64 len, force;
+        r2_int64 power;
+        tim.arr   = arr;
+        tim.es    = es;
+        tim.cmp   = cmp;
+        tim.tmp   = NULL;
+        tim.tsize = 0;
+        tim.gallop = TIM_MIN_GALLOP;
+        tim.nruns = 0;
+        tim.key   = malloc(es);
+        assert(tim.key != NULL);
+        while(lo < as){
+                len = tim_count_run(&tim, lo, as);
+                if(len < minrun){
+                        force = as - lo < minrun? as - lo : minrun;
+                        tim_binary_sort(&tim, lo, lo + force, lo + len);
+                        len = force;
+                }
+
+                if(tim.nruns > 0){
+                        power = tim_power(tim.runs[tim.nruns - 1].start - start, tim.runs[tim.nruns - 1].len, len, n);
+                        while(tim.nruns > 1 && tim.runs[tim.nruns - 2].power > power)
+                                tim_merge_at(&tim, tim.nruns - 2);
+                        tim.runs[tim.nruns - 1].power = power;
+                }
+
+                assert(tim.nruns < TIM_MAX_RUNS);
+                tim.runs[tim.nruns].start = lo;
+                tim.runs[tim.nruns].len   = len;
+                tim.runs[tim.nruns].power = 0;
+                ++tim.nruns;
+                lo += len;
+        }
+
+        while(tim.nruns > 1)
+                tim_merge_at(&tim, tim.nruns - 2);
+
+        free(tim.tmp);
+        free(tim.key);
+        is_sorted(arr, start, as, es, cmp);
+}
+
+/**
+ * @brief               Returns the minimum run length. It's between 32 and 64 and n/minrun is a power of 2 or a bit less,
+ *                      so the runs made by binary insertion sort on random input are balanced.
+ *
+ * @param n             Number of elements.
+ * @return r2_uint64    Minimum run length.
+ */
+static r2_uint64 tim_minrun(r2_uint64 n)
+{
+        r2_uint64 r = 0;
+        while(n >= 64){
+                r |= n & 1;
+                n >>= 1;
+        }
+        return n + r;
+}
+
+/**
+ * @brief               Returns the length of the run starting at lo. Strictly descending runs are reversed,
+ *                      they're strict so reversing them keeps the sort stable.
+ *
+ * @param tim           State.
+ * @param lo            Start.
+ * @param hi            End.
+ * @return r2_uint64    Length of run.
+ */
+static r2_uint64 tim_count_run(struct r2_tim *tim, r2_uint64 lo, r2_uint64 hi)
+{
+        char *arr = tim->arr;
+        r2_uint64 es = tim->es;
+        r2_uint64 i = lo + 1;
+        if(i == hi)
+                return 1;
+
+        if(tim->cmp(&arr[i*es], &arr[lo*es]) < 0){
+                for(++i; i < hi && tim->cmp(&arr[i*es], &arr[(i - 1)*es]) < 0; ++i);
+                for(r2_uint64 l = lo, r = i - 1; l < r; ++l, --r)
+                        swap(&arr[l*es], &arr[r*es], es);
+        }else
+                for(++i; i < hi && tim->cmp(&arr[i*es], &arr[(i - 1)*es]) >= 0; ++i);
+        return i - lo;
+}
+
+/**
+ * @brief               Sorts arr[lo...hi-1] with binary insertion sort when arr[lo...sorted-1] is already sorted.
+ *
+ * @param tim           State.
+ * @param lo            Start.
+ * @param hi            End.
+ * @param sorted        End of sorted prefix.
+ */
+static void tim_binary_sort(struct r2_tim *tim, r2_uint64 lo, r2_uint64 hi, r2_uint64 sorted)
+{
+        char *arr = tim->arr;
+        r2_uint64 es = tim->es;
+        r2_uint64 l, r, m;
+        for(; sorted < hi; ++sorted){
+                l = lo;
+                r = sorted;
+                /*Equal elements stay after the ones already inserted.*/
+                while(l < r){
+                        m = l + (r - l)/2;
+                        if(tim->cmp(&arr[sorted*es], &arr[m*es]) < 0)
+                                r = m;
+                        else    l = m + 1;
+                }
+
+                if(l != sorted){
+                        cpy(&arr[sorted*es], tim->key, es);
+                        mmove(&arr[(l + 1)*es], &arr[l*es], (sorted - l)*es);
+                        cpy(tim->key, &arr[l*es], es);
+                }
+        }
+}
+
+/**
+ * @brief               Returns the power of the boundary between two adjacent runs, which is the depth of the
+ *                      node of a perfectly balanced binary tree over [0, n) that separates the midpoints of both runs.
+ *
+ * @param s1            Start of first run relative to the start of the sequence.
+ * @param n1            Length of first run.
+ * @param n2            Length of second run.
+ * @param n             Length of sequence.
+ * @return r2_int64     Power.
+ */
+static r2_int64 tim_power(r2_uint64 s1, r2_uint64 n1, r2_uint64 n2, r2_uint64 n)
+{
+        r2_int64 power = 0;
+        r2_uint64 a = 2*s1 + n1;/*twice the midpoint of the first run*/
+        r2_uint64 b = a + n1 + n2;/*twice the midpoint of the second run*/
+        for(;;){
+                ++power;
+                if(a >= n){
+                        a -= n;
+                        b -= n;
+                }else if(b >= n)
+                        break;
+                a <<= 1;
+                b <<= 1;
+        }
+        return power;
+}
+
+/**
+ * @brief               Returns k such that base[k-1] < key <= base[k]. The search gallops from base[hint].
+ *
+ * @param tim           State.
+ * @param key           Key.
+ * @param base          Sorted elements.
+ * @param n             Number of elements.
+ * @param hint          Position the search starts from.
+ * @return r2_int64     Position of the first element not smaller than key.
+ */
+static r2_int64 tim_gallop_left(struct r2_tim *tim, const char *key, const char *base, r2_int64 n, r2_int64 hint)
+{
+        r2_uint64 es = tim->es;
+        r2_int64 last = 0, ofs = 1, max, k, m;
+        if(tim->cmp(&base[hint*es], key) < 0){
+                /*base[hint + last] < key <= base[hint + ofs]*/
+                max = n - hint;
+                while(ofs < max && tim->cmp(&base[(hint + ofs)*es], key) < 0){
+                        last = ofs;
+                        ofs  = 2*ofs + 1;
+                }
+                if(ofs > max)
+                        ofs = max;
+                last += hint;
+                ofs  += hint;
+        }else{
+                /*base[hint - ofs] < key <= base[hint - last]*/
+                max = hint + 1;
+                while(ofs < max && tim->cmp(&base[(hint - ofs)*es], key) >= 0){
+                        last = ofs;
+                        ofs  = 2*ofs + 1;
+                }
+                if(ofs > max)
+                        ofs = max;
+                k    = last;
+                last = hint - ofs;
+                ofs  = hint - k;
+        }
+
+        for(++last; last < ofs;){
+                m = last + (ofs - last)/2;
+                if(tim->cmp(&base[m*es], key) < 0)
+                        last = m + 1;
+                else    ofs = m;
+        }
+        return ofs;
+}
+
+/**
+ * @brief               Returns k such that base[k-1] <= key < base[k]. The search gallops from base[hint].
+ *
+ * @param tim           State.
+ * @param key           Key.
+ * @param base          Sorted elements.
+ * @param n             Number of elements.
+ * @param hint          Position the search starts from.
+ * @return r2_int64     Position of the first element greater than key.
+ */
+static r2_int64 tim_gallop_right(struct r2_tim *tim, const char *key, const char *base, r2_int64 n, r2_int64 hint)
+{
+        r2_uint64 es = tim->es;
+        r2_int64 last = 0, ofs = 1, max, k, m;
+        if(tim->cmp(key, &base[hint*es]) < 0){
+                /*base[hint - ofs] <= key < base[hint - last]*/
+                max = hint + 1;
+                while(ofs < max && tim->cmp(key, &base[(hint - ofs)*es]) < 0){
+                        last = ofs;
+                        ofs  = 2*ofs + 1;
+                }
+                if(ofs > max)
+                        ofs = max;
+                k    = last;
+                last = hint - ofs;
+                ofs  = hint - k;
+        }else{
+                /*base[hint + last] <= key < base[hint + ofs]*/
+                max = n - hint;
+                while(ofs < max && tim->cmp(key, &base[(hint + ofs)*es]) >= 0){
+                        last = ofs;
+                        ofs  = 2*ofs + 1;
+                }
+                if(ofs > max)
+                        ofs = max;
+                last += hint;
+                ofs  += hint;
+        }
+
+        for(++last; last < ofs;){
+                m = last + (ofs - last)/2;
+                if(tim->cmp(key, &base[m*es]) < 0)
+                        ofs = m;
+                else    last = m + 1;
+        }
+        return ofs;
+}
+
+/**
+ * @brief               Makes sure the temporary buffer can hold n elements.
+ *
+ * @param tim           State.
+ * @param n             Number of elements.
+ */
+static void tim_reserve(struct r2_tim *tim, r2_uint64 n)
+{
+        if(tim->tsize < n){
+                free(tim->tmp);
+                tim->tsize = n < 256? 256 : n;
+                tim->tmp   = malloc(tim->tsize * tim->es);
+                assert(tim->tmp != NULL);
+        }
+}
+
+/**
+ * @brief               Merges run i with run i + 1.
+ *
+ * @param tim           State.
+ * @param i             Run.
+ */
+static void tim_merge_at(struct r2_tim *tim, r2_uint64 i)
+{
+        r2_uint64 es = tim->es;
+        char *a = &tim->arr[tim->runs[i].start*es];
+        char *b = &tim->arr[tim->runs[i + 1].start*es];
+        r2_int64 na = tim->runs[i].len;
+        r2_int64 nb = tim->runs[i + 1].len;
+        r2_int64 k;
+        tim->runs[i].len += nb;
+        tim->runs[i].power = tim->runs[i + 1].power;
+        for(r2_uint64 j = i + 1; j + 1 < tim->nruns; ++j)
+                tim->runs[j] = tim->runs[j + 1];
+        --tim->nruns;
+
+        /*Elements of a that are not greater than b[0] are already in place.*/
+        k   = tim_gallop_right(tim, b, a, na, 0);
+        a  += k*es;
+        na -= k;
+        if(na == 0)
+                return;
+
+        /*Elements of b that are not smaller than the last element of a are already in place.*/
+        nb = tim_gallop_left(tim, &a[(na - 1)*es], b, nb, nb - 1);
+        if(nb == 0)
+                return;
+
+        if(na <= nb)
+                tim_merge_lo(tim, a, na, b, nb);
+        else    tim_merge_hi(tim, a, na, b, nb);
+}
+
+/**
+ * @brief               Merges two adjacent runs from the left, a is copied to the temporary buffer.
+ *                      b[0] < a[0] and a[na-1] > b[nb-1].
+ *
+ * @param tim           State.
+ * @param a             First run.
+ * @param na            Length of first run.
+ * @param b             Second run.
+ * @param nb            Length of second run.
+ */
+static void tim_merge_lo(struct r2_tim *tim, char *a, r2_int64 na, char *b, r2_int64 nb)
+{
+        r2_uint64 es = tim->es;
+        r2_int64 acount, bcount, k;
+        r2_int64 gallop = tim->gallop;
+        char *dest = a;
+        char *pa, *pb = b;
+        tim_reserve(tim, na);
+        mcpy(tim->tmp, a, na*es);
+        pa = tim->tmp;
+
+        mcpy(dest, pb, es);
+        dest += es;
+        pb   += es;
+        if(--nb == 0)
+                goto done;
+        if(na == 1)
+                goto last;
+
+        for(;;){
+                acount = bcount = 0;
+                /*Merge one element at a time until a run wins gallop times in a row.*/
+                for(;;){
+                        if(tim->cmp(pb, pa) < 0){
+                                mcpy(dest, pb, es);
+                                dest += es;
+                                pb   += es;
+                                ++bcount;
+                                acount = 0;
+                                if(--nb == 0)
+                                        goto done;
+                                if(bcount >= gallop)
+                                        break;
+                        }else{
+                                mcpy(dest, pa, es);
+                                dest += es;
+                                pa   += es;
+                                ++acount;
+                                bcount = 0;
+                                if(--na == 1)
+                                        goto last;
+                                if(acount >= gallop)
+                                        break;
+                        }
+                }
+
+                /*Gallop until neither run wins by at least TIM_MIN_GALLOP elements.*/
+                ++gallop;
+                do{
+                        gallop -= gallop > 1;
+                        tim->gallop = gallop;
+                        k = acount = tim_gallop_right(tim, pb, pa, na, 0);
+                        if(k != 0){
+                                mcpy(dest, pa, k*es);
+                                dest += k*es;
+                                pa   += k*es;
+                                na   -= k;
+                                if(na == 1)
+                                        goto last;
+                                if(na == 0)
+                                        goto done;
+                        }
+                        mcpy(dest, pb, es);
+                        dest += es;
+                        pb   += es;
+                        if(--nb == 0)
+                                goto done;
+
+                        k = bcount = tim_gallop_left(tim, pa, pb, nb, 0);
+                        if(k != 0){
+                                mmove(dest, pb, k*es);
+                                dest += k*es;
+                                pb   += k*es;
+                                nb   -= k;
+                                if(nb == 0)
+                                        goto done;
+                        }
+                        mcpy(dest, pa, es);
+                        dest += es;
+                        pa   += es;
+                        if(--na == 1)
+                                goto last;
+                }while(acount >= TIM_MIN_GALLOP || bcount >= TIM_MIN_GALLOP);
+                ++gallop;
+                tim->gallop = gallop;
+        }
+
+done:
+        if(na > 0)
+                mcpy(dest, pa, na*es);
+        return;
+last:
+        /*The last element of a goes after the rest of b.*/
+        mmove(dest, pb, nb*es);
+        mcpy(&dest[nb*es], pa, es);
+}
+
+/**
+ * @brief               Merges two adjacent runs from the right, b is copied to the temporary buffer.
+ *                      b[0] < a[0] and a[na-1] > b[nb-1].
+ *
+ * @param tim           State.
+ * @param a             First run.
+ * @param na            Length of first run.
+ * @param b             Second run.
+ * @param nb            Length of second run.
+ */
+static void tim_merge_hi(struct r2_tim *tim, char *a, r2_int64 na, char *b, r2_int64 nb)
+{
+        r2_uint64 es = tim->es;
+        r2_int64 acount, bcount, k;
+        r2_int64 gallop = tim->gallop;
+        char *dest = &b[(nb - 1)*es];
+        char *pa   = &a[(na - 1)*es];
+        char *pb;
+        tim_reserve(tim, nb);
+        mcpy(tim->tmp, b, nb*es);
+        pb = &tim->tmp[(nb - 1)*es];
+
+        mcpy(dest, pa, es);
+        dest -= es;
+        pa   -= es;
+        if(--na == 0)
+                goto done;
+        if(nb == 1)
+                goto first;
+
+        for(;;){
+                acount = bcount = 0;
+                for(;;){
+                        if(tim->cmp(pb, pa) < 0){
+                                mcpy(dest, pa, es);
+                                dest -= es;
+                                pa   -= es;
+                                ++acount;
+                                bcount = 0;
+                                if(--na == 0)
+                                        goto done;
+                                if(acount >= gallop)
+                                        break;
+                        }else{
+                                mcpy(dest, pb, es);
+                                dest -= es;
+                                pb   -= es;
+                                ++bcount;
+                                acount = 0;
+                                if(--nb == 1)
+                                        goto first;
+                                if(bcount >= gallop)
+                                        break;
+                        }
+                }
+
+                ++gallop;
+                do{
+                        gallop -= gallop > 1;
+                        tim->gallop = gallop;
+                        k = acount = na - tim_gallop_right(tim, pb, a, na, na - 1);
+                        if(k != 0){
+                                dest -= k*es;
+                                pa   -= k*es;
+                                mmove(dest + es, pa + es, k*es);
+                                na   -= k;
+                                if(na == 0)
+                                        goto done;
+                        }
+                        mcpy(dest, pb, es);
+                        dest -= es;
+                        pb   -= es;
+                        if(--nb == 1)
+                                goto first;
+
+                        k = bcount = nb - tim_gallop_left(tim, pa, tim->tmp, nb, nb - 1);
+                        if(k != 0){
+                                dest -= k*es;
+                                pb   -= k*es;
+                                mcpy(dest + es, pb + es, k*es);
+                                nb   -= k;
+                                if(nb == 1)
+                                        goto first;
+                                if(nb == 0)
+                                        goto done;
+                        }
+                        mcpy(dest, pa, es);
+                        dest -= es;
+                        pa   -= es;
+                        if(--na == 0)
+                                goto done;
+                }while(acount >= TIM_MIN_GALLOP || bcount >= TIM_MIN_GALLOP);
+                ++gallop;
+                tim->gallop = gallop;
+        }
+
+done:
+        if(nb > 0)
+                mcpy(dest - (nb - 1)*es, tim->tmp, nb*es);
+        return;
+first:
+        /*The first element of b goes before the rest of a.*/
+        dest -= na*es;
+        pa   -= na*es;
+        mmove(dest + es, pa + es, na*es);
+        mcpy(dest, pb, es);
+}
+
+/**
+ * @brief               Sorts keys in non-decreasing order using LSD radix sort. 
+ *                      kv_radix_sort sorts keys that carry a position.
+ * 
+ * @param keys          Keys.
+ * @param n             Number of keys.
+ */
+static void radix_sort(r2_uint64 *keys, r2_uint64 n)
+{
+        if(n < 2)
+                return;
+
+        r2_uint64 count[DIGITS][RADIX] = {{0}};
+        r2_uint64 *src  = keys;
+        r2_uint64 *dest = malloc(sizeof(r2_uint64) * n);
+        r2_uint64 *aux  = dest;
+        assert(dest != NULL);
+
+        /*The number of times each digit occurs doesn't change between passes so we count them all once.*/
+        for(r2_uint64 i = 0; i < n; ++i)
+                for(r2_uint16 d = 0; d < DIGITS; ++d)
+                        ++count[d][(keys[i] >> (d * 8)) & (RADIX - 1)];
+
+        for(r2_uint16 d = 0; d < DIGITS; ++d){
+                r2_uint16 shift = d * 8;
+                /*Every key has the same digit so this pass wouldn't move anything.*/
+                if(count[d][(src[0] >> shift) & (RADIX - 1)] == n)
+                        continue;
+
+                r2_uint64 pos = 0;
+                r2_uint64 c   = 0;
+                for(r2_uint64 b = 0; b < RADIX; ++b){
+                        c = count[d][b];
+                        count[d][b] = pos;
+                        pos += c;
+                }
+
+                r2_uint64 *offset = count[d];
+                for(r2_uint64 i = 0; i < n; ++i)
+                        dest[offset[(src[i] >> shift) & (RADIX - 1)]++] = src[i];
+
+                r2_uint64 *temp = src; 
+                src  = dest;
+                dest = temp;
+        }
+
+        if(src != keys)
+                mcpy(keys, src, sizeof(r2_uint64) * n);
+        free(aux);
+}
+
+/**
+ * @brief               Sorts a sequence of unsigned integers in non-decreasing order using radix sort. 
+ * 
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ */
+void r2_radix_sort_u32(r2_uint32 *arr, r2_uint64 start, r2_uint64 as)
+{
+        if(as <= start + 1)
+                return;
+
+        r2_uint64 n = as - start;
+        r2_uint64 *keys = malloc(sizeof(r2_uint64) * n); 
+        assert(keys != NULL);
+        for(r2_uint64 i = 0; i < n; ++i)
+                keys[i] = arr[start + i];
+
+        radix_sort(keys, n);
+        for(r2_uint64 i = 0; i < n; ++i)
+                arr[start + i] = (r2_uint32)keys[i];
+        free(keys);
+}
+
+/**
+ * @brief               Sorts a sequence of unsigned 64 bit integers in non-decreasing order using radix sort. 
+ * 
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ */
+void r2_radix_sort_u64(r2_uint64 *arr, r2_uint64 start, r2_uint64 as)
+{
+        if(as <= start + 1)
+                return;
+        radix_sort(&arr[start], as - start);
+}
+
+/**
+ * @brief               Maps a signed integer to an unsigned key with the same order.
+ * 
+ * @param key           Key.
+ * @return r2_uint64    Returns unsigned key.
+ */
+r2_uint64 r2_radix_key_int64(r2_int64 key)
+{
+        return (r2_uint64)key ^ (1ULL << 63);
+}
+
+/**
+ * @brief               Maps a double to an unsigned key with the same order.
+ * 
+ * @param key           Key.
+ * @return r2_uint64    Returns unsigned key.
+ */
+r2_uint64 r2_radix_key_dbl(r2_dbl key)
+{
+        r2_uint64 bits = 0;
+        mcpy(&bits, &key, sizeof(r2_dbl));
+        return bits & (1ULL << 63)? ~bits : bits ^ (1ULL << 63);
+}
+
+/**
+ * @brief               Sorts a sequence of signed 64 bit integers in non-decreasing order using radix sort. 
+ * 
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ */
+void r2_radix_sort_int64(r2_int64 *arr, r2_uint64 start, r2_uint64 as)
+{
+        if(as <= start + 1)
+                return;
+
+        r2_uint64 n = as - start;
+        r2_uint64 *keys = malloc(sizeof(r2_uint64) * n); 
+        assert(keys != NULL);
+        for(r2_uint64 i = 0; i < n; ++i)
+                keys[i] = r2_radix_key_int64(arr[start + i]);
+
+        radix_sort(keys, n);
+        for(r2_uint64 i = 0; i < n; ++i)
+                arr[start + i] = (r2_int64)(keys[i] ^ (1ULL << 63));
+        free(keys);
+}
+
+/**
+ * @brief               Sorts a sequence of floats in non-decreasing order using radix sort. 
+ * 
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ */
+void r2_radix_sort_flt(float *arr, r2_uint64 start, r2_uint64 as)
+{
+        assert(sizeof(float) == sizeof(unsigned int));
+        if(as <= start + 1)
+                return;
+
+        r2_uint64 n = as - start;
+        r2_uint64 *keys = malloc(sizeof(r2_uint64) * n); 
+        unsigned int bits = 0;
+        assert(keys != NULL);
+        for(r2_uint64 i = 0; i < n; ++i){
+                mcpy(&bits, &arr[start + i], sizeof(float));
+                keys[i] = bits & 0x80000000u? ~bits : bits ^ 0x80000000u;
+        }
+
+        radix_sort(keys, n);
+        for(r2_uint64 i = 0; i < n; ++i){
+                bits = (unsigned int)keys[i];
+                bits = bits & 0x80000000u? bits ^ 0x80000000u : ~bits;
+                mcpy(&arr[start + i], &bits, sizeof(float));
+        }
+        free(keys);
+}
+
+/**
+ * @brief               Sorts a sequence of doubles in non-decreasing order using radix sort. 
+ * 
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ */
+void r2_radix_sort_dbl(r2_dbl *arr, r2_uint64 start, r2_uint64 as)
+{
+        if(as <= start + 1)
+                return;
+
+        r2_uint64 n = as - start;
+        r2_uint64 *keys = malloc(sizeof(r2_uint64) * n); 
+        r2_uint64 bits  = 0;
+        assert(keys != NULL);
+        for(r2_uint64 i = 0; i < n; ++i)
+                keys[i] = r2_radix_key_dbl(arr[start + i]);
+
+        radix_sort(keys, n);
+        for(r2_uint64 i = 0; i < n; ++i){
+                bits = keys[i] & (1ULL << 63)? keys[i] ^ (1ULL << 63) : ~keys[i];
+                mcpy(&arr[start + i], &bits, sizeof(r2_dbl));
+        }
+        free(keys);
+}
+
+/**
+ * @brief               Sorts a sequence in non-decreasing order of the keys returned by key using radix sort. 
+ *                      The sort is stable.
+ * 
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size. Example if we are sorting 10 records then array size should be 10.
+ * @param es            Element size.
+ * @param key           A callback function that returns the key of an element.
+ */
+void r2_radix_sort_key(void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, r2_key key)
+{
+        r2_key_sort(arr, start, as, es, key);
+}
+
+/**
+ * @brief               Sorts a sequence of C strings in lexicographic order using multikey quicksort (three-way radix quicksort).
+ *
+ *                      Strings are partitioned into three parts by their character at the current depth: smaller, equal 
+ *                      and greater than the pivot character. The smaller and greater parts are sorted at the same depth
+ *                      while the equal part moves on to the next character, so common prefixes are never compared twice.
+ *                      The characters at the current depth are cached next to the strings and moved with them, the strings
+ *                      are only read again when the depth changes. Characters are compared as unsigned.
+ *
+ * @param arr           Array of strings.
+ * @param start         Start.
+ * @param as            Array size.
+ */
+void r2_string_sort(char **arr, r2_uint64 start, r2_uint64 as)
+{
+        if(as <= start + 1)
+                return;
+
+        r2_uc *cache = malloc(sizeof(r2_uc) * (as - start));
+        assert(cache != NULL);
+        mkqs_sort(&arr[start], cache, as - start, 0, FALSE);
+        free(cache);
+}
+
+/**
+ * @brief               Sorts a sequence of C strings in lexicographic order using MSD radix sort.
+ *
+ *                      The strings are distributed into 256 buckets by their character at the current depth and every
+ *                      bucket is sorted at the next depth, except the bucket of strings that ended. Each pass reads the 
+ *                      characters once into a cache, then counts and distributes using the cache so every string is 
+ *                      dereferenced once per pass. Buckets of fewer than 32 strings are sorted with insertion sort and
+ *                      passes where every string has the same character are skipped.
+ *
+ * @param arr           Array of strings.
+ * @param start         Start.
+ * @param as            Array size.
+ */
+void r2_string_radix_sort(char **arr, r2_uint64 start, r2_uint64 as)
+{
+        if(as <= start + 1)
+                return;
+
+        r2_uint64 n  = as - start;
+        r2_uc *cache = malloc(sizeof(r2_uc) * n);
+        char **aux   = malloc(sizeof(char *) * n);
+        assert(cache != NULL && aux != NULL);
+        msd_sort(&arr[start], aux, cache, n, 0);
+        free(cache);
+        free(aux);
+}
+
+/**
+ * @brief               Compares two strings starting at depth.
+ *
+ * @param a             String.
+ * @param b             String.
+ * @param depth         Number of characters both strings share.
+ * @return r2_int16     Returns a negative number, zero or a positive number.
+ */
+static r2_int16 str_cmp(const char *a, const char *b, r2_uint64 depth)
+{
+        const r2_uc *c = (const r2_uc *)a + depth;
+        const r2_uc *d = (const r2_uc *)b + depth;
+        while(*c == *d && *c != 0){
+                ++c;
+                ++d;
+        }
+        return (r2_int16)*c - (r2_int16)*d;
+}
+
+/**
+ * @brief               Sorts strings that share their first depth characters with insertion sort.
+ *
+ * @param strs          Strings.
+ * @param n             Number of strings.
+ * @param depth         Number of characters all strings share.
+ */
+static void str_insertion_sort(char **strs, r2_uint64 n, r2_uint64 depth)
+{
+        char *t;
+        r2_uint64 j;
+        for(r2_uint64 i = 1; i < n; ++i){
+                t = strs[i];
+                for(j = i; j > 0 && str_cmp(t, strs[j - 1], depth) < 0; --j)
+                        strs[j] = strs[j - 1];
+                strs[j] = t;
+        }
+}
+
+/**
+ * @brief               Multikey quicksort.
+ *
+ * @param strs          Strings.
+ * @param cache         Characters of the strings at depth.
+ * @param n             Number of strings.
+ * @param depth         Number of characters all strings share.
+ * @param cached        TRUE when cache already holds the characters at depth.
+ */
+static void mkqs_sort(char **strs, r2_uc *cache, r2_uint64 n, r2_uint64 depth, r2_uint16 cached)
+{
+        r2_uint64 lt, gt, i;
+        r2_uc v, a, b, c;
+        char *t;
+        while(n > 1){
+                if(n < CUT_OFF){
+                        str_insertion_sort(strs, n, depth);
+                        return;
+                }
+
+                if(cached == FALSE)
+                        for(i = 0; i < n; ++i)
+                                cache[i] = (r2_uc)strs[i][depth];
+
+                /*Median of three characters.*/
+                a = cache[0];
+                b = cache[n/2];
+                c = cache[n - 1];
+                v = a < b? (b < c? b : (a < c? c : a)) : (a < c? a : (b < c? c : b));
+
+                /*Dijkstra's three way partition, strings move with their characters.*/
+                lt = 0;
+                gt = n;
+                i  = 0;
+                while(i < gt){
+                        if(cache[i] < v){
+                                t         = strs[i];
+                                strs[i]   = strs[lt];
+                                strs[lt]  = t;
+                                c         = cache[i];
+                                cache[i]  = cache[lt];
+                                cache[lt] = c;
+                                ++lt;
+                                ++i;
+                        }else if(cache[i] > v){
+                                --gt;
+                                t         = strs[i];
+                                strs[i]   = strs[gt];
+                                strs[gt]  = t;
+                                c         = cache[i];
+                                cache[i]  = cache[gt];
+                                cache[gt] = c;
+                        }else   ++i;
+                }
+
+                mkqs_sort(strs, cache, lt, depth, TRUE);
+                mkqs_sort(&strs[gt], &cache[gt], n - gt, depth, TRUE);
+
+                /*Strings equal to the pivot ended when the pivot is the terminator.*/
+                if(v == 0)
+                        return;
+
+                strs   = &strs[lt];
+                cache  = &cache[lt];
+                n      = gt - lt;
+                depth  = depth + 1;
+                cached = FALSE;
+        }
+}
+
+/**
+ * @brief               MSD radix sort.
+ *
+ * @param strs          Strings.
+ * @param aux           Auxiliary array.
+ * @param cache         Characters of the strings at depth.
+ * @param n             Number of strings.
+ * @param depth         Number of characters all strings share.
+ */
+static void msd_sort(char **strs, char **aux, r2_uc *cache, r2_uint64 n, r2_uint64 depth)
+{
+        r2_uint64 count[RADIX];
+        r2_uint64 sum, c, big;
+        while(n > 1){
+                if(n < CUT_OFF){
+                        str_insertion_sort(strs, n, depth);
+                        return;
+                }
+
+                memset(count, 0, sizeof(count));
+                for(r2_uint64 i = 0; i < n; ++i){
+                        cache[i] = (r2_uc)strs[i][depth];
+                        ++count[cache[i]];
+                }
+
+                /*Every string has the same character.*/
+                if(count[cache[0]] == n){
+                        if(cache[0] == 0)
+                                return;
+                        ++depth;
+                        continue;
+                }
+
+                sum = 0;
+                for(r2_uint64 r = 0; r < RADIX; ++r){
+                        c = count[r];
+                        count[r] = sum;
+                        sum += c;
+                }
+
+                for(r2_uint64 i = 0; i < n; ++i)
+                        aux[count[cache[i]]++] = strs[i];
+                mcpy(strs, aux, sizeof(char *) * n);
+
+                /*
+                 * count[r] is now the end of bucket r, bucket 0 holds the strings that ended. The largest bucket
+                 * is sorted by the loop instead of a recursive call, every recursive call gets at most half of
+                 * the strings so strings sharing a long prefix can't overflow the stack.
+                 */
+                big = 1;
+                for(r2_uint64 r = 2; r < RADIX; ++r)
+                        if(count[r] - count[r - 1] > count[big] - count[big - 1])
+                                big = r;
+
+                for(r2_uint64 r = 1; r < RADIX; ++r)
+                        if(r != big && count[r] - count[r - 1] > 1)
+                                msd_sort(&strs[count[r - 1]], aux, cache, count[r] - count[r - 1], depth + 1);
+
+                strs  = &strs[count[big - 1]];
+                n     = count[big] - count[big - 1];
+                depth = depth + 1;
+        }
+}
+
+/**
+ * @brief               Returns the permutation that sorts a sequence in non-decreasing order without moving any element.
+ *                      Positions are sorted with a stable merge sort that compares the elements they refer to.
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ * @param es            Element size.
+ * @param cmp           A callback comparison function that compares two elements a and b.
+ * @return r2_uint64*   Returns an array of as - start positions, the element at arr[perm[i]] belongs at arr[start + i].
+ *                      The caller frees it.
+ */
+r2_uint64* r2_argsort(const void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, r2_cmp cmp)
+{
+        r2_uint64 n = as > start? as - start : 0;
+        r2_uint64 *perm = malloc(sizeof(r2_uint64) * (n + 1));
+        r2_uint64 *aux  = malloc(sizeof(r2_uint64) * (n + 1));
+        assert(perm != NULL && aux != NULL);
+        for(r2_uint64 i = 0; i < n; ++i)
+                perm[i] = start + i;
+
+        arg_sort(arr, perm, aux, 0, n, es, cmp);
+        free(aux);
+        return perm;
+}
+
+/**
+ * @brief               Returns the permutation that sorts a sequence of records by an unsigned key. Every key is
+ *                      extracted once and stored next to its position, then the (key, position) pairs are sorted with radix sort.
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ * @param es            Element size.
+ * @param key           A callback function that returns the key of a record.
+ * @return r2_uint64*   Returns an array of as - start positions, the element at arr[perm[i]] belongs at arr[start + i].
+ *                      The caller frees it.
+ */
+r2_uint64* r2_key_argsort(const void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, r2_key key)
+{
+        const char *seq = arr;
+        r2_uint64 n = as > start? as - start : 0;
+        r2_uint64 *perm = malloc(sizeof(r2_uint64) * (n + 1));
+        struct r2_kv *pairs = malloc(sizeof(struct r2_kv) * (n + 1));
+        assert(perm != NULL && pairs != NULL);
+        for(r2_uint64 i = 0; i < n; ++i){
+                pairs[i].key = key(&seq[(start + i)*es]);
+                pairs[i].pos = start + i;
+        }
+
+        kv_radix_sort(pairs, n);
+        for(r2_uint64 i = 0; i < n; ++i)
+                perm[i] = pairs[i].pos;
+        free(pairs);
+        return perm;
+}
+
+/**
+ * @brief               Sorts a sequence of records by an unsigned key. The (key, position) pairs are sorted and then every
+ *                      record is moved once, so large records are never moved during the sort. The sort is stable.
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ * @param es            Element size.
+ * @param key           A callback function that returns the key of a record.
+ */
+void r2_key_sort(void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, r2_key key)
+{
+        if(as <= start + 1)
+                return;
+
+        r2_uint64 *perm = r2_key_argsort(arr, start, as, es, key);
+        r2_permute(arr, start, as, es, perm);
+        free(perm);
+}
+
+/**
+ * @brief               Rearranges a sequence so that arr[start + i] becomes the element that was at arr[perm[i]].
+ *                      The permutation is applied one cycle at a time, every element is moved once and only
+ *                      one element is buffered.
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ * @param es            Element size.
+ * @param perm          Permutation of the positions start...as-1.
+ */
+void r2_permute(void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, const r2_uint64 *perm)
+{
+        if(as <= start + 1)
+                return;
+
+        char *seq = arr;
+        r2_uint64 n = as - start;
+        r2_uc *done = calloc(n/8 + 1, sizeof(r2_uc));/*one bit per position*/
+        char *tmp   = malloc(es);
+        r2_uint64 j, k;
+        assert(done != NULL && tmp != NULL);
+        for(r2_uint64 i = 0; i < n; ++i){
+                if((done[i/8] & (1 << (i % 8))) != 0 || perm[i] == start + i)
+                        continue;
+
+                mcpy(tmp, &seq[(start + i)*es], es);
+                for(j = i;; j = k){
+                        done[j/8] |= 1 << (j % 8);
+                        k = perm[j] - start;
+                        if(k == i)
+                                break;
+                        mcpy(&seq[(start + j)*es], &seq[(start + k)*es], es);
+                }
+                mcpy(&seq[(start + j)*es], tmp, es);
+        }
+
+        free(done);
+        free(tmp);
+}
+
+/**
+ * @brief               Stable merge sort of positions.
+ *
+ * @param arr           Array the positions refer to.
+ * @param perm          Positions.
+ * @param aux           Auxiliary array.
+ * @param lo            Start.
+ * @param hi            End.
+ * @param es            Element size.
+ * @param cmp           A comparison callback function.
+ */
+static void arg_sort(const char *arr, r2_uint64 *perm, r2_uint64 *aux, r2_uint64 lo, r2_uint64 hi, r2_uint64 es, r2_cmp cmp)
+{
+        r2_uint64 mid, i, j, k, t;
+        if(hi - lo <= CUT_OFF){
+                for(i = lo + 1; i < hi; ++i){
+                        t = perm[i];
+                        for(j = i; j > lo && cmp(&arr[t*es], &arr[perm[j - 1]*es]) < 0; --j)
+                                perm[j] = perm[j - 1];
+                        perm[j] = t;
+                }
+                return;
+        }
+
+        mid = lo + (hi - lo)/2;
+        arg_sort(arr, perm, aux, lo, mid, es, cmp);
+        arg_sort(arr, perm, aux, mid, hi, es, cmp);
+        if(cmp(&arr[perm[mid - 1]*es], &arr[perm[mid]*es]) <= 0)
+                return;
+
+        mcpy(&aux[lo], &perm[lo], sizeof(r2_uint64) * (mid - lo));
+        for(i = lo, j = mid, k = lo; i < mid && j < hi; ++k){
+                if(cmp(&arr[perm[j]*es], &arr[aux[i]*es]) < 0)
+                        perm[k] = perm[j++];
+                else    perm[k] = aux[i++];
+        }
+        while(i < mid)
+                perm[k++] = aux[i++];
+}
+
+/**
+ * @brief               Sorts (key, position) pairs by key using LSD radix sort. Pairs are moved together so every pass
+ *                      reads and writes one array.
+ *
+ * @param pairs         Pairs.
+ * @param n             Number of pairs.
+ */
+static void kv_radix_sort(struct r2_kv *pairs, r2_uint64 n)
+{
+        r2_uint64 count[DIGITS][RADIX] = {0};
+        r2_uint64 sum, c;
+        struct r2_kv *src = pairs, *dest, *t;
+        struct r2_kv *buf;
+        if(n < 2)
+                return;
+
+        buf = malloc(sizeof(struct r2_kv) * n);
+        assert(buf != NULL);
+        dest = buf;
+        for(r2_uint64 i = 0; i < n; ++i)
+                for(r2_uint64 d = 0; d < DIGITS; ++d)
+                        ++count[d][(src[i].key >> (8*d)) & 0xFF];
+
+        for(r2_uint64 d = 0; d < DIGITS; ++d){
+                /*Every key has the same digit.*/
+                if(count[d][(src[0].key >> (8*d)) & 0xFF] == n)
+                        continue;
+
+                sum = 0;
+                for(r2_uint64 r = 0; r < RADIX; ++r){
+                        c = count[d][r];
+                        count[d][r] = sum;
+                        sum += c;
+                }
+
+                for(r2_uint64 i = 0; i < n; ++i)
+                        dest[count[d][(src[i].key >> (8*d)) & 0xFF]++] = src[i];
+                t    = src;
+                src  = dest;
+                dest = t;
+        }
+
+        if(src != pairs)
+                mcpy(pairs, src, sizeof(struct r2_kv) * n);
+        free(buf);
+}
+
+/**
+ * @brief               Sets the number of threads used by the parallel sorts.
+ * 
+ * @param threads       Number of threads. 0 uses one thread per processor.
+ */
+void r2_sort_set_threads(r2_uint64 threads)
+{
+        nthreads = threads;
+}
+
+/**
+ * @brief               Returns the number of threads used by the parallel sorts.
+ * 
+ * @return r2_uint64    Number of threads.
+ */
+r2_uint64 r2_sort_threads()
+{
+        r2_uint64 threads = nthreads;
+        if(threads == 0){
+                #if defined(_WIN32)
+                        SYSTEM_INFO info;
+                        GetSystemInfo(&info);
+                        threads = info.dwNumberOfProcessors;
+                #else
+                        r2_int64 cpus = sysconf(_SC_NPROCESSORS_ONLN);
+                        threads = cpus > 0? cpus : 1;
+                #endif
+        }
+        return threads;
+}
+
+/**
+ * @brief               Creates the state shared by the threads of a parallel sort.
+ * 
+ * @param ps            Parallel sort.
+ * @param arr           Array. 
+ * @param aux           Auxiliary array.
+ * @param n             Number of elements to sort.
+ * @param es            Element size.
+ * @param cmp           A comparison callback function.
+ */
+static void pinit(struct r2_psort *ps, void *arr, void *aux, r2_uint64 n, r2_uint64 es, r2_cmp cmp)
+{
+        r2_uint64 threads = r2_sort_threads();
+        ps->arr   = arr; 
+        ps->aux   = aux;
+        ps->es    = es; 
+        ps->cmp   = cmp;
+        ps->idle  = threads - 1;
+        /*Each thread gets a few tasks so that an unlucky split doesn't leave the others idle.*/
+        ps->grain = n / (threads * 8);
+        if(ps->grain < PAR_CUT_OFF)
+                ps->grain = PAR_CUT_OFF;
+        #if defined(_WIN32)
+                InitializeSRWLock(&ps->lock);
+        #else
+                pthread_mutex_init(&ps->lock, NULL);
+        #endif
+}
+
+/**
+ * @brief               Releases the state shared by the threads of a parallel sort.
+ * 
+ * @param ps            Parallel sort.
+ */
+static void pfree(struct r2_psort *ps)
+{
+        #if !defined(_WIN32)
+                pthread_mutex_destroy(&ps->lock);
+        #endif
+}
+
+/**
+ * @brief               Takes or returns an idle worker.
+ * 
+ * @param ps            Parallel sort.
+ * @param take          TRUE takes a worker and FALSE returns one.
+ * @return r2_uint16    Returns TRUE whenever a worker was taken or returned, else FALSE.
+ */
+static r2_uint16 pworker(struct r2_psort *ps, r2_uint16 take)
+{
+        r2_uint16 SUCCESS = TRUE;
+        #if defined(_WIN32)
+                AcquireSRWLockExclusive(&ps->lock);
+        #else
+                pthread_mutex_lock(&ps->lock);
+        #endif
+        if(take == FALSE)
+                ++ps->idle;
+        else if(ps->idle > 0)
+                --ps->idle;
+        else
+                SUCCESS = FALSE;
+        #if defined(_WIN32)
+                ReleaseSRWLockExclusive(&ps->lock);
+        #else
+                pthread_mutex_unlock(&ps->lock);
+        #endif
+        return SUCCESS;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI pstart(LPVOID arg)
+{
+        struct r2_ptask *task = arg;
+        task->fn(task);
+        return 0;
+}
+#else
+static void* pstart(void *arg)
+{
+        struct r2_ptask *task = arg;
+        task->fn(task);
+        return NULL;
+}
+#endif
+
+/**
+ * @brief               Performs a task on another thread if a worker is idle, else performs it immediately.
+ *                      Every task must be joined with pjoin.
+ * 
+ * @param task          Task.
+ * @param pt            Thread performing the task.
+ */
+static void pfork(struct r2_ptask *task, struct r2_pthread *pt)
+{
+        pt->spawned = FALSE;
+        if(pworker(task->ps, TRUE) == TRUE){
+                #if defined(_WIN32)
+                        pt->thread  = CreateThread(NULL, 0, pstart, task, 0, NULL);
+                        pt->spawned = pt->thread != NULL;
+                #else
+                        pt->spawned = pthread_create(&pt->thread, NULL, pstart, task) == 0;
+                #endif
+                if(pt->spawned == FALSE)
+                        pworker(task->ps, FALSE);
+        }
+
+        if(pt->spawned == FALSE)
+                task->fn(task);
+}
+
+/**
+ * @brief               Waits for a task to finish.
+ * 
+ * @param task          Task.
+ * @param pt            Thread performing the task.
+ */
+static void pjoin(struct r2_ptask *task, struct r2_pthread *pt)
+{
+        if(pt->spawned == TRUE){
+                #if defined(_WIN32)
+                        WaitForSingleObject(pt->thread, INFINITE);
+                        CloseHandle(pt->thread);
+                #else
+                        pthread_join(pt->thread, NULL);
+                #endif
+                pworker(task->ps, FALSE);
+                pt->spawned = FALSE;
+        }
+}
+
+/**
+ * @brief               Sorts a sequence in non-decreasing order using a parallel mergesort. 
+ *                      Both halves are sorted in parallel and then merged in parallel. A merge
+ *                      is split in two independent merges by taking the middle element of the larger
+ *                      run and finding where it lands in the other run with a binary search. The sort is stable.
+ *          
+ * @param arr           Array. 
+ * @param start         Start.
+ * @param as            Array size. Example if we are sorting 10 numbers then array size should be 10.
+ * @param es            Element size. Example if we're sorting an array of 4 byte integers
+ *                      then es should be equal to 4.
+ * @param cmp           A callback comparison function that compares two elements a and b.
+ */
+void r2_pmerge_sort(void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, r2_cmp cmp)
+{
+        if(as <= start + 1)
+                return;
+
+        struct r2_psort ps;
+        struct r2_ptask task;
+        char *seq = malloc(es * as); 
+        assert(seq != NULL);
+        pinit(&ps, arr, seq, as - start, es, cmp);
+        task.fn   = pmerge_sort;
+        task.ps   = &ps;
+        task.lo   = start; 
+        task.hi   = as - 1;
+        task.flag = FALSE;
+        pmerge_sort(&task);
+        pfree(&ps);
+        free(seq);
+        is_sorted(arr, start, as, es, cmp);
+}
+
+/**
+ * @brief               Helper function for parallel mergesort.
+ *                      Sorts arr[lo...hi] and leaves the result in the auxiliary array when flag is TRUE,
+ *                      else in the array.
+ * 
+ * @param task          Task.
+ */
+static void pmerge_sort(struct r2_ptask *task)
+{
+        struct r2_psort *ps = task->ps;
+        r2_int64 lo = task->lo; 
+        r2_int64 hi = task->hi;
+        r2_uint64 es = ps->es;
+        if((r2_uint64)(hi - lo + 1) <= ps->grain){
+                merge_sort_mod(ps->arr, ps->aux, lo, hi, es, ps->cmp);
+                if(task->flag == TRUE)
+                        mcpy(&ps->aux[lo*es], &ps->arr[lo*es], (hi - lo + 1)*es);
+                return;
+        }
+
+        r2_int64 mid = lo + (hi - lo) / 2;
+        struct r2_pthread pt;
+        struct r2_ptask left  = *task;
+        struct r2_ptask right = *task;
+        /*The halves are left in the other array so that merging puts the result where it belongs.*/
+        left.hi    = mid;
+        left.flag  = !task->flag;
+        right.lo   = mid + 1;
+        right.flag = !task->flag;
+        pfork(&left, &pt); 
+        pmerge_sort(&right);
+        pjoin(&left, &pt);
+
+        struct r2_ptask merge = *task;
+        merge.fn   = pmerge;
+        merge.src  = task->flag == TRUE? ps->arr : ps->aux; 
+        merge.dest = task->flag == TRUE? ps->aux : ps->arr;
+        merge.lo   = lo;
+        merge.hi   = mid;
+        merge.lo2  = mid + 1; 
+        merge.hi2  = hi; 
+        merge.out  = lo;
+        pmerge(&merge);
+}
+
+/**
+ * @brief               Merges src[lo...hi] and src[lo2...hi2] into dest starting at out.
+ *                      
+ * @param task          Task.
+ */
+static void pmerge(struct r2_ptask *task)
+{
+        struct r2_psort *ps = task->ps;
+        r2_uint64 es = ps->es;
+        r2_cmp cmp   = ps->cmp;
+        char *src    = task->src; 
+        char *dest   = task->dest; 
+        r2_int64 lo  = task->lo, hi  = task->hi;
+        r2_int64 lo2 = task->lo2, hi2 = task->hi2;
+        r2_int64 n1  = hi - lo + 1;
+        r2_int64 n2  = hi2 - lo2 + 1;
+        r2_int64 out = task->out;
+
+        if((r2_uint64)(n1 + n2) <= ps->grain){
+                while(lo <= hi && lo2 <= hi2){
+                        if(cmp(&src[lo*es], &src[lo2*es]) <= 0)
+                                cpy(&src[(lo++)*es], &dest[(out++)*es], es);
+                        else    
+                                cpy(&src[(lo2++)*es], &dest[(out++)*es], es);
+                }
+                if(lo <= hi)
+                        mcpy(&dest[out*es], &src[lo*es], (hi - lo + 1)*es);
+                else if(lo2 <= hi2)
+                        mcpy(&dest[out*es], &src[lo2*es], (hi2 - lo2 + 1)*es);
+                return;
+        }
+
+        r2_int64 q1, q2;
+        r2_int64 l, r;
+        struct r2_pthread pt;
+        struct r2_ptask left  = *task;
+        struct r2_ptask right = *task;
+        if(n1 >= n2){
+                /*Elements of the second run that are equal to the split go after it to keep the merge stable.*/
+                q1 = lo + (hi - lo) / 2;
+                for(l = lo2, r = hi2 + 1; l < r;){
+                        q2 = l + (r - l) / 2;
+                        if(cmp(&src[q2*es], &src[q1*es]) < 0)
+                                l = q2 + 1;
+                        else    r = q2;
+                }
+                q2 = l;
+                out = out + (q1 - lo) + (q2 - lo2);
+                cpy(&src[q1*es], &dest[out*es], es);
+                left.hi   = q1 - 1;
+                left.hi2  = q2 - 1;
+                right.lo  = q1 + 1; 
+                right.lo2 = q2;
+        }else{
+                /*Elements of the first run that are equal to the split go before it to keep the merge stable.*/
+                q2 = lo2 + (hi2 - lo2) / 2;
+                for(l = lo, r = hi + 1; l < r;){
+                        q1 = l + (r - l) / 2;
+                        if(cmp(&src[q1*es], &src[q2*es]) <= 0)
+                                l = q1 + 1;
+                        else    r = q1;
+                }
+                q1 = l;
+                out = out + (q1 - lo) + (q2 - lo2);
+                cpy(&src[q2*es], &dest[out*es], es);
+                left.hi   = q1 - 1;
+                left.hi2  = q2 - 1;
+                right.lo  = q1;
+                right.lo2 = q2 + 1;
+        }
+        right.out = out + 1;
+        pfork(&left, &pt);
+        pmerge(&right);
+        pjoin(&left, &pt);
+}
+
+/**
+ * @brief               Sorts a sequence in non-decreasing order using a parallel quicksort. 
+ *                      Large ranges are partitioned in parallel: the range is split in blocks that are partitioned 
+ *                      around the same pivot at the same time and then the misplaced elements are swapped into place.
+ *                      Both sides of a partition are sorted in parallel. We use the median of three as pivot 
+ *                      and insertion sort for small subarrays.
+ *          
+ * @param arr           Array. 
+ * @param start         Start.
+ * @param as            Array size. Example if we are sorting 10 numbers then array size should be 10.
+ * @param es            Element size. Example if we're sorting an array of 4 byte integers
+ *                      then es should be equal to 4.
+ * @param cmp           A callback comparison function that compares two elements a and b.
+ */
+void r2_pquick_sort(void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, r2_cmp cmp)
+{
+        if(as <= start + 1)
+                return;
+
+        struct r2_psort ps;
+        struct r2_ptask task;
+        pinit(&ps, arr, NULL, as - start, es, cmp);
+        task.fn  = pquick_sort;
+        task.ps  = &ps;
+        task.lo  = start;
+        task.hi  = as;
+        pquick_sort(&task);
+        pfree(&ps);
+        is_sorted(arr, start, as, es, cmp);
+}
+
+/**
+ * @brief               Helper function for parallel quicksort. Sorts arr[lo...hi-1].
+ * 
+ * @param task          Task.
+ */
+static void pquick_sort(struct r2_ptask *task)
+{
+        struct r2_psort *ps = task->ps;
+        r2_uint64 es = ps->es;
+        char *arr  = ps->arr;
+        r2_int64 lo = task->lo; 
+        r2_int64 hi = task->hi;
+        char buffer[64] = {0};
+        char *pivot = buffer;
+        if(es > 64)
+                pivot = malloc(sizeof(char) *es);
+        assert(pivot != NULL);
+
+        struct r2_pthread pt;
+        struct r2_ptask side;
+        struct r2_ptask part  = *task;
+        part.fn    = ppartition;
+        part.pivot = pivot;
+        while(hi - lo > CUT_OFF){
+                /*Ranges too small to share with another thread are finished sequentially.*/
+                if((r2_uint64)(hi - lo) < ps->grain){
+                        pdq_sort(arr, lo, hi, es, ps->cmp);
+                        lo = hi;
+                        break;
+                }
+
+                /*The pivot is copied because the partition moves elements around.*/
+                cpy(&arr[median_of_three(arr, lo, lo + (hi - lo)/2, hi - 1, es, ps->cmp)*es], pivot, es);
+                part.lo   = lo; 
+                part.hi   = hi;
+                part.flag = TRUE;
+                ppartition(&part);
+                if(part.out == lo){
+                        /*Nothing is smaller than the pivot so we put everything equal to it on the left, that's already sorted.*/
+                        part.flag = FALSE;
+                        ppartition(&part);
+                        lo = part.out;
+                        continue;
+                }
+
+                side = *task;
+                if(part.out - lo <= hi - part.out){
+                        side.lo = lo;
+                        side.hi = part.out;
+                        lo = part.out;
+                }else{
+                        side.lo = part.out; 
+                        side.hi = hi;
+                        hi = part.out;
+                }
+                
+                /*We recurse on the smaller side and loop on the larger side.*/
+                if((r2_uint64)(side.hi - side.lo) >= ps->grain){
+                        struct r2_ptask rest = *task;
+                        rest.lo = lo; 
+                        rest.hi = hi;
+                        pfork(&side, &pt);
+                        pquick_sort(&rest);
+                        pjoin(&side, &pt);
+                        lo = hi;
+                        break;
+                }
+                pquick_sort(&side);
+        }
+
+        if(hi - lo > 1)
+                r2_insertion_sort(arr, lo, hi, es, ps->cmp);
+
+        if(pivot != buffer)
+                free(pivot);
+}
+
+/**
+ * @brief               Partitions arr[lo...hi-1] around pivot and stores the start of the right side in out.
+ *                      Elements smaller than pivot go to the left when flag is TRUE, else elements smaller 
+ *                      than or equal to the pivot go to the left.
+ * 
+ * @param task          Task.
+ */
+static void ppartition(struct r2_ptask *task)
+{
+        struct r2_psort *ps = task->ps;
+        r2_uint64 es = ps->es;
+        char *arr    = ps->arr;
+        r2_int64 lo  = task->lo; 
+        r2_int64 hi  = task->hi;
+        r2_uint64 nblocks = (hi - lo) / ps->grain;
+        r2_uint64 threads = r2_sort_threads();
+        if(nblocks > threads)
+                nblocks = threads;
+
+        if(nblocks <= 1){
+                task->out = partition_block(arr, lo, hi, es, task->pivot, task->flag, ps->cmp);
+                return;
+        }
+
+        struct r2_ptask *blocks = malloc(sizeof(struct r2_ptask) * nblocks);
+        struct r2_pthread *pts  = malloc(sizeof(struct r2_pthread) * nblocks);
+        assert(blocks != NULL && pts != NULL);
+        r2_int64 size = (hi - lo) / nblocks;
+        for(r2_uint64 i = 0; i < nblocks; ++i){
+                blocks[i]    = *task;
+                blocks[i].fn = pblock; 
+                blocks[i].lo = lo + (r2_int64)i*size;
+                blocks[i].hi = i == nblocks - 1? hi : lo + (r2_int64)(i + 1)*size;
+        }
+
+        for(r2_uint64 i = 0; i < nblocks - 1; ++i)
+                pfork(&blocks[i], &pts[i]);
+        pblock(&blocks[nblocks - 1]);
+        
+        r2_int64 mid = lo;/*start of the right side*/
+        for(r2_uint64 i = 0; i < nblocks; ++i){
+                if(i < nblocks - 1)
+                        pjoin(&blocks[i], &pts[i]);
+                mid += blocks[i].out - blocks[i].lo;
+        }
+
+        /**
+         * Every block now looks like [left|right]. The right parts of the blocks that lie before mid
+         * have to be swapped with the left parts of the blocks that lie after mid. 
+         */
+        r2_uint64 b = 0, l = 0;
+        r2_int64 bs = 0, be = 0;/*range of right elements before mid*/
+        r2_int64 ls = 0, le = 0;/*range of left elements after mid*/
+        r2_int64 count = 0;
+        for(;;){
+                for(;bs == be && b < nblocks; ++b){
+                        bs = blocks[b].out; 
+                        be = blocks[b].hi < mid? blocks[b].hi : mid;
+                        if(bs > be)
+                                bs = be;
+                }
+
+                for(;ls == le && l < nblocks; ++l){
+                        ls = blocks[l].lo > mid? blocks[l].lo : mid;
+                        le = blocks[l].out;
+                        if(ls > le)
+                                ls = le;
+                }
+
+                if(bs == be || ls == le)
+                        break;
+
+                count = (be - bs) < (le - ls)? (be - bs) : (le - ls);
+                swap(&arr[bs*es], &arr[ls*es], count*es);
+                bs += count; 
+                ls += count;
+        }
+        task->out = mid;
+        free(blocks);
+        free(pts);
+}
+
+/**
+ * @brief               Partitions a single block of a parallel partition.
+ * 
+ * @param task          Task.
+ */
+static void pblock(struct r2_ptask *task)
+{
+        task->out = partition_block(task->ps->arr, task->lo, task->hi, task->ps->es, task->pivot, task->flag, task->ps->cmp);
+}
+
+/**
+ * @brief               Partitions arr[lo...hi-1] around pivot.
+ * 
+ * @param arr           Array.
+ * @param lo            Start.
+ * @param hi            End.
+ * @param es            Element size.
+ * @param pivot         Pivot.
+ * @param strict        When TRUE elements smaller than pivot go left, else elements smaller than or equal to pivot.
+ * @param cmp           A comparison callback function.
+ * @return r2_int64     Returns the start of the right side.
+ */
+static r2_int64 partition_block(char *arr, r2_int64 lo, r2_int64 hi, r2_uint64 es, const char *pivot, r2_uint16 strict, r2_cmp cmp)
+{
+        r2_int16 bound = strict == TRUE? 0 : 1;/*an element goes left when cmp(element, pivot) < bound*/
+        r2_int64 l = lo;
+        r2_int64 r = hi - 1;
+        for(;;){
+                while(l <= r && cmp(&arr[l*es], pivot) < bound)
+                        ++l;
+                while(l <= r && cmp(&arr[r*es], pivot) >= bound)
+                        --r;
+                if(l >= r)
+                        break;
+                swap(&arr[l*es], &arr[r*es], es);
+                ++l; 
+                --r;
+        }
+        return l;
+}
+
+/**
+ * @brief               Limits the instruction set used by the SIMD sorts.
+ *
+ * @param level         R2_SORT_SCALAR, R2_SORT_AVX2 or R2_SORT_AVX512.
+ */
+void r2_sort_set_simd(r2_uint16 level)
+{
+        simd_max = level;
+}
+
+/**
+ * @brief               Returns the instruction set used by the SIMD sorts. This is the best one supported
+ *                      by the processor and the operating system that's allowed by r2_sort_set_simd.
+ *
+ * @return r2_uint16    R2_SORT_SCALAR, R2_SORT_AVX2 or R2_SORT_AVX512.
+ */
+r2_uint16 r2_sort_simd()
+{
+        r2_uint16 cpu   = r2_cpu_simd();
+        r2_uint16 level = cpu == R2_CPU_AVX512? R2_SORT_AVX512 : (cpu == R2_CPU_AVX2? R2_SORT_AVX2 : R2_SORT_SCALAR);
+        return level < simd_max? level : simd_max;
+}
+
+/**
+ * @brief               Sorts a sequence of 32 bit integers in non-decreasing order using SIMD instructions.
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ */
+void r2_simd_sort_i32(r2_int32 *arr, r2_uint64 start, r2_uint64 as)
+{
+        if(as <= start + 1)
+                return;
+
+        /*r2_int32 is 8 bytes wide on LP64 systems.*/
+        if(sizeof(r2_int32) == sizeof(int))
+                sort32((int *)&arr[start], as - start);
+        else    sort64((r2_int64 *)&arr[start], as - start);
+}
+
+/**
+ * @brief               Sorts a sequence of 64 bit integers in non-decreasing order using SIMD instructions.
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ */
+void r2_simd_sort_i64(r2_int64 *arr, r2_uint64 start, r2_uint64 as)
+{
+        if(as <= start + 1)
+                return;
+
+        sort64(&arr[start], as - start);
+}
+
+/**
+ * @brief               Sorts a sequence of floats in non-decreasing order using SIMD instructions.
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ */
+void r2_simd_sort_flt(float *arr, r2_uint64 start, r2_uint64 as)
+{
+        assert(sizeof(float) == sizeof(int));
+        if(as <= start + 1)
+                return;
+
+        r2_uint64 n = as - start;
+        flt_order(&arr[start], n);
+        sort32((int *)&arr[start], n);
+        flt_order(&arr[start], n);
+}
+
+/**
+ * @brief               Sorts a sequence of doubles in non-decreasing order using SIMD instructions.
+ *
+ * @param arr           Array.
+ * @param start         Start.
+ * @param as            Array size.
+ */
+void r2_simd_sort_dbl(r2_dbl *arr, r2_uint64 start, r2_uint64 as)
+{
+        assert(sizeof(r2_dbl) == sizeof(r2_int64));
+        if(as <= start + 1)
+                return;
+
+        r2_uint64 n = as - start;
+        dbl_order(&arr[start], n);
+        sort64((r2_int64 *)&arr[start], n);
+        dbl_order(&arr[start], n);
+}
+
+/**
+ * @brief               Maps floats to integers that sort in the same order and back. Negative floats have every bit
+ *                      but the sign bit flipped, so -0 comes before 0 and NaNs end up at the ends according to their sign bit.
+ *
+ * @param arr           Array.
+ * @param n             Number of elements.
+ */
+static void flt_order(float *arr, r2_uint64 n)
+{
+        int bits;
+        for(r2_uint64 i = 0; i < n; ++i){
+                mcpy(&bits, &arr[i], sizeof(int));
+                bits ^= (int)((unsigned int)(bits >> 31) >> 1);
+                mcpy(&arr[i], &bits, sizeof(int));
+        }
+}
+
+/**
+ * @brief               Maps doubles to integers that sort in the same order and back.
+ *
+ * @param arr           Array.
+ * @param n             Number of elements.
+ */
+static void dbl_order(r2_dbl *arr, r2_uint64 n)
+{
+        r2_int64 bits;
+        for(r2_uint64 i = 0; i < n; ++i){
+                mcpy(&bits, &arr[i], sizeof(r2_int64));
+                bits ^= (r2_int64)((r2_uint64)(bits >> 63) >> 1);
+                mcpy(&arr[i], &bits, sizeof(r2_int64));
+        }
+}
+
+/**
+ * @brief               Returns the number of partitions allowed before falling back to radix sort.
+ *
+ * @param n             Number of elements.
+ * @return r2_uint64    2*log2(n).
+ */
+static r2_uint64 simd_depth(r2_uint64 n)
+{
+        r2_uint64 depth = 0;
+        for(;n > 1; n >>= 1)
+                depth += 2;
+        return depth;
+}
+
+/**
+ * @brief               Sorts 32 bit integers using the best instruction set available.
+ *
+ * @param arr           Array.
+ * @param n             Number of elements.
+ */
+static void sort32(int *arr, r2_uint64 n)
+{
+        #if defined(R2_SORT_SIMD)
+                r2_uint16 level = r2_sort_simd();
+                if(level != R2_SORT_SCALAR){
+                        simd_sort32(arr, 0, n, simd_depth(n), level);
+                        return;
+                }
+        #endif
+        scalar_sort32(arr, n);
+}
+
+/**
+ * @brief               Sorts 64 bit integers using the best instruction set available.
+ *
+ * @param arr           Array.
+ * @param n             Number of elements.
+ */
+static void sort64(r2_int64 *arr, r2_uint64 n)
+{
+        #if defined(R2_SORT_SIMD)
+                r2_uint16 level = r2_sort_simd();
+                if(level != R2_SORT_SCALAR){
+                        simd_sort64(arr, 0, n, simd_depth(n), level);
+                        return;
+                }
+        #endif
+        r2_radix_sort_int64(arr, 0, n);
+}
+
+/**
+ * @brief               Scalar fallback for 32 bit integers, sorts them with radix sort.
+ *
+ * @param arr           Array.
+ * @param n             Number of elements.
+ */
+static void scalar_sort32(int *arr, r2_uint64 n)
+{
+        r2_uint64 *keys = malloc(sizeof(r2_uint64) * n);
+        assert(keys != NULL);
+        for(r2_uint64 i = 0; i < n; ++i)
+                keys[i] = (unsigned int)arr[i] ^ 0x80000000u;
+
+        radix_sort(keys, n);
+        for(r2_uint64 i = 0; i < n; ++i)
+                arr[i] = (int)((unsigned int)keys[i] ^ 0x80000000u);
+        free(keys);
+}
+
+#if defined(R2_SORT_SIMD)
+/**
+ * @brief Lane permutations that move the lanes whose bit isn't set in the index to the front and the others to the back.
+ * Every nibble is a lane index. perm64 holds pairs of 32 bit lanes because AVX2 can't permute 64 bit lanes by a variable.
+ */
+static const r2_uint32 perm32[256] = {
+        0x76543210, 0x07654321, 0x17654320, 0x10765432, 0x27654310, 0x20765431, 0x21765430, 0x21076543,
+        0x37654210, 0x30765421, 0x31765420, 0x31076542, 0x32765410, 0x32076541, 0x32176540, 0x32107654,
+        0x47653210, 0x40765321, 0x41765320, 0x41076532, 0x42765310, 0x42076531, 0x42176530, 0x42107653,
+        0x43765210, 0x43076521, 0x43176520, 0x43107652, 0x43276510, 0x43207651, 0x43217650, 0x43210765,
+        0x57643210, 0x50764321, 0x51764320, 0x51076432, 0x52764310, 0x52076431, 0x52176430, 0x52107643,
+        0x53764210, 0x53076421, 0x53176420, 0x53107642, 0x53276410, 0x53207641, 0x53217640, 0x53210764,
+        0x54763210, 0x54076321, 0x54176320, 0x54107632, 0x54276310, 0x54207631, 0x54217630, 0x54210763,
+        0x54376210, 0x54307621, 0x54317620, 0x54310762, 0x54327610, 0x54320761, 0x54321760, 0x54321076,
+        0x67543210, 0x60754321, 0x61754320, 0x61075432, 0x62754310, 0x62075431, 0x62175430, 0x62107543,
+        0x63754210, 0x63075421, 0x63175420, 0x63107542, 0x63275410, 0x63207541, 0x63217540, 0x63210754,
+        0x64753210, 0x64075321, 0x64175320, 0x64107532, 0x64275310, 0x64207531, 0x64217530, 0x64210753,
+        0x64375210, 0x64307521, 0x64317520, 0x64310752, 0x64327510, 0x64320751, 0x64321750, 0x64321075,
+        0x65743210, 0x65074321, 0x65174320, 0x65107432, 0x65274310, 0x65207431, 0x65217430, 0x65210743,
+        0x65374210, 0x65307421, 0x65317420, 0x65310742, 0x65327410, 0x65320741, 0x65321740, 0x65321074,
+        0x65473210, 0x65407321, 0x65417320, 0x65410732, 0x65427310, 0x65420731, 0x65421730, 0x65421073,
+        0x65437210, 0x65430721, 0x65431720, 0x65431072, 0x65432710, 0x65432071, 0x65432170, 0x65432107,
+        0x76543210, 0x70654321, 0x71654320, 0x71065432, 0x72654310, 0x72065431, 0x72165430, 0x72106543,
+        0x73654210, 0x73065421, 0x73165420, 0x73106542, 0x73265410, 0x73206541, 0x73216540, 0x73210654,
+        0x74653210, 0x74065321, 0x74165320, 0x74106532, 0x74265310, 0x74206531, 0x74216530, 0x74210653,
+        0x74365210, 0x74306521, 0x74316520, 0x74310652, 0x74326510, 0x74320651, 0x74321650, 0x74321065,
+        0x75643210, 0x75064321, 0x75164320, 0x75106432, 0x75264310, 0x75206431, 0x75216430, 0x75210643,
+        0x75364210, 0x75306421, 0x75316420, 0x75310642, 0x75326410, 0x75320641, 0x75321640, 0x75321064,
+        0x75463210, 0x75406321, 0x75416320, 0x75410632, 0x75426310, 0x75420631, 0x75421630, 0x75421063,
+        0x75436210, 0x75430621, 0x75431620, 0x75431062, 0x75432610, 0x75432061, 0x75432160, 0x75432106,
+        0x76543210, 0x76054321, 0x76154320, 0x76105432, 0x76254310, 0x76205431, 0x76215430, 0x76210543,
+        0x76354210, 0x76305421, 0x76315420, 0x76310542, 0x76325410, 0x76320541, 0x76321540, 0x76321054,
+        0x76453210, 0x76405321, 0x76415320, 0x76410532, 0x76425310, 0x76420531, 0x76421530, 0x76421053,
+        0x76435210, 0x76430521, 0x76431520, 0x76431052, 0x76432510, 0x76432051, 0x76432150, 0x76432105,
+        0x76543210, 0x76504321, 0x76514320, 0x76510432, 0x76524310, 0x76520431, 0x76521430, 0x76521043,
+        0x76534210, 0x76530421, 0x76531420, 0x76531042, 0x76532410, 0x76532041, 0x76532140, 0x76532104,
+        0x76543210, 0x76540321, 0x76541320, 0x76541032, 0x76542310, 0x76542031, 0x76542130, 0x76542103,
+        0x76543210, 0x76543021, 0x76543120, 0x76543102, 0x76543210, 0x76543201, 0x76543210, 0x76543210
+};
+
+static const r2_uint32 perm64[16] = {
+        0x76543210, 0x10765432, 0x32765410, 0x32107654, 0x54763210, 0x54107632, 0x54327610, 0x54321076,
+        0x76543210, 0x76105432, 0x76325410, 0x76321054, 0x76543210, 0x76541032, 0x76543210, 0x76543210
+};
+
+/**
+ * @brief               Returns the median of three integers.
+ */
+static int median32(int a, int b, int c)
+{
+        int t;
+        if(a > b){
+                t = a;
+                a = b;
+                b = t;
+        }
+        if(b > c)
+                b = c;
+        return a > b? a : b;
+}
+
+/**
+ * @brief               Returns the median of three integers.
+ */
+static r2_int64 median64(r2_int64 a, r2_int64 b, r2_int64 c)
+{
+        r2_int64 t;
+        if(a > b){
+                t = a;
+                a = b;
+                b = t;
+        }
+        if(b > c)
+                b = c;
+        return a > b? a : b;
+}
+
+/**
+ * @brief               Returns the median of three or the pseudomedian of nine elements of arr[lo...hi-1].
+ */
+static int pivot32(const int *arr, r2_uint64 lo, r2_uint64 hi)
+{
+        r2_uint64 mid = lo + (hi - lo)/2;
+        r2_uint64 s   = (hi - lo)/8;
+        if(hi - lo < PDQ_NINTHER)
+                return median32(arr[lo], arr[mid], arr[hi - 1]);
+
+        return median32(median32(arr[lo], arr[lo + s], arr[lo + 2*s]),
+                        median32(arr[mid - s], arr[mid], arr[mid + s]),
+                        median32(arr[hi - 1 - 2*s], arr[hi - 1 - s], arr[hi - 1]));
+}
+
+/**
+ * @brief               Returns the median of three or the pseudomedian of nine elements of arr[lo...hi-1].
+ */
+static r2_int64 pivot64(const r2_int64 *arr, r2_uint64 lo, r2_uint64 hi)
+{
+        r2_uint64 mid = lo + (hi - lo)/2;
+        r2_uint64 s   = (hi - lo)/8;
+        if(hi - lo < PDQ_NINTHER)
+                return median64(arr[lo], arr[mid], arr[hi - 1]);
+
+        return median64(median64(arr[lo], arr[lo + s], arr[lo + 2*s]),
+                        median64(arr[mid - s], arr[mid], arr[mid + s]),
+                        median64(arr[hi - 1 - 2*s], arr[hi - 1 - s], arr[hi - 1]));
+}
+
+/**
+ * @brief               Vectorized quicksort of 32 bit integers. Partitions are done a vector at a time and
+ *                      small subarrays are finished with a bitonic sorting network in registers.
+ *
+ * @param arr           Array.
+ * @param lo            Start.
+ * @param hi            End.
+ * @param depth         Number of partitions allowed before falling back to radix sort.
+ * @param level         Instruction set.
+ */
+static void simd_sort32(int *arr, r2_uint64 lo, r2_uint64 hi, r2_uint64 depth, r2_uint16 level)
+{
+        r2_uint64 small = level == R2_SORT_AVX512? 64 : 32;/*four registers*/
+        r2_uint64 mid;
+        int pivot;
+        while(hi - lo > small){
+                if(depth-- == 0){
+                        scalar_sort32(&arr[lo], hi - lo);
+                        return;
+                }
+
+                pivot = pivot32(arr, lo, hi);
+                mid   = level == R2_SORT_AVX512? avx512_partition32(arr, lo, hi, pivot, TRUE) : avx2_partition32(arr, lo, hi, pivot, TRUE);
+                if(mid == lo){
+                        /*Nothing is smaller than the pivot so we put everything equal to it on the left, that's already sorted.*/
+                        lo = level == R2_SORT_AVX512? avx512_partition32(arr, lo, hi, pivot, FALSE) : avx2_partition32(arr, lo, hi, pivot, FALSE);
+                        continue;
+                }
+
+                /*We recurse on the smaller side and loop on the larger side.*/
+                if(mid - lo <= hi - mid){
+                        simd_sort32(arr, lo, mid, depth, level);
+                        lo = mid;
+                }else{
+                        simd_sort32(arr, mid, hi, depth, level);
+                        hi = mid;
+                }
+        }
+
+        if(level == R2_SORT_AVX512)
+                avx512_network32(&arr[lo], hi - lo);
+        else    avx2_network32(&arr[lo], hi - lo);
+}
+
+/**
+ * @brief               Vectorized quicksort of 64 bit integers.
+ *
+ * @param arr           Array.
+ * @param lo            Start.
+ * @param hi            End.
+ * @param depth         Number of partitions allowed before falling back to radix sort.
+ * @param level         Instruction set.
+ */
+static void simd_sort64(r2_int64 *arr, r2_uint64 lo, r2_uint64 hi, r2_uint64 depth, r2_uint16 level)
+{
+        r2_uint64 small = level == R2_SORT_AVX512? 32 : 16;/*four registers*/
+        r2_uint64 mid;
+        r2_int64 pivot;
+        while(hi - lo > small){
+                if(depth-- == 0){
+                        r2_radix_sort_int64(arr, lo, hi);
+                        return;
+                }
+
+                pivot = pivot64(arr, lo, hi);
+                mid   = level == R2_SORT_AVX512? avx512_partition64(arr, lo, hi, pivot, TRUE) : avx2_partition64(arr, lo, hi, pivot, TRUE);
+                if(mid == lo){
+                        lo = level == R2_SORT_AVX512? avx512_partition64(arr, lo, hi, pivot, FALSE) : avx2_partition64(arr, lo, hi, pivot, FALSE);
+                        continue;
+                }
+
+                if(mid - lo <= hi - mid){
+                        simd_sort64(arr, lo, mid, depth, level);
+                        lo = mid;
+                }else{
+                        simd_sort64(arr, mid, hi, depth, level);
+                        hi = mid;
+                }
+        }
+
+        if(level == R2_SORT_AVX512)
+                avx512_network64(&arr[lo], hi - lo);
+        else    avx2_network64(&arr[lo], hi - lo);
+}
+
+/**
+ * @brief               Takes the lanes of b where mask is set and the lanes of a elsewhere. The select is spelled
+ *                      out with and/andnot/or instead of blendv, which some compilers miscompile when the mask is
+ *                      itself the result of a vector comparison.
+ */
+R2_AVX2 static inline __m256i avx2_select(__m256i a, __m256i b, __m256i mask)
+{
+        return _mm256_or_si256(_mm256_and_si256(mask, b), _mm256_andnot_si256(mask, a));
+}
+
+/**
+ * @brief               Performs one compare-exchange step of a bitonic network inside a register. Lane i is
+ *                      compared with lane i^j and keeps the larger element when the bits j and k of i differ.
+ */
+R2_AVX2 static inline __m256i avx2_stage32(__m256i v, int j, int k)
+{
+        __m256i iota = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i zero = _mm256_setzero_si256();
+        __m256i w    = _mm256_permutevar8x32_epi32(v, _mm256_xor_si256(iota, _mm256_set1_epi32(j)));
+        __m256i big  = _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_and_si256(iota, _mm256_set1_epi32(j)), zero),
+                                        _mm256_cmpeq_epi32(_mm256_and_si256(iota, _mm256_set1_epi32(k)), zero));
+        return avx2_select(_mm256_min_epi32(v, w), _mm256_max_epi32(v, w), big);
+}
+
+/**
+ * @brief               Sorts up to four registers with a bitonic network. Each register is sorted on its own,
+ *                      then sorted runs are merged by comparing one run with the other reversed.
+ */
+R2_AVX2 static void avx2_bitonic32(__m256i *v, r2_uint64 r)
+{
+        __m256i tmp[2], x;
+        __m256i rev = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+        for(r2_uint64 i = 0; i < r; ++i)
+                for(int k = 2; k <= 8; k *= 2)
+                        for(int j = k/2; j > 0; j /= 2)
+                                v[i] = avx2_stage32(v[i], j, k);
+
+        for(r2_uint64 m = 1; m < r; m *= 2){
+                for(r2_uint64 s = 0; s < r; s += 2*m){
+                        for(r2_uint64 t = 0; t < m; ++t)
+                                tmp[t] = _mm256_permutevar8x32_epi32(v[s + 2*m - 1 - t], rev);
+                        for(r2_uint64 t = 0; t < m; ++t){
+                                x = v[s + t];
+                                v[s + t]     = _mm256_min_epi32(x, tmp[t]);
+                                v[s + m + t] = _mm256_max_epi32(x, tmp[t]);
+                        }
+
+                        for(r2_uint64 h = m/2; h > 0; h /= 2)
+                                for(r2_uint64 i = s; i < s + 2*m; ++i)
+                                        if(((i - s) & h) == 0){
+                                                x = v[i];
+                                                v[i]     = _mm256_min_epi32(x, v[i + h]);
+                                                v[i + h] = _mm256_max_epi32(x, v[i + h]);
+                                        }
+
+                        for(r2_uint64 i = s; i < s + 2*m; ++i)
+                                for(int j = 4; j > 0; j /= 2)
+                                        v[i] = avx2_stage32(v[i], j, 16);
+                }
+        }
+}
+
+/**
+ * @brief               Sorts up to 32 integers in registers. Missing lanes are filled with INT_MAX.
+ */
+R2_AVX2 static void avx2_network32(int *arr, r2_uint64 n)
+{
+        __m256i v[4], mask[4];
+        __m256i iota = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i inf  = _mm256_set1_epi32(INT_MAX);
+        r2_uint64 r  = n <= 8? 1 : n <= 16? 2 : 4;
+        r2_uint64 rem;
+        for(r2_uint64 i = 0; i < r; ++i){
+                rem = n > 8*i? n - 8*i : 0;
+                mask[i] = _mm256_cmpgt_epi32(_mm256_set1_epi32(rem < 8? (int)rem : 8), iota);
+                v[i] = rem != 0? avx2_select(inf, _mm256_maskload_epi32(&arr[8*i], mask[i]), mask[i]) : inf;
+        }
+
+        avx2_bitonic32(v, r);
+        for(r2_uint64 i = 0; i < r && 8*i < n; ++i)
+                _mm256_maskstore_epi32(&arr[8*i], mask[i], v[i]);
+}
+
+/**
+ * @brief               Moves the elements of v that belong on the left to arr[l...] and the others to the end of arr[r...r+7].
+ * @return r2_uint64    Number of elements that belong on the right.
+ */
+R2_AVX2 static inline r2_uint64 avx2_store32(int *arr, r2_uint64 l, r2_uint64 r, __m256i v, __m256i pivot, r2_uint16 strict)
+{
+        __m256i right = strict == TRUE? _mm256_xor_si256(_mm256_cmpgt_epi32(pivot, v), _mm256_set1_epi32(-1)) : _mm256_cmpgt_epi32(v, pivot);
+        unsigned int m = _mm256_movemask_ps(_mm256_castsi256_ps(right));
+        __m256i perm = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(perm32[m]), _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28)), _mm256_set1_epi32(0xF));
+        v = _mm256_permutevar8x32_epi32(v, perm);
+        _mm256_storeu_si256((__m256i *)&arr[l], v);
+        _mm256_storeu_si256((__m256i *)&arr[r], v);
+        return R2_POPCNT(m);
+}
+
+/**
+ * @brief               Partitions arr[lo...hi-1] around pivot a vector at a time. The first and last vectors are kept in registers
+ *                      to make room, then every vector read is written to both ends of the free space and the side with
+ *                      less free space is read next, so both ends always have room for a whole vector.
+ *
+ * @param arr           Array.
+ * @param lo            Start.
+ * @param hi            End.
+ * @param pivot         Pivot.
+ * @param strict        When TRUE elements smaller than pivot go left, else elements smaller than or equal to pivot.
+ * @return r2_uint64    Returns the start of the right side.
+ */
+R2_AVX2 static r2_uint64 avx2_partition32(int *arr, r2_uint64 lo, r2_uint64 hi, int pivot, r2_uint16 strict)
+{
+        int t;
+        for(r2_uint64 i = (hi - lo) % 8; i > 0; --i){
+                if(strict == TRUE? arr[lo] >= pivot : arr[lo] > pivot){
+                        t = arr[lo];
+                        arr[lo] = arr[--hi];
+                        arr[hi] = t;
+                }else   ++lo;
+        }
+        if(lo == hi)
+                return lo;
+
+        __m256i p     = _mm256_set1_epi32(pivot);
+        __m256i first = _mm256_loadu_si256((const __m256i *)&arr[lo]);
+        __m256i last  = _mm256_loadu_si256((const __m256i *)&arr[hi - 8]);
+        __m256i cur;
+        r2_uint64 l = lo, r = hi - 8;
+        r2_uint64 left = lo + 8, right = hi - 8;
+        r2_uint64 cnt;
+        if(hi - lo == 8)
+                return lo + 8 - avx2_store32(arr, lo, lo, first, p, strict);
+
+        while(left != right){
+                if(r + 8 - right < left - l){
+                        right -= 8;
+                        cur = _mm256_loadu_si256((const __m256i *)&arr[right]);
+                }else{
+                        cur = _mm256_loadu_si256((const __m256i *)&arr[left]);
+                        left += 8;
+                }
+                cnt = avx2_store32(arr, l, r, cur, p, strict);
+                l += 8 - cnt;
+                r -= cnt;
+        }
+
+        cnt = avx2_store32(arr, l, r, first, p, strict);
+        l += 8 - cnt;
+        r -= cnt;
+        cnt = avx2_store32(arr, l, r, last, p, strict);
+        return l + 8 - cnt;
+}
+
+/**
+ * @brief               Returns the smaller of each pair of 64 bit lanes, AVX2 doesn't have a 64 bit min.
+ */
+R2_AVX2 static inline __m256i avx2_min64(__m256i a, __m256i b)
+{
+        return avx2_select(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+/**
+ * @brief               Returns the larger of each pair of 64 bit lanes.
+ */
+R2_AVX2 static inline __m256i avx2_max64(__m256i a, __m256i b)
+{
+        return avx2_select(b, a, _mm256_cmpgt_epi64(a, b));
+}
+
+/**
+ * @brief               Performs one compare-exchange step of a bitonic network inside a register of 64 bit lanes.
+ */
+R2_AVX2 static inline __m256i avx2_stage64(__m256i v, int j, int k)
+{
+        __m256i iota = _mm256_setr_epi64x(0, 1, 2, 3);
+        __m256i zero = _mm256_setzero_si256();
+        __m256i w    = _mm256_permutevar8x32_epi32(v, _mm256_xor_si256(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(2*j)));
+        __m256i big  = _mm256_xor_si256(_mm256_cmpeq_epi64(_mm256_and_si256(iota, _mm256_set1_epi64x(j)), zero),
+                                        _mm256_cmpeq_epi64(_mm256_and_si256(iota, _mm256_set1_epi64x(k)), zero));
+        return avx2_select(avx2_min64(v, w), avx2_max64(v, w), big);
+}
+
+/**
+ * @brief               Sorts up to four registers of 64 bit lanes with a bitonic network.
+ */
+R2_AVX2 static void avx2_bitonic64(__m256i *v, r2_uint64 r)
+{
+        __m256i tmp[2], x;
+        for(r2_uint64 i = 0; i < r; ++i)
+                for(int k = 2; k <= 4; k *= 2)
+                        for(int j = k/2; j > 0; j /= 2)
+                                v[i] = avx2_stage64(v[i], j, k);
+
+        for(r2_uint64 m = 1; m < r; m *= 2){
+                for(r2_uint64 s = 0; s < r; s += 2*m){
+                        for(r2_uint64 t = 0; t < m; ++t)
+                                tmp[t] = _mm256_permute4x64_epi64(v[s + 2*m - 1 - t], 0x1B);
+                        for(r2_uint64 t = 0; t < m; ++t){
+                                x = v[s + t];
+                                v[s + t]     = avx2_min64(x, tmp[t]);
+                                v[s + m + t] = avx2_max64(x, tmp[t]);
+                        }
+
+                        for(r2_uint64 h = m/2; h > 0; h /= 2)
+                                for(r2_uint64 i = s; i < s + 2*m; ++i)
+                                        if(((i - s) & h) == 0){
+                                                x = v[i];
+                                                v[i]     = avx2_min64(x, v[i + h]);
+                                                v[i + h] = avx2_max64(x, v[i + h]);
+                                        }
+
+                        for(r2_uint64 i = s; i < s + 2*m; ++i)
+                                for(int j = 2; j > 0; j /= 2)
+                                        v[i] = avx2_stage64(v[i], j, 8);
+                }
+        }
+}
+
+/**
+ * @brief               Sorts up to 16 integers in registers. Missing lanes are filled with LLONG_MAX.
+ */
+R2_AVX2 static void avx2_network64(r2_int64 *arr, r2_uint64 n)
+{
+        __m256i v[4], mask[4];
+        __m256i iota = _mm256_setr_epi64x(0, 1, 2, 3);
+        __m256i inf  = _mm256_set1_epi64x(LLONG_MAX);
+        r2_uint64 r  = n <= 4? 1 : n <= 8? 2 : 4;
+        r2_uint64 rem;
+        for(r2_uint64 i = 0; i < r; ++i){
+                rem = n > 4*i? n - 4*i : 0;
+                mask[i] = _mm256_cmpgt_epi64(_mm256_set1_epi64x(rem < 4? (r2_int64)rem : 4), iota);
+                v[i] = rem != 0? avx2_select(inf, _mm256_maskload_epi64(&arr[4*i], mask[i]), mask[i]) : inf;
+        }
+
+        avx2_bitonic64(v, r);
+        for(r2_uint64 i = 0; i < r && 4*i < n; ++i)
+                _mm256_maskstore_epi64(&arr[4*i], mask[i], v[i]);
+}
+
+/**
+ * @brief               Moves the elements of v that belong on the left to arr[l...] and the others to the end of arr[r...r+3].
+ * @return r2_uint64    Number of elements that belong on the right.
+ */
+R2_AVX2 static inline r2_uint64 avx2_store64(r2_int64 *arr, r2_uint64 l, r2_uint64 r, __m256i v, __m256i pivot, r2_uint16 strict)
+{
+        __m256i right = strict == TRUE? _mm256_xor_si256(_mm256_cmpgt_epi64(pivot, v), _mm256_set1_epi64x(-1)) : _mm256_cmpgt_epi64(v, pivot);
+        unsigned int m = _mm256_movemask_pd(_mm256_castsi256_pd(right));
+        __m256i perm = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(perm64[m]), _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28)), _mm256_set1_epi32(0xF));
+        v = _mm256_permutevar8x32_epi32(v, perm);
+        _mm256_storeu_si256((__m256i *)&arr[l], v);
+        _mm256_storeu_si256((__m256i *)&arr[r], v);
+        return R2_POPCNT(m);
+}
+
+/**
+ * @brief               Partitions arr[lo...hi-1] around pivot four 64 bit lanes at a time.
+ *
+ * @param arr           Array.
+ * @param lo            Start.
+ * @param hi            End.
+ * @param pivot         Pivot.
+ * @param strict        When TRUE elements smaller than pivot go left, else elements smaller than or equal to pivot.
+ * @return r2_uint64    Returns the start of the right side.
+ */
+R2_AVX2 static r2_uint64 avx2_partition64(r2_int64 *arr, r2_uint64 lo, r2_uint64 hi, r2_int64 pivot, r2_uint16 strict)
+{
+        r2_int64 t;
+        for(r2_uint64 i = (hi - lo) % 4; i > 0; --i){
+                if(strict == TRUE? arr[lo] >= pivot : arr[lo] > pivot){
+                        t = arr[lo];
+                        arr[lo] = arr[--hi];
+                        arr[hi] = t;
+                }else   ++lo;
+        }
+        if(lo == hi)
+                return lo;
+
+        __m256i p     = _mm256_set1_epi64x(pivot);
+        __m256i first = _mm256_loadu_si256((const __m256i *)&arr[lo]);
+        __m256i last  = _mm256_loadu_si256((const __m256i *)&arr[hi - 4]);
+        __m256i cur;
+        r2_uint64 l = lo, r = hi - 4;
+        r2_uint64 left = lo + 4, right = hi - 4;
+        r2_uint64 cnt;
+        if(hi - lo == 4)
+                return lo + 4 - avx2_store64(arr, lo, lo, first, p, strict);
+
+        while(left != right){
+                if(r + 4 - right < left - l){
+                        right -= 4;
+                        cur = _mm256_loadu_si256((const __m256i *)&arr[right]);
+                }else{
+                        cur = _mm256_loadu_si256((const __m256i *)&arr[left]);
+                        left += 4;
+                }
+                cnt = avx2_store64(arr, l, r, cur, p, strict);
+                l += 4 - cnt;
+                r -= cnt;
+        }
+
+        cnt = avx2_store64(arr, l, r, first, p, strict);
+        l += 4 - cnt;
+        r -= cnt;
+        cnt = avx2_store64(arr, l, r, last, p, strict);
+        return l + 4 - cnt;
+}
+
+/**
+ * @brief               Performs one compare-exchange step of a bitonic network inside a 512 bit register.
+ */
+R2_AVX512 static inline __m512i avx512_stage32(__m512i v, int j, int k)
+{
+        __m512i iota = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        __m512i w    = _mm512_permutexvar_epi32(_mm512_xor_si512(iota, _mm512_set1_epi32(j)), v);
+        __mmask16 big = _mm512_test_epi32_mask(iota, _mm512_set1_epi32(j)) ^ _mm512_test_epi32_mask(iota, _mm512_set1_epi32(k));
+        return _mm512_mask_mov_epi32(_mm512_min_epi32(v, w), big, _mm512_max_epi32(v, w));
+}
+
+/**
+ * @brief               Sorts up to four 512 bit registers with a bitonic network.
+ */
+R2_AVX512 static void avx512_bitonic32(__m512i *v, r2_uint64 r)
+{
+        __m512i tmp[2], x;
+        __m512i rev = _mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        for(r2_uint64 i = 0; i < r; ++i)
+                for(int k = 2; k <= 16; k *= 2)
+                        for(int j = k/2; j > 0; j /= 2)
+                                v[i] = avx512_stage32(v[i], j, k);
+
+        for(r2_uint64 m = 1; m < r; m *= 2){
+                for(r2_uint64 s = 0; s < r; s += 2*m){
+                        for(r2_uint64 t = 0; t < m; ++t)
+                                tmp[t] = _mm512_permutexvar_epi32(rev, v[s + 2*m - 1 - t]);
+                        for(r2_uint64 t = 0; t < m; ++t){
+                                x = v[s + t];
+                                v[s + t]     = _mm512_min_epi32(x, tmp[t]);
+                                v[s + m + t] = _mm512_max_epi32(x, tmp[t]);
+                        }
+
+                        for(r2_uint64 h = m/2; h > 0; h /= 2)
+                                for(r2_uint64 i = s; i < s + 2*m; ++i)
+                                        if(((i - s) & h) == 0){
+                                                x = v[i];
+                                                v[i]     = _mm512_min_epi32(x, v[i + h]);
+                                                v[i + h] = _mm512_max_epi32(x, v[i + h]);
+                                        }
+
+                        for(r2_uint64 i = s; i < s + 2*m; ++i)
+                                for(int j = 8; j > 0; j /= 2)
+                                        v[i] = avx512_stage32(v[i], j, 32);
+                }
+        }
+}
+
+/**
+ * @brief               Sorts up to 64 integers in registers. Missing lanes are filled with INT_MAX.
+ */
+R2_AVX512 static void avx512_network32(int *arr, r2_uint64 n)
+{
+        __m512i v[4];
+        __mmask16 mask[4];
+        __m512i inf = _mm512_set1_epi32(INT_MAX);
+        r2_uint64 r = n <= 16? 1 : n <= 32? 2 : 4;
+        r2_uint64 rem;
+        for(r2_uint64 i = 0; i < r; ++i){
+                rem = n > 16*i? n - 16*i : 0;
+                mask[i] = rem < 16? (__mmask16)((1u << rem) - 1) : (__mmask16)0xFFFF;
+                v[i] = _mm512_mask_loadu_epi32(inf, mask[i], &arr[16*i]);
+        }
+
+        avx512_bitonic32(v, r);
+        for(r2_uint64 i = 0; i < r; ++i)
+                _mm512_mask_storeu_epi32(&arr[16*i], mask[i], v[i]);
+}
+
+/**
+ * @brief               Compress-stores the elements of v that belong on the left to arr[l...] and the others to the end of arr[r...r+15].
+ * @return r2_uint64    Number of elements that belong on the right.
+ */
+R2_AVX512 static inline r2_uint64 avx512_store32(int *arr, r2_uint64 l, r2_uint64 r, __m512i v, __m512i pivot, r2_uint16 strict)
+{
+        __mmask16 m = strict == TRUE? _mm512_cmpge_epi32_mask(v, pivot) : _mm512_cmpgt_epi32_mask(v, pivot);
+        r2_uint64 cnt = R2_POPCNT(m);
+        _mm512_mask_compressstoreu_epi32(&arr[l], (__mmask16)~m, v);
+        _mm512_mask_compressstoreu_epi32(&arr[r + 16 - cnt], m, v);
+        return cnt;
+}
+
+/**
+ * @brief               Partitions arr[lo...hi-1] around pivot sixteen lanes at a time.
+ *
+ * @param arr           Array.
+ * @param lo            Start.
+ * @param hi            End.
+ * @param pivot         Pivot.
+ * @param strict        When TRUE elements smaller than pivot go left, else elements smaller than or equal to pivot.
+ * @return r2_uint64    Returns the start of the right side.
+ */
+R2_AVX512 static r2_uint64 avx512_partition32(int *arr, r2_uint64 lo, r2_uint64 hi, int pivot, r2_uint16 strict)
+{
+        int t;
+        for(r2_uint64 i = (hi - lo) % 16; i > 0; --i){
+                if(strict == TRUE? arr[lo] >= pivot : arr[lo] > pivot){
+                        t = arr[lo];
+                        arr[lo] = arr[--hi];
+                        arr[hi] = t;
+                }else   ++lo;
+        }
+        if(lo == hi)
+                return lo;
+
+        __m512i p     = _mm512_set1_epi32(pivot);
+        __m512i first = _mm512_loadu_si512(&arr[lo]);
+        __m512i last  = _mm512_loadu_si512(&arr[hi - 16]);
+        __m512i cur;
+        r2_uint64 l = lo, r = hi - 16;
+        r2_uint64 left = lo + 16, right = hi - 16;
+        r2_uint64 cnt;
+        if(hi - lo == 16)
+                return lo + 16 - avx512_store32(arr, lo, lo, first, p, strict);
+
+        while(left != right){
+                if(r + 16 - right < left - l){
+                        right -= 16;
+                        cur = _mm512_loadu_si512(&arr[right]);
+                }else{
+                        cur = _mm512_loadu_si512(&arr[left]);
+                        left += 16;
+                }
+                cnt = avx512_store32(arr, l, r, cur, p, strict);
+                l += 16 - cnt;
+                r -= cnt;
+        }
+
+        cnt = avx512_store32(arr, l, r, first, p, strict);
+        l += 16 - cnt;
+        r -= cnt;
+        cnt = avx512_store32(arr, l, r, last, p, strict);
+        return l + 16 - cnt;
+}
+
+/**
+ * @brief               Performs one compare-exchange step of a bitonic network inside a 512 bit register of 64 bit lanes.
+ */
+R2_AVX512 static inline __m512i avx512_stage64(__m512i v, int j, int k)
+{
+        __m512i iota = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+        __m512i w    = _mm512_permutexvar_epi64(_mm512_xor_si512(iota, _mm512_set1_epi64(j)), v);
+        __mmask8 big = _mm512_test_epi64_mask(iota, _mm512_set1_epi64(j)) ^ _mm512_test_epi64_mask(iota, _mm512_set1_epi64(k));
+        return _mm512_mask_mov_epi64(_mm512_min_epi64(v, w), big, _mm512_max_epi64(v, w));
+}
+
+/**
+ * @brief               Sorts up to four 512 bit registers of 64 bit lanes with a bitonic network.
+ */
+R2_AVX512 static void avx512_bitonic64(__m512i *v, r2_uint64 r)
+{
+        __m512i tmp[2], x;
+        __m512i rev = _mm512_setr_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+        for(r2_uint64 i = 0; i < r; ++i)
+                for(int k = 2; k <= 8; k *= 2)
+                        for(int j = k/2; j > 0; j /= 2)
+                                v[i] = avx512_stage64(v[i], j, k);
+
+        for(r2_uint64 m = 1; m < r; m *= 2){
+                for(r2_uint64 s = 0; s < r; s += 2*m){
+                        for(r2_uint64 t = 0; t < m; ++t)
+                                tmp[t] = _mm512_permutexvar_epi64(rev, v[s + 2*m - 1 - t]);
+                        for(r2_uint64 t = 0; t < m; ++t){
+                                x = v[s + t];
+                                v[s + t]     = _mm512_min_epi64(x, tmp[t]);
+                                v[s + m + t] = _mm512_max_epi64(x, tmp[t]);
+                        }
+
+                        for(r2_uint64 h = m/2; h > 0; h /= 2)
+                                for(r2_uint64 i = s; i < s + 2*m; ++i)
+                                        if(((i - s) & h) == 0){
+                                                x = v[i];
+                                                v[i]     = _mm512_min_epi64(x, v[i + h]);
+                                                v[i + h] = _mm512_max_epi64(x, v[i + h]);
+                                        }
+
+                        for(r2_uint64 i = s; i < s + 2*m; ++i)
+                                for(int j = 4; j > 0; j /= 2)
+                                        v[i] = avx512_stage64(v[i], j, 16);
+                }
+        }
+}
+
+/**
+ * @brief               Sorts up to 32 integers in registers. Missing lanes are filled with LLONG_MAX.
+ */
+R2_AVX512 static void avx512_network64(r2_int64 *arr, r2_uint64 n)
+{
+        __m512i v[4];
+        __mmask8 mask[4];
+        __m512i inf = _mm512_set1_epi64(LLONG_MAX);
+        r2_uint64 r = n <= 8? 1 : n <= 16? 2 : 4;
+        r2_uint64 rem;
+        for(r2_uint64 i = 0; i < r; ++i){
+                rem = n > 8*i? n - 8*i : 0;
+                mask[i] = rem < 8? (__mmask8)((1u << rem) - 1) : (__mmask8)0xFF;
+                v[i] = _mm512_mask_loadu_epi64(inf, mask[i], &arr[8*i]);
+        }
+
+        avx512_bitonic64(v, r);
+        for(r2_uint64 i = 0; i < r; ++i)
+                _mm512_mask_storeu_epi64(&arr[8*i], mask[i], v[i]);
+}
+
+/**
+ * @brief               Compress-stores the elements of v that belong on the left to arr[l...] and the others to the end of arr[r...r+7].
+ * @return r2_uint64    Number of elements that belong on the right.
+ */
+R2_AVX512 static inline r2_uint64 avx512_store64(r2_int64 *arr, r2_uint64 l, r2_uint64 r, __m512i v, __m512i pivot, r2_uint16 strict)
+{
+        __mmask8 m = strict == TRUE? _mm512_cmpge_epi64_mask(v, pivot) : _mm512_cmpgt_epi64_mask(v, pivot);
+        r2_uint64 cnt = R2_POPCNT(m);
+        _mm512_mask_compressstoreu_epi64(&arr[l], (__mmask8)~m, v);
+        _mm512_mask_compressstoreu_epi64(&arr[r + 8 - cnt], m, v);
+        return cnt;
+}
+
+/**
+ * @brief               Partitions arr[lo...hi-1] around pivot eight 64 bit lanes at a time.
+ *
+ * @param arr           Array.
+ * @param lo            Start.
+ * @param hi            End.
+ * @param pivot         Pivot.
+ * @param strict        When TRUE elements smaller than pivot go left, else elements smaller than or equal to pivot.
+ * @return r2_uint64    Returns the start of the right side.
+ */
+R2_AVX512 static r2_uint64 avx512_partition64(r2_int64 *arr, r2_uint64 lo, r2_uint64 hi, r2_int64 pivot, r2_uint16 strict)
+{
+        r2_int64 t;
+        for(r2_uint64 i = (hi - lo) % 8; i > 0; --i){
+                if(strict == TRUE? arr[lo] >= pivot : arr[lo] > pivot){
+                        t = arr[lo];
+                        arr[lo] = arr[--hi];
+                        arr[hi] = t;
+                }else   ++lo;
+        }
+        if(lo == hi)
+                return lo;
+
+        __m512i p     = _mm512_set1_epi64(pivot);
+        __m512i first = _mm512_loadu_si512(&arr[lo]);
+        __m512i last  = _mm512_loadu_si512(&arr[hi - 8]);
+        __m512i cur;
+        r2_uint64 l = lo, r = hi - 8;
+        r2_uint64 left = lo + 8, right = hi - 8;
+        r2_uint64 cnt;
+        if(hi - lo == 8)
+                return lo + 8 - avx512_store64(arr, lo, lo, first, p, strict);
+
+        while(left != right){
+                if(r + 8 - right < left - l){
+                        right -= 8;
+                        cur = _mm512_loadu_si512(&arr[right]);
+                }else{
+                        cur = _mm512_loadu_si512(&arr[left]);
+                        left += 8;
+                }
+                cnt = avx512_store64(arr, l, r, cur, p, strict);
+                l += 8 - cnt;
+                r -= cnt;
+        }
+
+        cnt = avx512_store64(arr, l, r, first, p, strict);
+        l += 8 - cnt;
+        r -= cnt;
+        cnt = avx512_store64(arr, l, r, last, p, strict);
+        return l + 8 - cnt;
+}
+#endif
+
+/**
+ * @brief               Merges k sorted arrays into dest using a loser tree. Every element is compared about log2(k)
+ *                      times. The merge is stable: equal elements keep the order of their arrays.
+ *
+ * @param arrs          Sorted arrays.
+ * @param sizes         Number of elements in every array.
+ * @param k             Number of arrays.
+ * @param es            Element size.
+ * @param dest          Output array, it must hold the sum of sizes elements and can't overlap any array.
+ * @param cmp           A callback comparison function that compares two elements a and b.
+ */
+void r2_kway_merge(void **arrs, const r2_uint64 *sizes, r2_uint64 k, r2_uint64 es, void *dest, r2_cmp cmp)
+{
+        kway_merge(arrs, sizes, k, es, dest, cmp);
+}
+
+/**
+ * @brief               Merges k sorted arrays of 64 bit integers into dest using a loser tree. The integers are 
+ *                      compared directly instead of through a comparison function.
+ *
+ * @param arrs          Sorted arrays.
+ * @param sizes         Number of integers in every array.
+ * @param k             Number of arrays.
+ * @param dest          Output array, it must hold the sum of sizes integers and can't overlap any array.
+ */
+void r2_kway_merge_int64(r2_int64 **arrs, const r2_uint64 *sizes, r2_uint64 k, r2_int64 *dest)
+{
+        kway_merge((void **)arrs, sizes, k, sizeof(r2_int64), dest, NULL);
+}
+
+/**
+ * @brief               Merges k sorted sequences that are read one element at a time using a loser tree. Only the 
+ *                      next element of every sequence is kept in memory. The merged elements are passed to action 
+ *                      in non-decreasing order. The merge is stable.
+ *
+ * @param iters         Sequences, passed to next.
+ * @param k             Number of sequences.
+ * @param es            Element size.
+ * @param next          A callback function that copies the next element of a sequence to its second argument
+ *                      and returns TRUE, or returns FALSE when the sequence has ended.
+ * @param action        A callback function that is passed every merged element and arg.
+ * @param arg           Argument passed to action.
+ * @param cmp           A callback comparison function that compares two elements a and b.
+ * @return r2_uint64    Returns the number of elements merged.
+ */
+r2_uint64 r2_kway_merge_iter(void **iters, r2_uint64 k, r2_uint64 es, r2_next next, r2_act action, void *arg, r2_cmp cmp)
+{
+        if(k == 0)
+                return 0;
+
+        struct r2_ltree lt;
+        r2_uint64 n = 0, w;
+        char *buf  = malloc(k * es);
+        lt.k     = k;
+        lt.cmp   = cmp;
+        lt.tree  = malloc(sizeof(r2_uint64) * k);
+        lt.heads = malloc(sizeof(char *) * k);
+        assert(buf != NULL && lt.tree != NULL && lt.heads != NULL);
+        for(r2_uint64 i = 0; i < k; ++i)
+                lt.heads[i] = next(iters[i], &buf[i*es]) == TRUE? &buf[i*es] : NULL;
+
+        ltree_init(&lt);
+        for(w = lt.tree[0]; lt.heads[w] != NULL; w = lt.tree[0]){
+                action((void *)lt.heads[w], arg);
+                ++n;
+                if(next(iters[w], &buf[w*es]) == FALSE)
+                        lt.heads[w] = NULL;
+                ltree_replay(&lt, w);
+        }
+
+        free(buf);
+        free(lt.tree);
+        free(lt.heads);
+        return n;
+}
+
+/**
+ * @brief               Merges k sorted arrays.
+ *
+ * @param arrs          Sorted arrays.
+ * @param sizes         Number of elements in every array.
+ * @param k             Number of arrays.
+ * @param es            Element size.
+ * @param dest          Output array.
+ * @param cmp           A comparison callback function, NULL compares r2_int64 keys.
+ */
+static void kway_merge(void **arrs, const r2_uint64 *sizes, r2_uint64 k, r2_uint64 es, void *dest, r2_cmp cmp)
+{
+        if(k == 0)
+                return;
+
+        struct r2_ltree lt;
+        char *out = dest;
+        const char **ends = malloc(sizeof(char *) * k);
+        r2_uint64 w;
+        lt.k     = k;
+        lt.cmp   = cmp;
+        lt.tree  = malloc(sizeof(r2_uint64) * k);
+        lt.heads = malloc(sizeof(char *) * k);
+        assert(ends != NULL && lt.tree != NULL && lt.heads != NULL);
+        for(r2_uint64 i = 0; i < k; ++i){
+                lt.heads[i] = sizes[i] > 0? arrs[i] : NULL;
+                ends[i]     = (const char *)arrs[i] + sizes[i]*es;
+        }
+
+        ltree_init(&lt);
+        for(w = lt.tree[0]; lt.heads[w] != NULL; w = lt.tree[0]){
+                mcpy(out, lt.heads[w], es);
+                out += es;
+                lt.heads[w] += es;
+                if(lt.heads[w] == ends[w])
+                        lt.heads[w] = NULL;
+                ltree_replay(&lt, w);
+        }
+
+        free(ends);
+        free(lt.tree);
+        free(lt.heads);
+}
+
+/**
+ * @brief               Returns TRUE whenever the next element of run a comes before the next element of run b.
+ *                      Exhausted runs come last and ties are broken by run so merges are stable.
+ *
+ * @param lt            Loser tree.
+ * @param a             Run.
+ * @param b             Run.
+ * @return r2_uint16    Returns TRUE whenever run a wins, else FALSE.
+ */
+static r2_uint16 ltree_less(const struct r2_ltree *lt, r2_uint64 a, r2_uint64 b)
+{
+        r2_int64 x, y;
+        r2_int16 c;
+        if(lt->heads[a] == NULL || lt->heads[b] == NULL)
+                return lt->heads[b] == NULL && (lt->heads[a] != NULL || a < b);
+
+        if(lt->cmp == NULL){
+                mcpy(&x, lt->heads[a], sizeof(r2_int64));
+                mcpy(&y, lt->heads[b], sizeof(r2_int64));
+                return x < y || (x == y && a < b);
+        }
+
+        c = lt->cmp(lt->heads[a], lt->heads[b]);
+        return c < 0 || (c == 0 && a < b);
+}
+
+/**
+ * @brief               Plays the tournament below node and returns its winner. Internal nodes are 1...k-1 and
+ *                      run i is the leaf k + i.
+ *
+ * @param lt            Loser tree.
+ * @param node          Node.
+ * @return r2_uint64    Returns the winning run.
+ */
+static r2_uint64 ltree_build(struct r2_ltree *lt, r2_uint64 node)
+{
+        if(node >= lt->k)
+                return node - lt->k;
+
+        r2_uint64 a = ltree_build(lt, 2*node);
+        r2_uint64 b = ltree_build(lt, 2*node + 1);
+        if(ltree_less(lt, a, b) == TRUE){
+                lt->tree[node] = b;
+                return a;
+        }
+
+        lt->tree[node] = a;
+        return b;
+}
+
+/**
+ * @brief               Builds the loser tree of the runs, tree[0] is the winner.
+ *
+ * @param lt            Loser tree.
+ */
+static void ltree_init(struct r2_ltree *lt)
+{
+        lt->tree[0] = lt->k > 1? ltree_build(lt, 1) : 0;
+}
+
+/**
+ * @brief               Replays the matches from the leaf of run w to the root after the next element of w changed.
+ *                      Only the losers on the path are compared, so a replay takes log2(k) comparisons.
+ *
+ * @param lt            Loser tree.
+ * @param w             Run that won the last tournament.
+ */
+static void ltree_replay(struct r2_ltree *lt, r2_uint64 w)
+{
+        r2_uint64 t;
+        for(r2_uint64 node = (w + lt->k)/2; node > 0; node /= 2){
+                if(ltree_less(lt, lt->tree[node], w) == TRUE){
+                        t = lt->tree[node];
+                        lt->tree[node] = w;
+                        w = t;
+                }
+        }
+        lt->tree[0] = w;
+}
+
+/**
+ * @brief               Sorts a file of fixed width records in non-decreasing order using external merge sort.
+ *                      The file doesn't have to fit in memory: runs of mem bytes are sorted in memory with pdqsort
+ *                      and spilled to temporary files, then the runs are merged with one input buffer per run.
+ *                      At most min(mem/XBLOCK, XFANIN) runs are kept open, older runs are merged together
+ *                      while the input is still being read.
+ *
+ * @param src           Path of the file to sort.
+ * @param dest          Path of the sorted file, it can't be the same as src.
+ * @param es            Record size in bytes.
+ * @param mem           Number of bytes of memory the sort may use for records.
+ * @param cmp           A callback comparison function that compares two records a and b.
+ * @return r2_uint16    Returns TRUE whenever dest was written, else FALSE. A file whose size isn't a multiple of es is rejected.
+ */
+r2_uint16 r2_external_sort(const char *src, const char *dest, r2_uint64 es, r2_uint64 mem, r2_cmp cmp)
+{
+        struct r2_xsort xs;
+        xs.es    = es;
+        xs.mem   = mem;
+        xs.cmp   = cmp;
+        xs.sort  = r2_pdq_sort;
+        xs.read  = xread;
+        xs.write = xwrite;
+        xs.bad   = FALSE;
+        return xsort(&xs, src, dest);
+}
+
+/**
+ * @brief               Sorts a text file of whitespace separated integers using external merge sort. The sorted
+ *                      integers are written one per line. Runs are kept as binary integers and sorted with the SIMD sorts.
+ *
+ * @param src           Path of the file to sort.
+ * @param dest          Path of the sorted file, it can't be the same as src.
+ * @param mem           Number of bytes of memory the sort may use for integers.
+ * @return r2_uint16    Returns TRUE whenever dest was written, else FALSE. A token that isn't an integer is rejected.
+ */
+r2_uint16 r2_external_sort_ints(const char *src, const char *dest, r2_uint64 mem)
+{
+        struct r2_xsort xs;
+        xs.es    = sizeof(r2_int64);
+        xs.mem   = mem;
+        xs.cmp   = xint_cmp;
+        xs.sort  = xsort_ints;
+        xs.read  = xread_ints;
+        xs.write = xwrite_ints;
+        xs.bad   = FALSE;
+        return xsort(&xs, src, dest);
+}
+
+/**
+ * @brief               Forms the sorted runs and merges them into dest.
+ *
+ * @param xs            External sort.
+ * @param src           Path of the file to sort.
+ * @param dest          Path of the sorted file.
+ * @return r2_uint16    Returns TRUE whenever dest was written, else FALSE.
+ */
+static r2_uint16 xsort(struct r2_xsort *xs, const char *src, const char *dest)
+{
+        r2_uint64 es    = xs->es;
+        r2_uint64 cap   = xs->mem / es > 0? xs->mem / es : 1;
+        r2_uint64 fanin = xs->mem / XBLOCK > 3? xs->mem / XBLOCK - 1 : 2;/*runs merged at once, each needs a buffer*/
+        r2_uint64 nruns = 0, n, i;
+        r2_uint16 ok = TRUE;
+        FILE *in  = fopen(src, "rb");
+        FILE *out = NULL;
+        FILE *run = NULL;
+        if(in == NULL)
+                return FALSE;
+
+        if(fanin > XFANIN)
+                fanin = XFANIN;
+        char *buf         = malloc(cap * es);
+        FILE **runs       = malloc(sizeof(FILE *) * fanin);
+        r2_uint64 *levels = malloc(sizeof(r2_uint64) * fanin);/*number of merges behind every run*/
+        assert(buf != NULL && runs != NULL && levels != NULL);
+        for(;;){
+                n = xs->read(xs, in, buf, cap);
+                /*A short read must be the end of the input, not an error or a record that can't be parsed.*/
+                if(xs->bad == TRUE || ferror(in) != 0 || (n < cap && feof(in) == 0)){
+                        ok = FALSE;
+                        break;
+                }
+                if(n == 0 && nruns > 0)
+                        break;
+
+                xs->sort(buf, 0, n, es, xs->cmp);
+                if(n < cap && nruns == 0){
+                        /*Everything fits in memory.*/
+                        out = fopen(dest, "wb");
+                        ok  = out != NULL && xs->write(out, buf, n, es) == TRUE;
+                        break;
+                }
+
+                run = tmpfile();
+                if(run == NULL || fwrite(buf, es, n, run) != n){
+                        ok = FALSE;
+                        break;
+                }
+                rewind(run);
+                runs[nruns]     = run;
+                levels[nruns++] = 0;
+                run = NULL;
+                if(n < cap)
+                        break;
+
+                if(nruns == fanin){
+                        /*
+                         * At most fanin runs are open at once. The newest runs of the lowest level are merged
+                         * into one run of the next level, so every record is merged about log_fanin(runs) times.
+                         * The run buffer is released first, the merge buffers take its place in the memory budget.
+                         */
+                        i = nruns - 1;
+                        while(i > 0 && (levels[i - 1] == levels[i] || nruns - i < 2))
+                                --i;
+                        free(buf);
+                        buf = NULL;
+                        run = tmpfile();
+                        ok  = run != NULL && xmerge(xs, &runs[i], nruns - i, run, xwrite) == TRUE;
+                        if(ok == FALSE)
+                                break;
+                        rewind(run);
+                        runs[i]   = run;
+                        levels[i] = levels[i] + 1;
+                        nruns     = i + 1;
+                        run = NULL;
+                        buf = malloc(cap * es);
+                        assert(buf != NULL);
+                }
+        }
+        free(buf);
+        fclose(in);
+
+        if(ok == TRUE && nruns > 0){
+                out = fopen(dest, "wb");
+                ok  = out != NULL && xmerge(xs, runs, nruns, out, xs->write) == TRUE;
+        }
+
+        if(run != NULL)
+                fclose(run);
+        for(i = 0; i < nruns; ++i)
+                if(runs[i] != NULL)
+                        fclose(runs[i]);
+        if(out != NULL && fclose(out) != 0)
+                ok = FALSE;
+        free(runs);
+        free(levels);
+        return ok;
+}
+
+/**
+ * @brief               Merges k sorted runs into out through a loser tree. The runs are closed afterwards.
+ *
+ * @param xs            External sort.
+ * @param runs          Runs.
+ * @param k             Number of runs.
+ * @param out           Output file.
+ * @param write         Writes records to out.
+ * @return r2_uint16    Returns TRUE whenever every record was written, else FALSE.
+ */
+static r2_uint16 xmerge(struct r2_xsort *xs, FILE **runs, r2_uint64 k, FILE *out, r2_uint16 (*write)(FILE *, const void *, r2_uint64, r2_uint64))
+{
+        r2_uint64 es    = xs->es;
+        r2_uint64 block = xs->mem / (k + 1) / es > 0? xs->mem / (k + 1) / es : 1;/*records per buffer*/
+        r2_uint64 nout = 0, w;
+        r2_uint16 ok = TRUE;
+        struct r2_ltree lt;
+        struct r2_xrun *rs = malloc(sizeof(struct r2_xrun) * k);
+        char *obuf         = malloc(block * es);
+        lt.k     = k;
+        lt.cmp   = xs->cmp;
+        lt.tree  = malloc(sizeof(r2_uint64) * k);
+        lt.heads = malloc(sizeof(char *) * k);/*next record of every run*/
+        assert(rs != NULL && obuf != NULL && lt.tree != NULL && lt.heads != NULL);
+        for(r2_uint64 i = 0; i < k; ++i){
+                rs[i].fp  = runs[i];
+                rs[i].buf = malloc(block * es);
+                assert(rs[i].buf != NULL);
+                rs[i].n   = fread(rs[i].buf, es, block, rs[i].fp);
+                rs[i].pos = 0;
+                lt.heads[i] = rs[i].n > 0? rs[i].buf : NULL;
+        }
+
+        ltree_init(&lt);
+        for(w = lt.tree[0]; lt.heads[w] != NULL; w = lt.tree[0]){
+                mcpy(&obuf[nout*es], lt.heads[w], es);
+                if(++nout == block){
+                        ok   = ok == TRUE && write(out, obuf, nout, es) == TRUE;
+                        nout = 0;
+                }
+
+                if(++rs[w].pos == rs[w].n){
+                        rs[w].n   = fread(rs[w].buf, es, block, rs[w].fp);
+                        rs[w].pos = 0;
+                }
+                lt.heads[w] = rs[w].n > 0? &rs[w].buf[rs[w].pos*es] : NULL;
+                ltree_replay(&lt, w);
+        }
+        ok = ok == TRUE && write(out, obuf, nout, es) == TRUE;
+
+        for(r2_uint64 i = 0; i < k; ++i){
+                if(ferror(rs[i].fp) != 0)
+                        ok = FALSE;
+                fclose(rs[i].fp);
+                runs[i] = NULL;
+                free(rs[i].buf);
+        }
+        free(rs);
+        free(obuf);
+        free(lt.tree);
+        free(lt.heads);
+        return ok;
+}
+
+/**
+ * @brief               Reads up to n records. A partial record at the end of the input marks it as bad.
+ *
+ * @param xs            External sort.
+ * @param fp            File.
+ * @param buf           Buffer.
+ * @param n             Number of records.
+ * @return r2_uint64    Number of records read.
+ */
+static r2_uint64 xread(struct r2_xsort *xs, FILE *fp, void *buf, r2_uint64 n)
+{
+        r2_uint64 bytes = fread(buf, 1, n * xs->es, fp);
+        if(bytes % xs->es != 0)
+                xs->bad = TRUE;
+        return bytes / xs->es;
+}
+
+/**
+ * @brief               Writes n records.
+ *
+ * @param fp            File.
+ * @param buf           Records.
+ * @param n             Number of records.
+ * @param es            Record size.
+ * @return r2_uint16    Returns TRUE whenever every record was written, else FALSE.
+ */
+static r2_uint16 xwrite(FILE *fp, const void *buf, r2_uint64 n, r2_uint64 es)
+{
+        return fwrite(buf, es, n, fp) == n;
+}
+
+/**
+ * @brief               Reads up to n integers written as text. A token that isn't an integer marks the input as bad.
+ *
+ * @param xs            External sort.
+ * @param fp            File.
+ * @param buf           Buffer.
+ * @param n             Number of integers.
+ * @return r2_uint64    Number of integers read.
+ */
+static r2_uint64 xread_ints(struct r2_xsort *xs, FILE *fp, void *buf, r2_uint64 n)
+{
+        r2_int64 *keys = buf;
+        r2_uint64 i = 0;
+        int r = 1;
+        while(i < n && (r = fscanf(fp, "%lld", &keys[i])) == 1)
+                ++i;
+        if(r == 0)
+                xs->bad = TRUE;
+        return i;
+}
+
+/**
+ * @brief               Writes n integers as text, one per line.
+ *
+ * @param fp            File.
+ * @param buf           Integers.
+ * @param n             Number of integers.
+ * @param es            Size of an integer.
+ * @return r2_uint16    Returns TRUE whenever every integer was written, else FALSE.
+ */
+static r2_uint16 xwrite_ints(FILE *fp, const void *buf, r2_uint64 n, r2_uint64 es)
+{
+        const r2_int64 *keys = buf;
+        (void)es;
+        for(r2_uint64 i = 0; i < n; ++i)
+                if(fprintf(fp, "%lld\n", keys[i]) < 0)
+                        return FALSE;
+        return TRUE;
+}
+
+/**
+ * @brief               Sorts a run of integers.
+ */
+static void xsort_ints(void *arr, r2_uint64 start, r2_uint64 as, r2_uint64 es, r2_cmp cmp)
+{
+        (void)es;
+        (void)cmp;
+        r2_simd_sort_i64(arr, start, as);
+}
+
+/**
+ * @brief               Compares two integers.
+ */
+static r2_int16 xint_cmp(const void *a, const void *b)
+{
+        const r2_int64 *c = a;
+        const r2_int64 *d = b;
+        return (*c > *d) - (*c < *d);
+}
+
+/**
+ * @brief               Returns the position of the median of three elements.
+ * 
+ * @param arr           Array.
+ * @param a             Position of first element.
+ * @param b             Position of second element.
+ * @param c             Position of third element.
+ * @param es            Element size.
+ * @param cmp           A comparison callback function.
+ * @return r2_int64     Position of median.
+ */
+static r2_int64 median_of_three(char *arr, r2_int64 a, r2_int64 b, r2_int64 c, r2_uint64 es, r2_cmp cmp)
+{
+        if(cmp(&arr[a*es], &arr[b*es]) < 0){
+                if(cmp(&arr[b*es], &arr[c*es]) < 0)
+                        return b;
+                return cmp(&arr[a*es], &arr[c*es]) < 0? c : a;
+        }
+        if(cmp(&arr[a*es], &arr[c*es]) < 0)
+                return a;
+        return cmp(&arr[b*es], &arr[c*es]) < 0? c : b;
+}
+
+/**
+ * @brief       Swaps the contents of a and b.
+ * 
+ * @param a     A.
+ * @param b     B.
+ * @param size  Number of bytes.
+ */
+static void swap(char *a, char *b, r2_uint64 size)
+{
+        char t;
+        R2_MOVE(2*size);
+        for(r2_uint64 i = 0; i < size; ++i){
+                t    = a[i];
+                a[i] = b[i];
+                b[i] = t;
+        }
+}
+
+/**
+ * @brief               memcpy that counts the bytes moved when built with R2_SORT_STATS.
+ */
+static inline void* mcpy(void *dest, const void *src, r2_uint64 n)
+{
+        R2_MOVE(n);
+        return memcpy(dest, src, n);
+}
+
+/**
+ * @brief               memmove that counts the bytes moved when built with R2_SORT_STATS.
+ */
+static inline void* mmove(void *dest, const void *src, r2_uint64 n)
+{
+        R2_MOVE(n);
+        return memmove(dest, src, n);
+}
+
+/**
+ * @brief       Copies src into dest.
+ * 
+ * @param src   Src. 
+ * @param dest  Dest.   
+ * @param size  Number of bytes.
+ */
+static inline void cpy(void *src, void *dest, r2_uint64 size)
+{
+        mmove(dest, src, size);
+}
+
+/**
+ * @brief               Checks that a sorted sequence is in non-decreasing order. The check is compiled out 
+ *                      when R2_SORT_NO_VERIFY or NDEBUG is defined.
+ */
+static void is_sorted(void *arr, r2_uint64 start ,r2_uint64 size, r2_uint64 ez,r2_cmp cmp)
+{
+#if !defined(R2_SORT_NO_VERIFY)
+        char *seq = arr;
+        for(r2_uint64 i = start; i < size -1; ++i)
+                assert(cmp(&seq[i*ez], &seq[(i+1)*ez]) <= 0);
+#else
+        (void)arr;
+        (void)start;
+        (void)size;
+        (void)ez;
+        (void)cmp;
+#endif
+}
+
+/**
+ * @brief               Resets the number of bytes moved by the sorts.
+ */
+void r2_sort_reset_moves()
+{
+        moved = 0;
+}
+
+/**
+ * @brief               Returns the number of bytes the sorts moved since the last reset. Moves are only counted
+ *                      when the library is built with R2_SORT_STATS, otherwise it returns 0.
+ *
+ * @return r2_uint64    Bytes moved.
+ */
+r2_uint64 r2_sort_moves()
+{
+        return moved;
 }
\ No newline at end of file
@@ -28,4 +28,295 @@ void r2_bmerge_sort_mod(void *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
 void r2_quick_sort(void *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
 void r2_quick_sort_mod(void *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
 void r2_heap_sort(void *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
+void r2_pdq_sort(void *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
+void r2_tim_sort(void *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
+void r2_inplace_merge_sort(void *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
+
+/**
+ * @brief Selection finds the element of a given rank without sorting the whole sequence. r2_nth_element is an introselect:
+ * it partitions around the median of three and only continues on the side that holds the rank, so it takes O(n) time on 
+ * average, and it sorts the remaining range with pdqsort after 2*log2(n) partitions so the worst case is O(n log n). 
+ * r2_partial_sort selects the k smallest elements and sorts only them. r2_multi_select selects several ranks at once 
+ * by splitting the ranks at every partition, r2_quantiles computes the ranks of quantiles between 0 and 1 and selects them.
+ */
+void r2_nth_element(void *, r2_uint64, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
+void r2_partial_sort(void *, r2_uint64, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
+void r2_multi_select(void *, r2_uint64, r2_uint64, r2_uint64, const r2_uint64 *, r2_uint64, r2_cmp);
+void r2_quantiles(void *, r2_uint64, r2_uint64, r2_uint64, const r2_dbl *, r2_uint64, r2_uint64 *, r2_cmp);
+
+/**
+ * @brief Radix sort doesn't compare elements at all. Least significant digit (LSD) radix sort treats every key as a 
+ * number written in base 256 and performs one stable counting sort per digit, starting from the least significant digit. 
+ * After the pass over the most significant digit the keys are sorted. Sorting n keys of w bytes takes O(w*n) time and 
+ * O(n) extra memory. We count every digit in a single pass over the keys and skip the passes where all keys share the 
+ * same digit, so small integers stored in wide types only pay for the digits they use. 
+ * 
+ * Signed integers and floating point numbers are mapped to unsigned keys that sort in the same order before sorting 
+ * (flip the sign bit of integers, flip the sign bit of positive floats and every bit of negative floats) and mapped back afterwards.
+ * NaNs are placed at the ends of the sequence according to their sign bit.
+ * 
+ * r2_radix_sort_key sorts records of any size by an unsigned key returned by a callback. It sorts (key, position) pairs and
+ * then moves each record once, so it's stable and doesn't move large records on every pass. r2_radix_key_int64 and r2_radix_key_dbl
+ * can be used to write the callback for signed or floating point fields.
+ */
+void r2_radix_sort_u32(r2_uint32 *, r2_uint64, r2_uint64);
+void r2_radix_sort_u64(r2_uint64 *, r2_uint64, r2_uint64);
+void r2_radix_sort_int64(r2_int64 *, r2_uint64, r2_uint64);
+void r2_radix_sort_flt(float *, r2_uint64, r2_uint64);
+void r2_radix_sort_dbl(r2_dbl *, r2_uint64, r2_uint64);
+void r2_radix_sort_key(void *, r2_uint64, r2_uint64, r2_uint64, r2_key);
+r2_uint64 r2_radix_key_int64(r2_int64);
+r2_uint64 r2_radix_key_dbl(r2_dbl);
+
+/**
+ * @brief Sorting strings with a comparison function compares their common prefixes again on every comparison. The string sorts 
+ * look at one character at a time instead. r2_string_sort is multikey quicksort (Bentley and Sedgewick): it partitions the strings 
+ * into those whose character at the current depth is smaller, equal or greater than a pivot character and only moves to the next 
+ * character for the equal part. r2_string_radix_sort is MSD radix sort: it distributes the strings into 256 buckets by their 
+ * character at the current depth and sorts every bucket at the next depth. Both cache the characters at the current depth in an
+ * array so the strings are dereferenced once per pass, and both finish small subarrays with insertion sort. The strings must 
+ * be null terminated, characters are compared as unsigned so the order is the same as strcmp. Neither sort is stable.
+ */
+void r2_string_sort(char **, r2_uint64, r2_uint64);
+void r2_string_radix_sort(char **, r2_uint64, r2_uint64);
+
+/**
+ * @brief Sorting large records with the sorts above moves whole records on every swap and shift. An argsort sorts positions 
+ * instead and returns the permutation that sorts the sequence, r2_permute then applies a permutation by following its cycles 
+ * so every record is moved once. r2_argsort compares records with a comparison function, r2_key_argsort extracts an unsigned 
+ * key from every record once and radix sorts (key, position) pairs stored together, so the sort itself never touches the records.
+ * r2_key_sort does both steps. All of them are stable.
+ */
+r2_uint64* r2_argsort(const void *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
+r2_uint64* r2_key_argsort(const void *, r2_uint64, r2_uint64, r2_uint64, r2_key);
+void r2_key_sort(void *, r2_uint64, r2_uint64, r2_uint64, r2_key);
+void r2_permute(void *, r2_uint64, r2_uint64, r2_uint64, const r2_uint64 *);
+
+/**
+ * @brief The parallel sorts split the work of mergesort and quicksort between threads. r2_pmerge_sort sorts both halves in parallel and
+ * splits every large merge into two independent merges by binary searching the middle element of the larger run in the other run. 
+ * r2_pquick_sort partitions large ranges in parallel, a block per thread, and then sorts both sides of the partition in parallel.
+ * A thread is only started while fewer than r2_sort_threads() threads are working on the sort; otherwise the work is done by 
+ * the thread that found it. On POSIX systems the library must be linked with pthreads.
+ */
+void r2_pmerge_sort(void *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
+void r2_pquick_sort(void *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);
+void r2_sort_set_threads(r2_uint64);
+r2_uint64 r2_sort_threads();
+
+#define R2_SORT_SCALAR 0
+#define R2_SORT_AVX2   1
+#define R2_SORT_AVX512 2
+/**
+ * @brief The SIMD sorts sort arrays of numbers without calling a comparison function. They're quicksorts that partition 
+ * a whole vector of elements at a time: every element of the vector is compared with the pivot at once and the elements 
+ * that belong on each side are written out with a compress-store (AVX-512) or a lane permutation looked up from a table (AVX2).
+ * Subarrays of up to four registers are sorted with bitonic sorting networks in registers. After 2*log2(n) partitions a 
+ * subarray falls back to radix sort, which is also used on processors without AVX2 or on other architectures. The instruction 
+ * set is picked at runtime, r2_sort_set_simd can limit it. Floats and doubles are mapped to integers that sort in the same order,
+ * so -0 comes before 0 and NaNs are placed at the ends of the sequence according to their sign bit. None of these sorts are stable.
+ */
+void r2_simd_sort_i32(r2_int32 *, r2_uint64, r2_uint64);
+void r2_simd_sort_i64(r2_int64 *, r2_uint64, r2_uint64);
+void r2_simd_sort_flt(float *, r2_uint64, r2_uint64);
+void r2_simd_sort_dbl(r2_dbl *, r2_uint64, r2_uint64);
+void r2_sort_set_simd(r2_uint16);
+r2_uint16 r2_sort_simd();
+
+/**
+ * @brief A k-way merge merges k sorted sequences at once. Repeated two-way merging costs up to k - 1 comparisons per element,
+ * a loser tree costs about log2(k): the runs are the leaves of a tournament, every internal node remembers the loser of its
+ * match and the root the overall winner. After the winner is output only the matches on the path from its leaf to the root 
+ * are replayed against the stored losers. r2_kway_merge merges arrays with a comparison function, r2_kway_merge_int64 merges
+ * arrays of 64 bit integers without one and r2_kway_merge_iter merges sequences read one element at a time through a callback.
+ * All merges are stable, ties go to the sequence that comes first. The external sort merges its run files with the same tree.
+ */
+void r2_kway_merge(void **, const r2_uint64 *, r2_uint64, r2_uint64, void *, r2_cmp);
+void r2_kway_merge_int64(r2_int64 **, const r2_uint64 *, r2_uint64, r2_int64 *);
+r2_uint64 r2_kway_merge_iter(void **, r2_uint64, r2_uint64, r2_next, r2_act, void *, r2_cmp);
+
+/**
+ * @brief External merge sort sorts files that don't fit in memory. The input is read sequentially in runs that fit in the 
+ * memory budget, every run is sorted in memory and written to a temporary file. The runs are then merged k at a time through 
+ * a loser tree with one buffer per run, so every pass reads and writes the data sequentially. k is chosen so that each buffer gets 
+ * at least 64KB, sorting n bytes with m bytes of memory takes about 1 + log_k(n/m) passes over the data.
+ * r2_external_sort sorts binary files of fixed width records and r2_external_sort_ints sorts text files of integers.
+ * Temporary files are created with tmpfile(). Both fail instead of dropping records when the input can't be read completely, 
+ * a truncated record or a token that isn't an integer makes them return FALSE.
+ */
+r2_uint16 r2_external_sort(const char *, const char *, r2_uint64, r2_uint64, r2_cmp);
+r2_uint16 r2_external_sort_ints(const char *, const char *, r2_uint64);
+/**
+ * @brief Every sort checks its output with an O(n) pass of comparisons before returning. Building the library with 
+ * R2_SORT_NO_VERIFY (or NDEBUG) removes that pass. Building it with R2_SORT_STATS counts the bytes copied by the sorts,
+ * including copies to and from auxiliary arrays, so moves can be measured as r2_sort_moves() divided by the element size.
+ * The count is shared by all threads and isn't synchronized, parallel sorts only get an estimate.
+ */
+void r2_sort_reset_moves();
+r2_uint64 r2_sort_moves();
+
+#define R2_SORT_CUT_OFF 16
+#if defined(__GNUC__)
+#define R2_SORT_UNUSED __attribute__((unused))
+#else
+#define R2_SORT_UNUSED
+#endif
+/**
+ * @brief Every sort above compares elements through a callback and moves them byte by byte because the element type is only
+ * known at runtime. R2_SORT_DEFINE(name, type, less_expr) generates sorts for one element type instead, so the comparison is 
+ * inlined and elements are moved with plain assignment. less_expr is an expression that's true whenever the element pointed 
+ * to by a comes before the element pointed to by b, both are pointers to const type. The generated functions are static and 
+ * take the array, start and array size:
+ * 
+ *      name_insertion_sort     insertion sort.
+ *      name_quick_sort         introsort: quicksort with median of three and a heapsort fallback after 2*log2(n) partitions.
+ *      name_merge_sort         stable top down mergesort with an auxiliary array.
+ *      name_heap_sort          heapsort.
+ * 
+ * Example: R2_SORT_DEFINE(point, struct point, a->x < b->x || (a->x == b->x && a->y < b->y)) defines point_quick_sort(struct point *, r2_uint64, r2_uint64).
+ * The file that uses the macro must include stdlib.h and assert.h.
+ */
+#define R2_SORT_DEFINE(name, type, less_expr)                                                            \
+static R2_SORT_UNUSED r2_uint16 name##_less(const type *a, const type *b)                                \
+{                                                                                                        \
+        return (less_expr);                                                                              \
+}                                                                                                        \
+                                                                                                         \
+static R2_SORT_UNUSED void name##_insertion_sort(type *arr, r2_uint64 start, r2_uint64 as)               \
+{                                                                                                        \
+        type t;                                                                                          \
+        r2_uint64 j;                                                                                     \
+        for(r2_uint64 i = start + 1; i < as; ++i){                                                       \
+                if(!name##_less(&arr[i], &arr[i - 1]))                                                   \
+                        continue;                                                                        \
+                t = arr[i];                                                                              \
+                for(j = i; j > start && name##_less(&t, &arr[j - 1]); --j)                               \
+                        arr[j] = arr[j - 1];                                                             \
+                arr[j] = t;                                                                              \
+        }                                                                                                \
+}                                                                                                        \
+                                                                                                         \
+static R2_SORT_UNUSED void name##_sift_down(type *arr, r2_uint64 root, r2_uint64 n)                      \
+{                                                                                                        \
+        type t = arr[root];                                                                              \
+        r2_uint64 child;                                                                                 \
+        for(child = 2*root + 1; child < n; child = 2*root + 1){                                          \
+                if(child + 1 < n && name##_less(&arr[child], &arr[child + 1]))                           \
+                        ++child;                                                                         \
+                if(!name##_less(&t, &arr[child]))                                                        \
+                        break;                                                                           \
+                arr[root] = arr[child];                                                                  \
+                root = child;                                                                            \
+        }                                                                                                \
+        arr[root] = t;                                                                                   \
+}                                                                                                        \
+                                                                                                         \
+static R2_SORT_UNUSED void name##_heap_sort(type *arr, r2_uint64 start, r2_uint64 as)                    \
+{                                                                                                        \
+        type t;                                                                                          \
+        type *seq = &arr[start];                                                                         \
+        r2_uint64 n = as > start? as - start : 0;                                                        \
+        for(r2_uint64 i = n/2; i > 0; --i)                                                               \
+                name##_sift_down(seq, i - 1, n);                                                         \
+        for(r2_uint64 i = n; i > 1; --i){                                                                \
+                t = seq[0];                                                                              \
+                seq[0] = seq[i - 1];                                                                     \
+                seq[i - 1] = t;                                                                          \
+                name##_sift_down(seq, 0, i - 1);                                                         \
+        }                                                                                                \
+}                                                                                                        \
+                                                                                                         \
+static R2_SORT_UNUSED void name##_intro_sort(type *arr, r2_uint64 lo, r2_uint64 hi, r2_uint64 depth)     \
+{                                                                                                        \
+        type p, t;                                                                                       \
+        r2_uint64 i, j, m;                                                                               \
+        while(hi - lo > R2_SORT_CUT_OFF){                                                                \
+                if(depth-- == 0){                                                                        \
+                        name##_heap_sort(arr, lo, hi);                                                   \
+                        return;                                                                          \
+                }                                                                                        \
+                                                                                                         \
+                m = lo + (hi - lo)/2;                                                                    \
+                if(name##_less(&arr[m], &arr[lo])){                                                      \
+                        t = arr[m]; arr[m] = arr[lo]; arr[lo] = t;                                       \
+                }                                                                                        \
+                if(name##_less(&arr[hi - 1], &arr[m])){                                                  \
+                        t = arr[m]; arr[m] = arr[hi - 1]; arr[hi - 1] = t;                               \
+                        if(name##_less(&arr[m], &arr[lo])){                                              \
+                                t = arr[m]; arr[m] = arr[lo]; arr[lo] = t;                               \
+                        }                                                                                \
+                }                                                                                        \
+                                                                                                         \
+                p = arr[m];                                                                              \
+                i = lo;                                                                                  \
+                j = hi - 1;                                                                              \
+                for(;;){                                                                                 \
+                        while(name##_less(&arr[i], &p))                                                  \
+                                ++i;                                                                     \
+                        while(name##_less(&p, &arr[j]))                                                  \
+                                --j;                                                                     \
+                        if(i >= j)                                                                       \
+                                break;                                                                   \
+                        t = arr[i]; arr[i] = arr[j]; arr[j] = t;                                         \
+                        ++i;                                                                             \
+                        --j;                                                                             \
+                }                                                                                        \
+                                                                                                         \
+                if(j + 1 - lo < hi - j - 1){                                                             \
+                        name##_intro_sort(arr, lo, j + 1, depth);                                        \
+                        lo = j + 1;                                                                      \
+                }else{                                                                                   \
+                        name##_intro_sort(arr, j + 1, hi, depth);                                        \
+                        hi = j + 1;                                                                      \
+                }                                                                                        \
+        }                                                                                                \
+        name##_insertion_sort(arr, lo, hi);                                                              \
+}                                                                                                        \
+                                                                                                         \
+static R2_SORT_UNUSED void name##_quick_sort(type *arr, r2_uint64 start, r2_uint64 as)                   \
+{                                                                                                        \
+        r2_uint64 depth = 0;                                                                             \
+        for(r2_uint64 n = as > start? as - start : 0; n > 1; n >>= 1)                                    \
+                depth += 2;                                                                              \
+        if(as > start + 1)                                                                               \
+                name##_intro_sort(arr, start, as, depth);                                                \
+}                                                                                                        \
+                                                                                                         \
+static R2_SORT_UNUSED void name##_merge(type *arr, type *aux, r2_uint64 lo, r2_uint64 mid, r2_uint64 hi) \
+{                                                                                                        \
+        r2_uint64 i, j, k;                                                                               \
+        for(i = lo; i < mid; ++i)                                                                        \
+                aux[i] = arr[i];                                                                         \
+        for(i = lo, j = mid, k = lo; i < mid && j < hi; ++k){                                            \
+                if(name##_less(&arr[j], &aux[i]))                                                        \
+                        arr[k] = arr[j++];                                                               \
+                else    arr[k] = aux[i++];                                                               \
+        }                                                                                                \
+        while(i < mid)                                                                                   \
+                arr[k++] = aux[i++];                                                                     \
+}                                                                                                        \
+                                                                                                         \
+static R2_SORT_UNUSED void name##_merge_rec(type *arr, type *aux, r2_uint64 lo, r2_uint64 hi)            \
+{                                                                                                        \
+        if(hi - lo <= R2_SORT_CUT_OFF){                                                                  \
+                name##_insertion_sort(arr, lo, hi);                                                      \
+                return;                                                                                  \
+        }                                                                                                \
+                                                                                                         \
+        r2_uint64 mid = lo + (hi - lo)/2;                                                                \
+        name##_merge_rec(arr, aux, lo, mid);                                                             \
+        name##_merge_rec(arr, aux, mid, hi);                                                             \
+        if(name##_less(&arr[mid], &arr[mid - 1]))                                                        \
+                name##_merge(arr, aux, lo, mid, hi);                                                     \
+}                                                                                                        \
+                                                                                                         \
+static R2_SORT_UNUSED void name##_merge_sort(type *arr, r2_uint64 start, r2_uint64 as)                   \
+{                                                                                                        \
+        if(as <= start + 1)                                                                              \
+                return;                                                                                  \
+        type *aux = malloc(sizeof(type) * as);                                                           \
+        assert(aux != NULL);                                                                             \
+        name##_merge_rec(arr, aux, start, as);                                                           \
+        free(aux);                                                                                       \
+}
 #endif
\ No newline at end of file
@@ -1,9 +1,50 @@
 #include "r2_string.h"
+#include "r2_cpu.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <assert.h>
 #define  ALPHA_SIZE 256
 #define MAX(a,b) ((a) >= (b)? (a) : (b))
+#define BASE 0x100000001B3ULL/*odd base of the pattern set hash*/
+#define SPREAD 0x9E3779B97F4A7C15ULL/*mixes the high bits of a hash into a slot*/
+#define PLAN_SAMPLE 4096/*number of bytes of the text whose frequencies are used by r2_search_plan*/
+#define DFA_MAX 4096/*longest pattern searched with a DFA by r2_search, the table takes 2 KiB per byte of pattern*/
+/*Costs of the operations of the searches in nanoseconds measured by r2_string_bench_run, only their ratios matter.*/
+#define COST_AVX2 0.1/*scanning a byte with the AVX2 filter, as fast as the text is read from memory*/
+#define COST_SSE2 0.2/*scanning a byte with the SSE2 filter*/
+#define COST_SCAN 0.05/*scanning a byte with memchr*/
+#define COST_MEMCHR 12/*restarting memchr after a candidate*/
+#define COST_CANDIDATE 6/*leaving the vector loop for a candidate*/
+#define COST_MEMCMP 0.05/*comparing a byte with memcmp*/
+#define COST_STEP 6/*a BMH shift*/
+#define COST_BYTE 0.5/*comparing a byte in a loop*/
+#define COST_DFA 3/*a DFA transition*/
+#define COST_KMP 2.5/*a KMP transition whose branches are predicted*/
+#define COST_MISS 26/*KMP branch mispredictions when the first byte of the pattern matches half of the text*/
+#define COST_ROW 64/*building a row of the DFA*/
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        #include <immintrin.h>
+        #define R2_STRING_SIMD
+        #define R2_AVX2 __attribute__((target("avx2")))
+        #define R2_SSE2 __attribute__((target("sse2")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+        #include <intrin.h>
+        #include <immintrin.h>
+        #define R2_STRING_SIMD
+        #define R2_AVX2
+        #define R2_SSE2
+#endif
+static r2_uint16 simd_max = R2_STRING_AVX2;/*best instruction set the substring search may use*/
+static r2_uint64 pattern_scan(const struct r2_pattern *, const r2_uc *, r2_uint64, r2_uint64 *, r2_uint64, r2_uint64);
+static r2_uint64 simd_scan(const r2_uc *, r2_uint64, const r2_uc *, r2_uint64, r2_uint64 *, r2_uint64, r2_uint64);
+static r2_uint64 scalar_scan(const r2_uc *, r2_uint64, const r2_uc *, r2_uint64, r2_uint64 *, r2_uint64, r2_uint64, r2_uint64, r2_uint64);
+static r2_int64 myers(const r2_uc *, r2_uint64, const r2_uc *, r2_uint64, r2_uint64, r2_uint16, r2_uint64 *, r2_uint64, r2_uint64);
+#if defined(R2_STRING_SIMD)
+R2_AVX2 static r2_uint64 avx2_scan(const r2_uc *, r2_uint64, const r2_uc *, r2_uint64, r2_uint64 *, r2_uint64, r2_uint64, r2_uint64 *);
+R2_SSE2 static r2_uint64 sse2_scan(const r2_uc *, r2_uint64, const r2_uc *, r2_uint64, r2_uint64 *, r2_uint64, r2_uint64, r2_uint64 *);
+static unsigned int ctz(unsigned int);
+#endif
 /**
  * @brief               Performs a naive substring search for a pattern in a string.
  * 
@@ -79,7 +120,7 @@ r2_int64 r2_rabin_karp(const r2_c *str, const r2_c *pat)
 
         /*Computing hash of pattern*/
         for(r2_uint64 i = 0; pat[i] != '\0'; pl = ++i)
-                pat_hash  = (pat_hash*ALPHA_SIZE + pat[i])%prime;
+                pat_hash  = (pat_hash*ALPHA_SIZE + (r2_uc)pat[i])%prime;
         
         /*Computing significant digit*/
         for(r2_int64 i = 1; i < pl ; ++i)
@@ -87,7 +128,7 @@ r2_int64 r2_rabin_karp(const r2_c *str, const r2_c *pat)
         
         /*Computing hash of string*/
         for(r2_uint64 i = 0; str[i] != '\0' && i != pl; ++i)
-                str_hash  = (str_hash*ALPHA_SIZE + str[i])%prime; 
+                str_hash  = (str_hash*ALPHA_SIZE + (r2_uc)str[i])%prime; 
         
         if(pat_hash == str_hash){
                 while(pat[k] == str[k] && pat[k] != '\0' && str[k] != '\0')
@@ -98,8 +139,9 @@ r2_int64 r2_rabin_karp(const r2_c *str, const r2_c *pat)
         }
                 
         for(r2_uint64 i = pl; str[0] !='\0' && str[i] != '\0'; ++i){
-                str_hash = (str_hash - str[i-pl]*sig_digit)%prime; 
-                str_hash = (str_hash*ALPHA_SIZE + str[i])%prime;
+                /*Adding prime first keeps the difference from wrapping around.*/
+                str_hash = (str_hash + prime - ((r2_uc)str[i-pl]*sig_digit)%prime)%prime; 
+                str_hash = (str_hash*ALPHA_SIZE + (r2_uc)str[i])%prime;
                 if(str_hash == pat_hash){
                         /*Confirming possible match*/
                         k = 0;
@@ -165,13 +207,12 @@ r2_int64 r2_naive_dfa(const r2_c *str, const r2_c *pat)
                 for(r2_uint64 col = 0; col < ALPHA_SIZE; ++col){
                         suffix[row]  = (r2_c)col;
                         r2_uint64 lp   = 0;/*longest prefix*/
-                        for(r2_int64 i = row, j=i, p = 0; i >= 0; --i, p = 0){
-                                for(r2_int64 k = row; j >= 0; --k, --j)
-                                        if(suffix[k] == prefix[j])
-                                                ++p;
-                                        else break;
-                                if(j == -1 && p > lp)
-                                        lp = p;
+                        /*The next state is the longest prefix of the pattern that is a suffix of pat[:row] + col.*/
+                        for(r2_int64 k = row < (r2_int64)len? row + 1 : (r2_int64)len; k > 0; --k){
+                                if(memcmp(&suffix[row + 1 - k], prefix, k) == 0){
+                                        lp = k;
+                                        break;
+                                }
                         }
                         table[state][col] = lp;
                 }
@@ -179,7 +220,7 @@ r2_int64 r2_naive_dfa(const r2_c *str, const r2_c *pat)
         }
 
         for(r2_int64 row = 0, state = 0; str[row] != '\0'; ++row){
-                state = table[state][str[row]];
+                state = table[state][(r2_uc)str[row]];
                 if(state == len){
                         pos = row - state + 1;
                         break;
@@ -285,8 +326,8 @@ r2_int64 r2_bmh(const r2_c*str, const r2_c *pat)
 
         /*Stores the right most occurence of a character in pattern*/
         for(r2_int64 i = patlen-1; i >= 0; --i)
-                if(ct[pat[i]] == -1)
-                        ct[pat[i]] = i;   
+                if(ct[(r2_uc)pat[i]] == -1)
+                        ct[(r2_uc)pat[i]] = i;   
         
         /*Matching with the bad character rule only*/
         r2_uint64 len = strlen(str); 
@@ -302,8 +343,930 @@ r2_int64 r2_bmh(const r2_c*str, const r2_c *pat)
                 if(j == -1)
                         return k+1;
         
-                jmp = MAX(1, j-ct[str[k]]);
+                jmp = MAX(1, j-ct[(r2_uc)str[k]]);
                 pos = pos + jmp; /*Calculating the shift amount*/
         }
      return -1;    
-}
\ No newline at end of file
+}
+
+/**
+ * @brief               Compiles a pattern for repeated searches. The pattern is copied and preprocessed once for the chosen
+ *                      algorithm so every search only scans the text:
+ * 
+ *                      R2_PATTERN_KMP builds the Knuth-Morris-Pratt failure table in O(m).
+ *                      R2_PATTERN_BMH builds the Boyer-Moore-Horspool shift table in O(m + 256).
+ *                      R2_PATTERN_DFA builds the DFA of the pattern in O(256*m) using the KMP restart state.
+ *                      R2_PATTERN_SIMD needs no table, searches use r2_simd_substring's first and last byte filter.
+ *                      R2_PATTERN_AUTO picks one of them with r2_search_plan, using the bytes of the pattern as a 
+ *                      sample of the texts.
+ * 
+ *                      The pattern doesn't have to be null terminated and may contain any byte.
+ *
+ * @param pat           Pattern.
+ * @param len           Length of pattern.
+ * @param algo          R2_PATTERN_KMP, R2_PATTERN_BMH, R2_PATTERN_DFA, R2_PATTERN_SIMD or R2_PATTERN_AUTO.
+ * @return struct r2_pattern*   Returns the compiled pattern, else NULL. An unknown algo returns NULL.
+ */
+struct r2_pattern* r2_pattern_compile(const r2_c *pat, r2_uint64 len, r2_uint16 algo)
+{
+        const r2_uc *p = (const r2_uc *)pat;
+        struct r2_pattern *cp = NULL;
+        r2_uint64 x;
+        if(algo > R2_PATTERN_AUTO)
+                return NULL;
+
+        cp = calloc(1, sizeof(struct r2_pattern));
+        if(cp == NULL)
+                return NULL;
+
+        if(algo == R2_PATTERN_AUTO)
+                algo = r2_search_plan(NULL, 0, pat, len);
+        cp->len  = len;
+        cp->algo = algo;
+        cp->pat  = malloc(len + 1);
+        if(cp->pat == NULL)
+                return r2_destroy_pattern(cp);
+        memcpy(cp->pat, p, len);
+        cp->pat[len] = '\0';
+        if(len == 0)
+                return cp;
+
+        if(algo == R2_PATTERN_KMP){
+                cp->ft = calloc(len, sizeof(r2_uint64));
+                if(cp->ft == NULL)
+                        return r2_destroy_pattern(cp);
+
+                x = 0;
+                for(r2_uint64 i = 1; i < len; ++i){
+                        while(x > 0 && p[x] != p[i])
+                                x = cp->ft[x-1];
+                        if(p[x] == p[i])
+                                ++x;
+                        cp->ft[i] = x;
+                }
+        }else if(algo == R2_PATTERN_BMH){
+                for(r2_uint64 c = 0; c < ALPHA_SIZE; ++c)
+                        cp->shift[c] = len;
+                for(r2_uint64 i = 0; i + 1 < len; ++i)
+                        cp->shift[p[i]] = len - 1 - i;
+        }else if(algo == R2_PATTERN_DFA){
+                /*Row len is the state after a match, it continues like the longest border of the pattern.*/
+                cp->dfa = calloc((len + 1) * ALPHA_SIZE, sizeof(r2_uint64));
+                if(cp->dfa == NULL)
+                        return r2_destroy_pattern(cp);
+
+                cp->dfa[p[0]] = 1;
+                x = 0;
+                for(r2_uint64 s = 1; s <= len; ++s){
+                        memcpy(&cp->dfa[s*ALPHA_SIZE], &cp->dfa[x*ALPHA_SIZE], sizeof(r2_uint64) * ALPHA_SIZE);
+                        if(s < len){
+                                cp->dfa[s*ALPHA_SIZE + p[s]] = s + 1;
+                                x = cp->dfa[x*ALPHA_SIZE + p[s]];
+                        }
+                }
+        }
+        return cp;
+}
+
+/**
+ * @brief               Destroys a compiled pattern.
+ *
+ * @param cp            Compiled pattern.
+ * @return struct r2_pattern*   Returns NULL.
+ */
+struct r2_pattern* r2_destroy_pattern(struct r2_pattern *cp)
+{
+        if(cp != NULL){
+                free(cp->pat);
+                free(cp->ft);
+                free(cp->dfa);
+                free(cp);
+        }
+        return NULL;
+}
+
+/**
+ * @brief               Searches a text for a compiled pattern. The text doesn't have to be null terminated.
+ *
+ * @param cp            Compiled pattern.
+ * @param text          Text.
+ * @param len           Length of text.
+ * @return r2_int64     Returns the location of the first match found, else -1.
+ */
+r2_int64 r2_pattern_search(const struct r2_pattern *cp, const r2_c *text, r2_uint64 len)
+{
+        r2_uint64 pos = 0;
+        return pattern_scan(cp, (const r2_uc *)text, len, &pos, 1, 1) > 0? (r2_int64)pos : -1;
+}
+
+/**
+ * @brief               Finds every match of a compiled pattern in a text, matches may overlap. 
+ *
+ * @param cp            Compiled pattern.
+ * @param text          Text.
+ * @param len           Length of text.
+ * @param matches       Locations of the matches in increasing order, can be NULL.
+ * @param nmatches      Maximum number of locations stored in matches.
+ * @return r2_uint64    Returns the number of matches, which can be larger than nmatches.
+ */
+r2_uint64 r2_pattern_find_all(const struct r2_pattern *cp, const r2_c *text, r2_uint64 len, r2_uint64 *matches, r2_uint64 nmatches)
+{
+        return pattern_scan(cp, (const r2_uc *)text, len, matches, matches != NULL? nmatches : 0, (r2_uint64)-1);
+}
+
+/**
+ * @brief               Picks the fastest algorithm to search a text for a pattern. The byte frequencies f of a sample,
+ *                      the first 4096 bytes of the text or the pattern itself when there's no text, give the expected
+ *                      cost per byte of text of every algorithm, assuming the bytes of the text are independent:
+ *
+ *                      The SIMD filter stops at a fraction f[first]*f[last] of the positions (memchr without SSE2
+ *                      stops at f[first]) and compares the pattern until the first mismatch, which takes more bytes
+ *                      when the bytes of the pattern are frequent in the text.
+ *                      BMH moves by the average of its shifts weighted by f, which is short for small alphabets.
+ *                      KMP reads every byte once and is fast when its branches are predicted, when the first byte of
+ *                      the pattern is either rare or very frequent.
+ *                      The DFA reads every byte once without branches and builds a table of 256 entries per byte of
+ *                      the pattern, which costs more than it saves in short texts.
+ *
+ *                      The costs of the operations were measured on x86-64 by r2_string_bench_run, whose corpora 
+ *                      cover large and small alphabets and the periodic patterns that make filters and BMH quadratic.
+ *                      Patterns of 1 byte always use the SIMD search (memchr), patterns of 2 bytes do unless the
+ *                      processor has no SSE2 and memchr would stop at most bytes.
+ *
+ * @param text          Text, NULL when the text isn't known yet (R2_PATTERN_AUTO).
+ * @param len           Length of text.
+ * @param pat           Pattern.
+ * @param plen          Length of pattern.
+ * @return r2_uint16    R2_PATTERN_KMP, R2_PATTERN_BMH, R2_PATTERN_DFA or R2_PATTERN_SIMD.
+ */
+r2_uint16 r2_search_plan(const r2_c *text, r2_uint64 len, const r2_c *pat, r2_uint64 plen)
+{
+        const r2_uc *p = (const r2_uc *)pat;
+        const r2_uc *sample = text != NULL? (const r2_uc *)text : p;
+        r2_uint64 n = text != NULL? (len < PLAN_SAMPLE? len : PLAN_SAMPLE) : plen;
+        r2_uint64 bshift[ALPHA_SIZE];
+        r2_uint16 level = r2_string_simd();
+        r2_uint16 algo  = R2_PATTERN_SIMD;
+        r2_dbl f[ALPHA_SIZE] = {0};
+        r2_dbl filter = 1, left = 1, run = 1, shift = 0, best, cost;
+        if(plen < 2 || n == 0)
+                return R2_PATTERN_SIMD;
+
+        for(r2_uint64 i = 0; i < n; ++i)
+                f[sample[i]] += 1.0/n;
+        /*Expected number of bytes compared at a candidate, a byte is only compared when the bytes before it matched.*/
+        for(r2_uint64 i = 1; i + 1 < plen && run > 1e-6; ++i){
+                run    *= f[p[i]];
+                filter += run;
+        }
+        run = 1;
+        for(r2_uint64 i = 0; i + 1 < plen && run > 1e-6; ++i){
+                run  *= f[p[i]];
+                left += run;
+        }
+
+        if(level != R2_STRING_SCALAR)
+                best = (level == R2_STRING_AVX2? COST_AVX2 : COST_SSE2) + f[p[0]]*f[p[plen-1]]*(COST_CANDIDATE + COST_MEMCMP*filter);
+        else    best = COST_SCAN + f[p[0]]*COST_MEMCHR + f[p[0]]*f[p[plen-1]]*COST_MEMCMP*filter;
+
+        for(r2_uint64 c = 0; c < ALPHA_SIZE; ++c)
+                bshift[c] = plen;
+        for(r2_uint64 i = 0; i + 1 < plen; ++i)
+                bshift[p[i]] = plen - 1 - i;
+        for(r2_uint64 c = 0; c < ALPHA_SIZE; ++c)
+                shift += f[c]*bshift[c];
+        /*BMH skips bytes but still reads most cache lines of the text.*/
+        cost = COST_AVX2 + (COST_STEP + f[p[plen-1]]*COST_BYTE*left)/shift;
+        if(cost < best){
+                best = cost;
+                algo = R2_PATTERN_BMH;
+        }
+
+        /*KMP branches on every byte and mispredicts when the first byte of the pattern matches about half of the text.*/
+        cost = COST_KMP + COST_MISS*f[p[0]]*(1 - f[p[0]]);
+        if(cost < best){
+                best = cost;
+                algo = R2_PATTERN_KMP;
+        }
+
+        /*The table of the DFA is built for every search, a text that isn't known is assumed to be much longer.*/
+        cost = COST_DFA + (text != NULL? (r2_dbl)(plen + 1)*COST_ROW/len : 0);
+        if(plen <= DFA_MAX && cost < best)
+                algo = R2_PATTERN_DFA;
+        return algo;
+}
+
+/**
+ * @brief               Searches a text for a pattern with the algorithm picked by r2_search_plan. Neither the text
+ *                      nor the pattern have to be null terminated. 
+ *
+ * @param text          Text.
+ * @param len           Length of text.
+ * @param pat           Pattern.
+ * @param plen          Length of pattern.
+ * @return r2_int64     Returns the location of the first match found, else -1.
+ */
+r2_int64 r2_search(const r2_c *text, r2_uint64 len, const r2_c *pat, r2_uint64 plen)
+{
+        struct r2_pattern *cp = NULL;
+        r2_uint64 n = PLAN_SAMPLE + plen - 1;
+        r2_int64 pos;
+        if(plen == 0)
+                return 0;
+        if(plen > len)
+                return -1;
+
+        /*Matches near the start are found by the SIMD search before the plan costs more than the search.*/
+        pos = r2_simd_substring(text, len < n? len : n, pat, plen);
+        if(pos >= 0 || len <= n)
+                return pos;
+
+        r2_uint16 algo = r2_search_plan(text, len, pat, plen);
+        if(algo != R2_PATTERN_SIMD)
+                cp = r2_pattern_compile(pat, plen, algo);
+        /*The SIMD search needs no table, it's also used when the table couldn't be allocated.*/
+        if(cp == NULL)
+                pos = r2_simd_substring(&text[PLAN_SAMPLE], len - PLAN_SAMPLE, pat, plen);
+        else    pos = r2_pattern_search(cp, &text[PLAN_SAMPLE], len - PLAN_SAMPLE);
+        r2_destroy_pattern(cp);
+        return pos >= 0? pos + PLAN_SAMPLE : -1;
+}
+
+/**
+ * @brief               Creates a matcher that searches a stream for a compiled pattern. 
+ *
+ * @param cp            Compiled pattern, R2_PATTERN_KMP or R2_PATTERN_DFA. It must outlive the matcher.
+ * @return struct r2_matcher*   Returns the matcher, else NULL when the pattern is empty or uses another algorithm.
+ */
+struct r2_matcher* r2_create_matcher(const struct r2_pattern *cp)
+{
+        assert(cp != NULL);
+        if(cp->len == 0 || (cp->algo != R2_PATTERN_KMP && cp->algo != R2_PATTERN_DFA))
+                return NULL;
+
+        struct r2_matcher *sm = malloc(sizeof(struct r2_matcher));
+        if(sm != NULL){
+                sm->cp = cp;
+                r2_matcher_reset(sm);
+        }
+        return sm;
+}
+
+/**
+ * @brief               Destroys a matcher. The compiled pattern isn't destroyed.
+ *
+ * @param sm            Matcher.
+ * @return struct r2_matcher*   Returns NULL.
+ */
+struct r2_matcher* r2_destroy_matcher(struct r2_matcher *sm)
+{
+        free(sm);
+        return NULL;
+}
+
+/**
+ * @brief               Starts a new stream.
+ *
+ * @param sm            Matcher.
+ */
+void r2_matcher_reset(struct r2_matcher *sm)
+{
+        sm->state  = 0;
+        sm->offset = 0;
+}
+
+/**
+ * @brief               Feeds the next chunk of a stream to a matcher. The search resumes from the state left by the
+ *                      previous chunk, so a match may start in an earlier chunk. Matches may overlap. 
+ *
+ * @param sm            Matcher.
+ * @param chunk         Next chunk of the stream, it doesn't have to be null terminated.
+ * @param len           Length of chunk.
+ * @param action        A callback function called for every match with a pointer to the r2_uint64 offset of the
+ *                      match from the start of the stream, can be NULL.
+ * @param arg           Argument passed to action.
+ * @return r2_uint64    Returns the number of matches that end in this chunk.
+ */
+r2_uint64 r2_matcher_feed(struct r2_matcher *sm, const r2_c *chunk, r2_uint64 len, r2_act action, void *arg)
+{
+        assert(sm != NULL && (chunk != NULL || len == 0));
+        const struct r2_pattern *cp = sm->cp;
+        const r2_uc *text = (const r2_uc *)chunk;
+        const r2_uc *pat  = cp->pat;
+        r2_uint64 m = cp->len;
+        r2_uint64 s = sm->state;
+        r2_uint64 count = 0;
+        r2_uint64 pos;
+        if(cp->algo == R2_PATTERN_DFA){
+                for(r2_uint64 i = 0; i < len; ++i){
+                        s = cp->dfa[s*ALPHA_SIZE + text[i]];
+                        if(s == m){
+                                ++count;
+                                if(action != NULL){
+                                        pos = sm->offset + i + 1 - m;
+                                        action(&pos, arg);
+                                }
+                        }
+                }
+        }else{
+                for(r2_uint64 i = 0; i < len; ++i){
+                        while(s > 0 && pat[s] != text[i])
+                                s = cp->ft[s-1];
+                        if(pat[s] == text[i])
+                                ++s;
+                        if(s == m){
+                                ++count;
+                                if(action != NULL){
+                                        pos = sm->offset + i + 1 - m;
+                                        action(&pos, arg);
+                                }
+                                s = cp->ft[m-1];
+                        }
+                }
+        }
+        sm->state   = s;
+        sm->offset += len;
+        return count;
+}
+
+/**
+ * @brief               Searches a text for a pattern using SIMD instructions. Positions where the first and the last
+ *                      byte of the pattern match are found 32 (AVX2) or 16 (SSE2) positions at a time and only those
+ *                      are compared with the whole pattern. Neither the text nor the pattern have to be null terminated.
+ *
+ * @param text          Text.
+ * @param len           Length of text.
+ * @param pat           Pattern.
+ * @param plen          Length of pattern.
+ * @return r2_int64     Returns the location of the first match found, else -1.
+ */
+r2_int64 r2_simd_substring(const r2_c *text, r2_uint64 len, const r2_c *pat, r2_uint64 plen)
+{
+        r2_uint64 pos = 0;
+        if(plen == 0)
+                return 0;
+        if(plen > len)
+                return -1;
+        return simd_scan((const r2_uc *)text, len, (const r2_uc *)pat, plen, &pos, 1, 1) > 0? (r2_int64)pos : -1;
+}
+
+/**
+ * @brief               Limits the instruction set used by the SIMD substring search.
+ *
+ * @param level         R2_STRING_SCALAR, R2_STRING_SSE2 or R2_STRING_AVX2.
+ */
+void r2_string_set_simd(r2_uint16 level)
+{
+        simd_max = level;
+}
+
+/**
+ * @brief               Returns the instruction set used by the SIMD substring search. This is the best one supported
+ *                      by the processor and the operating system that's allowed by r2_string_set_simd.
+ *
+ * @return r2_uint16    R2_STRING_SCALAR, R2_STRING_SSE2 or R2_STRING_AVX2.
+ */
+r2_uint16 r2_string_simd()
+{
+        r2_uint16 cpu   = r2_cpu_simd();
+        r2_uint16 level = cpu >= R2_CPU_AVX2? R2_STRING_AVX2 : (cpu == R2_CPU_SSE2? R2_STRING_SSE2 : R2_STRING_SCALAR);
+        return level < simd_max? level : simd_max;
+}
+
+/**
+ * @brief               Finds the first approximate match of a pattern with the bit-parallel Shift-And algorithm
+ *                      extended to errors by Wu and Manber. Bit i of R[d] is set when the first i + 1 bytes
+ *                      of the pattern match a substring ending at the current byte of the text with at most d
+ *                      insertions, deletions or substitutions, so every byte of the text updates k + 1 words.
+ *                      Patterns longer than 64 bytes are searched with Myers' algorithm.
+ *
+ * @param text          Text, it doesn't have to be null terminated.
+ * @param len           Length of text.
+ * @param pat           Pattern, it doesn't have to be null terminated.
+ * @param plen          Length of pattern.
+ * @param k             Maximum number of errors.
+ * @return r2_int64     Returns the end of the first match, the position after its last byte, else -1.
+ */
+r2_int64 r2_bitap(const r2_c *text, r2_uint64 len, const r2_c *pat, r2_uint64 plen, r2_uint64 k)
+{
+        const r2_uc *t = (const r2_uc *)text;
+        const r2_uc *p = (const r2_uc *)pat;
+        r2_uint64 B[ALPHA_SIZE] = {0};
+        r2_uint64 R[65];
+        r2_uint64 old, cur, last;
+        r2_uint64 end = 0;
+        if(k >= plen)
+                return 0;
+        if(plen > 64)
+                return myers(t, len, p, plen, k, FALSE, &end, 1, 1) > 0? (r2_int64)end : -1;
+
+        for(r2_uint64 i = 0; i < plen; ++i)
+                B[p[i]] |= (r2_uint64)1 << i;
+        /*A prefix of d bytes matches the empty string with d deletions.*/
+        for(r2_uint64 d = 0; d <= k; ++d)
+                R[d] = ((r2_uint64)1 << d) - 1;
+
+        last = (r2_uint64)1 << (plen - 1);
+        for(r2_uint64 j = 0; j < len; ++j){
+                old  = R[0];
+                R[0] = ((R[0] << 1) | 1) & B[t[j]];
+                for(r2_uint64 d = 1; d <= k; ++d){
+                        /*match, insertion, substitution and deletion*/
+                        cur  = R[d];
+                        R[d] = (((cur << 1) | 1) & B[t[j]]) | old | (((old | R[d - 1]) << 1) | 1);
+                        old  = cur;
+                }
+                if((R[k] & last) != 0)
+                        return j + 1;
+        }
+        return -1;
+}
+
+/**
+ * @brief               Computes the edit distance (Levenshtein distance) of two strings with Myers' bit-vector
+ *                      algorithm. A column of the dynamic programming table is kept as the bit-vectors of its
+ *                      positive and negative vertical differences, so 64 cells are computed with a few word operations.
+ *                      Strings longer than 64 bytes are split into blocks of 64 bytes that pass the horizontal
+ *                      difference of their last row to the next block. It takes O(n*ceil(m/64)) time where m is the
+ *                      length of the shorter string.
+ *
+ * @param a             First string, it doesn't have to be null terminated.
+ * @param alen          Length of first string.
+ * @param b             Second string, it doesn't have to be null terminated.
+ * @param blen          Length of second string.
+ * @return r2_int64     Returns the edit distance, else -1 when memory couldn't be allocated.
+ */
+r2_int64 r2_edit_distance(const r2_c *a, r2_uint64 alen, const r2_c *b, r2_uint64 blen)
+{
+        if(alen > blen)
+                return r2_edit_distance(b, blen, a, alen);
+        if(alen == 0)
+                return blen;
+        return myers((const r2_uc *)b, blen, (const r2_uc *)a, alen, 0, TRUE, NULL, 0, (r2_uint64)-1);
+}
+
+/**
+ * @brief               Finds every position of a text where a substring within k edits of a pattern ends, using
+ *                      Myers' bit-vector algorithm. The first row of the table is 0 so a match may start anywhere.
+ *
+ * @param text          Text, it doesn't have to be null terminated.
+ * @param len           Length of text.
+ * @param pat           Pattern, it doesn't have to be null terminated.
+ * @param plen          Length of pattern.
+ * @param k             Maximum number of edits.
+ * @param ends          Ends of the matches in increasing order, the position after their last byte, can be NULL.
+ * @param nends         Maximum number of ends stored in ends.
+ * @return r2_int64     Returns the number of ends, which can be larger than nends, else -1 when memory couldn't be allocated.
+ */
+r2_int64 r2_approx_find_all(const r2_c *text, r2_uint64 len, const r2_c *pat, r2_uint64 plen, r2_uint64 k, r2_uint64 *ends, r2_uint64 nends)
+{
+        r2_uint64 count = 0;
+        if(k >= plen){
+                /*Every position matches by deleting the pattern.*/
+                for(; count <= len; ++count)
+                        if(ends != NULL && count < nends)
+                                ends[count] = count;
+                return count;
+        }
+        return myers((const r2_uc *)text, len, (const r2_uc *)pat, plen, k, FALSE, ends, ends != NULL? nends : 0, (r2_uint64)-1);
+}
+
+/**
+ * @brief               Builds a set of patterns that all have the same length.
+ *
+ *                      Windows are hashed with a polynomial hash modulo 2^64, so the hash of the next window 
+ *                      is computed with two multiplications and no division: h = (h - first*BASE^(len-1))*BASE + next.
+ *                      The slot of a hash is taken from the high bits of the hash times a large odd constant 
+ *                      because the low bits of a polynomial hash modulo 2^64 only depend on the low bits of the bytes.
+ *                      The table has at least twice as many slots as patterns and collisions are resolved by linear
+ *                      probing, so most windows are rejected by one empty slot or one hash comparison.
+ *
+ * @param pats          Patterns, they don't have to be null terminated.
+ * @param npats         Number of patterns.
+ * @param len           Length of every pattern, at least 1.
+ * @return struct r2_patternset*        Returns the pattern set, else NULL.
+ */
+struct r2_patternset* r2_create_patternset(const r2_c **pats, r2_uint64 npats, r2_uint64 len)
+{
+        struct r2_patternset *ps = NULL;
+        r2_uint64 slots = 2, h, slot;
+        if(len == 0)
+                return NULL;
+
+        ps = calloc(1, sizeof(struct r2_patternset));
+        if(ps == NULL)
+                return NULL;
+
+        ps->npats = npats;
+        ps->len   = len;
+        ps->shift = 63;
+        while(slots < 2*npats){
+                slots *= 2;
+                --ps->shift;
+        }
+        ps->pats   = malloc(npats * len + 1);
+        ps->hashes = malloc(sizeof(r2_uint64) * slots);
+        ps->ids    = calloc(slots, sizeof(r2_uint64));
+        if(ps->pats == NULL || ps->hashes == NULL || ps->ids == NULL)
+                return r2_destroy_patternset(ps);
+
+        ps->pow = 1;
+        for(r2_uint64 i = 1; i < len; ++i)
+                ps->pow *= BASE;
+
+        for(r2_uint64 p = 0; p < npats; ++p){
+                memcpy(&ps->pats[p*len], pats[p], len);
+                h = 0;
+                for(r2_uint64 i = 0; i < len; ++i)
+                        h = h*BASE + (r2_uc)pats[p][i];
+                for(slot = (h*SPREAD) >> ps->shift; ps->ids[slot] != 0; slot = (slot + 1) & (slots - 1));
+                ps->hashes[slot] = h;
+                ps->ids[slot]    = p + 1;
+        }
+        return ps;
+}
+
+/**
+ * @brief               Destroys a pattern set.
+ *
+ * @param ps            Pattern set.
+ * @return struct r2_patternset*        Returns NULL.
+ */
+struct r2_patternset* r2_destroy_patternset(struct r2_patternset *ps)
+{
+        if(ps != NULL){
+                free(ps->pats);
+                free(ps->hashes);
+                free(ps->ids);
+                free(ps);
+        }
+        return NULL;
+}
+
+/**
+ * @brief               Finds every occurrence of every pattern of a set in one pass. Windows whose hash is in the
+ *                      set are compared with the patterns that have that hash. For every match action is called 
+ *                      with a struct r2_setmatch holding the position of the match and the index of the pattern.
+ *                      Matches are reported in order of position.
+ *
+ * @param ps            Pattern set.
+ * @param text          Text, it doesn't have to be null terminated.
+ * @param len           Length of text.
+ * @param action        A callback function called for every match, can be NULL.
+ * @param arg           Argument passed to action.
+ * @return r2_uint64    Returns the number of matches.
+ */
+r2_uint64 r2_patternset_search(const struct r2_patternset *ps, const r2_c *text, r2_uint64 len, r2_act action, void *arg)
+{
+        assert(ps != NULL && (text != NULL || len == 0));
+        const r2_uc *t = (const r2_uc *)text;
+        r2_uint64 m = ps->len;
+        r2_uint64 mask  = ((r2_uint64)-1 >> ps->shift);
+        r2_uint64 count = 0;
+        r2_uint64 h = 0, slot, id;
+        struct r2_setmatch match;
+        if(m > len || ps->npats == 0)
+                return 0;
+
+        for(r2_uint64 i = 0; i < m; ++i)
+                h = h*BASE + t[i];
+        for(r2_uint64 pos = 0;; ++pos){
+                for(slot = (h*SPREAD) >> ps->shift; (id = ps->ids[slot]) != 0; slot = (slot + 1) & mask){
+                        if(ps->hashes[slot] != h || memcmp(&ps->pats[(id - 1)*m], &t[pos], m) != 0)
+                                continue;
+                        ++count;
+                        if(action != NULL){
+                                match.pos = pos;
+                                match.id  = id - 1;
+                                action(&match, arg);
+                        }
+                }
+
+                if(pos + m == len)
+                        break;
+                h = (h - t[pos]*ps->pow)*BASE + t[pos + m];
+        }
+        return count;
+}
+
+/**
+ * @brief               Scans a text for a compiled pattern.
+ *
+ * @param cp            Compiled pattern.
+ * @param text          Text.
+ * @param len           Length of text.
+ * @param matches       Locations of the matches.
+ * @param nmatches      Maximum number of locations stored in matches.
+ * @param limit         The scan stops after limit matches.
+ * @return r2_uint64    Returns the number of matches.
+ */
+static r2_uint64 pattern_scan(const struct r2_pattern *cp, const r2_uc *text, r2_uint64 len, r2_uint64 *matches, r2_uint64 nmatches, r2_uint64 limit)
+{
+        const r2_uc *pat = cp->pat;
+        /*Tables are read through locals, stores to matches could alias them and would reload them every byte.*/
+        const r2_uint64 *ft  = cp->ft;
+        const r2_uint64 *dfa = cp->dfa;
+        const r2_uint64 *shift = cp->shift;
+        r2_uint64 m = cp->len;
+        r2_uint64 count = 0;
+        r2_uint64 s, j;
+        if(m > len)
+                return 0;
+
+        if(m == 0){
+                for(; count <= len && count < limit; ++count)
+                        if(count < nmatches)
+                                matches[count] = count;
+                return count;
+        }
+
+        if(cp->algo == R2_PATTERN_KMP){
+                s = 0;
+                for(r2_uint64 i = 0; i < len && count < limit; ++i){
+                        while(s > 0 && pat[s] != text[i])
+                                s = ft[s-1];
+                        s += pat[s] == text[i];
+                        if(s == m){
+                                if(count < nmatches)
+                                        matches[count] = i + 1 - m;
+                                ++count;
+                                s = ft[m-1];
+                        }
+                }
+        }else if(cp->algo == R2_PATTERN_BMH){
+                /*Compare the last byte first, then the rest from left to right.*/
+                for(r2_uint64 pos = 0; pos + m <= len && count < limit; pos += shift[text[pos + m - 1]]){
+                        if(text[pos + m - 1] != pat[m - 1])
+                                continue;
+                        for(j = 0; j + 1 < m && text[pos + j] == pat[j]; ++j);
+                        if(j + 1 >= m){
+                                if(count < nmatches)
+                                        matches[count] = pos;
+                                ++count;
+                        }
+                }
+        }else if(cp->algo == R2_PATTERN_DFA){
+                s = 0;
+                for(r2_uint64 i = 0; i < len && count < limit; ++i){
+                        s = dfa[s*ALPHA_SIZE + text[i]];
+                        if(s == m){
+                                if(count < nmatches)
+                                        matches[count] = i + 1 - m;
+                                ++count;
+                        }
+                }
+        }else{
+                count = simd_scan(text, len, pat, m, matches, nmatches, limit);
+        }
+        return count;
+}
+
+/**
+ * @brief               Myers' bit-vector algorithm with blocks of 64 rows (Hyyrö's formulation). Pv and Mv hold
+ *                      the rows of the current column that are one larger or one smaller than the row above. 
+ *                      Every block computes the horizontal differences Ph and Mh of its rows, the carry of the 
+ *                      addition is replaced by the horizontal difference of the row above the block.
+ *
+ * @param text          Text.
+ * @param n             Length of text.
+ * @param pat           Pattern, m > 0.
+ * @param m             Length of pattern.
+ * @param k             Maximum number of edits of a match.
+ * @param global        TRUE for the edit distance of the whole text, FALSE to search for matches.
+ * @param ends          Ends of the matches.
+ * @param nends         Maximum number of ends stored in ends.
+ * @param limit         The search stops after limit matches.
+ * @return r2_int64     Returns the edit distance or the number of matches, else -1 when memory couldn't be allocated.
+ */
+static r2_int64 myers(const r2_uc *text, r2_uint64 n, const r2_uc *pat, r2_uint64 m, r2_uint64 k, r2_uint16 global, r2_uint64 *ends, r2_uint64 nends, r2_uint64 limit)
+{
+        r2_uint64 nb = (m + 63)/64;
+        r2_uint64 small[ALPHA_SIZE + 2];
+        r2_uint64 *peq = small;/*peq[c*nb + b] has the bits of the rows of block b where the pattern has c*/
+        r2_uint64 *P, *M, *eq;
+        r2_uint64 pv, mv, xv, xh, ph, mh, e, top;
+        r2_uint64 high  = (r2_uint64)1 << ((m - 1) % 64);
+        r2_uint64 count = 0;
+        r2_int64 score  = m;
+        r2_int64 hin, hout;
+        if(nb > 1){
+                peq = malloc(sizeof(r2_uint64) * (ALPHA_SIZE + 2) * nb);
+                if(peq == NULL)
+                        return -1;
+        }
+
+        P = &peq[ALPHA_SIZE * nb];
+        M = &P[nb];
+        if(nb == 1){
+                /*Short strings only clear the entries they read instead of the whole table.*/
+                for(r2_uint64 j = 0; j < n; ++j)
+                        peq[text[j]] = 0;
+                for(r2_uint64 i = 0; i < m; ++i)
+                        peq[pat[i]] = 0;
+        }else   memset(peq, 0, sizeof(r2_uint64) * ALPHA_SIZE * nb);
+        for(r2_uint64 i = 0; i < m; ++i)
+                peq[pat[i]*nb + i/64] |= (r2_uint64)1 << (i % 64);
+        for(r2_uint64 b = 0; b < nb; ++b){
+                P[b] = ~(r2_uint64)0;
+                M[b] = 0;
+        }
+
+        for(r2_uint64 j = 0; j < n && count < limit; ++j){
+                eq  = &peq[text[j]*nb];
+                hin = global == TRUE? 1 : 0;
+                for(r2_uint64 b = 0; b < nb; ++b){
+                        pv = P[b];
+                        mv = M[b];
+                        e  = eq[b];
+                        xv = e | mv;
+                        if(hin < 0)
+                                e |= 1;
+                        xh = (((e & pv) + pv) ^ pv) | e;
+                        ph = mv | ~(xh | pv);
+                        mh = pv & xh;
+
+                        top  = b == nb - 1? high : (r2_uint64)1 << 63;
+                        hout = (ph & top) != 0? 1 : (mh & top) != 0? -1 : 0;
+                        ph <<= 1;
+                        mh <<= 1;
+                        if(hin < 0)
+                                mh |= 1;
+                        else if(hin > 0)
+                                ph |= 1;
+                        P[b] = mh | ~(xv | ph);
+                        M[b] = ph & xv;
+                        hin  = hout;
+                }
+
+                score += hin;
+                if(global == FALSE && score <= (r2_int64)k){
+                        if(count < nends)
+                                ends[count] = j + 1;
+                        ++count;
+                }
+        }
+
+        if(nb > 1)
+                free(peq);
+        return global == TRUE? score : (r2_int64)count;
+}
+
+/**
+ * @brief               Finds the matches of a pattern with the best instruction set available, the vector loop stops
+ *                      before it would read past the text and the remaining positions are scanned one at a time.
+ *
+ * @param text          Text.
+ * @param len           Length of text.
+ * @param pat           Pattern, 0 < m <= len.
+ * @param m             Length of pattern.
+ * @param matches       Locations of the matches.
+ * @param nmatches      Maximum number of locations stored in matches.
+ * @param limit         The scan stops after limit matches.
+ * @return r2_uint64    Returns the number of matches.
+ */
+static r2_uint64 simd_scan(const r2_uc *text, r2_uint64 len, const r2_uc *pat, r2_uint64 m, r2_uint64 *matches, r2_uint64 nmatches, r2_uint64 limit)
+{
+        r2_uint64 count = 0;
+        r2_uint64 pos   = 0;
+        #if defined(R2_STRING_SIMD)
+                r2_uint16 level = r2_string_simd();
+                if(level == R2_STRING_AVX2)
+                        count = avx2_scan(text, len, pat, m, matches, nmatches, limit, &pos);
+                else if(level == R2_STRING_SSE2)
+                        count = sse2_scan(text, len, pat, m, matches, nmatches, limit, &pos);
+        #endif
+        return scalar_scan(text, len, pat, m, matches, nmatches, limit, pos, count);
+}
+
+/**
+ * @brief               Finds the matches of a pattern starting at pos. The first byte is found with memchr.
+ *
+ * @param text          Text.
+ * @param len           Length of text.
+ * @param pat           Pattern.
+ * @param m             Length of pattern.
+ * @param matches       Locations of the matches.
+ * @param nmatches      Maximum number of locations stored in matches.
+ * @param limit         The scan stops after limit matches.
+ * @param pos           First position to check.
+ * @param count         Number of matches found before pos.
+ * @return r2_uint64    Returns the number of matches.
+ */
+static r2_uint64 scalar_scan(const r2_uc *text, r2_uint64 len, const r2_uc *pat, r2_uint64 m, r2_uint64 *matches, r2_uint64 nmatches, r2_uint64 limit, r2_uint64 pos, r2_uint64 count)
+{
+        const r2_uc *p;
+        while(count < limit && pos + m <= len){
+                p = memchr(&text[pos], pat[0], len - m + 1 - pos);
+                if(p == NULL)
+                        break;
+
+                pos = p - text;
+                if(text[pos + m - 1] == pat[m - 1] && memcmp(&text[pos], pat, m) == 0){
+                        if(count < nmatches)
+                                matches[count] = pos;
+                        ++count;
+                }
+                ++pos;
+        }
+        return count;
+}
+
+#if defined(R2_STRING_SIMD)
+/**
+ * @brief               Finds the matches of a pattern 32 positions at a time. Every iteration compares the first byte 
+ *                      of the pattern with text[i...i+31] and the last byte with text[i+m-1...i+m+30], the 
+ *                      positions where both match are verified with memcmp.
+ *
+ * @param text          Text.
+ * @param len           Length of text.
+ * @param pat           Pattern.
+ * @param m             Length of pattern.
+ * @param matches       Locations of the matches.
+ * @param nmatches      Maximum number of locations stored in matches.
+ * @param limit         The scan stops after limit matches.
+ * @param next          First position that wasn't checked.
+ * @return r2_uint64    Returns the number of matches.
+ */
+R2_AVX2 static r2_uint64 avx2_scan(const r2_uc *text, r2_uint64 len, const r2_uc *pat, r2_uint64 m, r2_uint64 *matches, r2_uint64 nmatches, r2_uint64 limit, r2_uint64 *next)
+{
+        const __m256i first = _mm256_set1_epi8((char)pat[0]);
+        const __m256i last  = _mm256_set1_epi8((char)pat[m - 1]);
+        r2_uint64 count = 0, i, j;
+        unsigned int mask;
+        for(i = 0; i + m + 31 <= len; i += 32){
+                __m256i a = _mm256_loadu_si256((const __m256i *)&text[i]);
+                __m256i b = _mm256_loadu_si256((const __m256i *)&text[i + m - 1]);
+                mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+                while(mask != 0){
+                        j = i + ctz(mask);
+                        mask &= mask - 1;
+                        if(m > 2 && memcmp(&text[j + 1], &pat[1], m - 2) != 0)
+                                continue;
+
+                        if(count < nmatches)
+                                matches[count] = j;
+                        if(++count == limit){
+                                *next = len;
+                                return count;
+                        }
+                }
+        }
+        *next = i;
+        return count;
+}
+
+/**
+ * @brief               Finds the matches of a pattern 16 positions at a time, like avx2_scan.
+ *
+ * @param text          Text.
+ * @param len           Length of text.
+ * @param pat           Pattern.
+ * @param m             Length of pattern.
+ * @param matches       Locations of the matches.
+ * @param nmatches      Maximum number of locations stored in matches.
+ * @param limit         The scan stops after limit matches.
+ * @param next          First position that wasn't checked.
+ * @return r2_uint64    Returns the number of matches.
+ */
+R2_SSE2 static r2_uint64 sse2_scan(const r2_uc *text, r2_uint64 len, const r2_uc *pat, r2_uint64 m, r2_uint64 *matches, r2_uint64 nmatches, r2_uint64 limit, r2_uint64 *next)
+{
+        const __m128i first = _mm_set1_epi8((char)pat[0]);
+        const __m128i last  = _mm_set1_epi8((char)pat[m - 1]);
+        r2_uint64 count = 0, i, j;
+        unsigned int mask;
+        for(i = 0; i + m + 15 <= len; i += 16){
+                __m128i a = _mm_loadu_si128((const __m128i *)&text[i]);
+                __m128i b = _mm_loadu_si128((const __m128i *)&text[i + m - 1]);
+                mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+                while(mask != 0){
+                        j = i + ctz(mask);
+                        mask &= mask - 1;
+                        if(m > 2 && memcmp(&text[j + 1], &pat[1], m - 2) != 0)
+                                continue;
+
+                        if(count < nmatches)
+                                matches[count] = j;
+                        if(++count == limit){
+                                *next = len;
+                                return count;
+                        }
+                }
+        }
+        *next = i;
+        return count;
+}
+
+/**
+ * @brief               Returns the number of trailing zero bits of a non zero mask.
+ */
+static unsigned int ctz(unsigned int x)
+{
+        #if defined(_MSC_VER)
+                unsigned long i;
+                _BitScanForward(&i, x);
+                return i;
+        #else
+                return __builtin_ctz(x);
+        #endif
+}
+#endif
\ No newline at end of file
@@ -6,4 +6,90 @@ r2_int64 r2_rabin_karp(const r2_c*, const r2_c*);
 r2_int64 r2_naive_dfa(const r2_c *, const r2_c *); 
 r2_int64 r2_kmp(const r2_c *, const r2_c *);
 r2_int64 r2_bmh(const r2_c*, const r2_c*);
+
+#define R2_PATTERN_KMP 0
+#define R2_PATTERN_BMH 1
+#define R2_PATTERN_DFA 2
+#define R2_PATTERN_SIMD 3
+#define R2_PATTERN_AUTO 4
+
+/**
+ * @brief A compiled pattern keeps the tables of one search algorithm so that searching many texts for the same pattern 
+ * doesn't preprocess the pattern again. Texts and patterns are length delimited and may contain any byte.
+ */
+struct r2_pattern{
+        r2_uc *pat;/*copy of the pattern*/
+        r2_uint64 len;/*length of the pattern*/
+        r2_uint16 algo;/*algorithm used by searches*/
+        r2_uint64 *ft;/*KMP failure table*/
+        r2_uint64 shift[256];/*BMH shift of every byte*/
+        r2_uint64 *dfa;/*DFA transitions, 256 per state*/
+};
+
+struct r2_pattern* r2_pattern_compile(const r2_c *, r2_uint64, r2_uint16);
+struct r2_pattern* r2_destroy_pattern(struct r2_pattern *);
+r2_int64 r2_pattern_search(const struct r2_pattern *, const r2_c *, r2_uint64);
+r2_uint64 r2_pattern_find_all(const struct r2_pattern *, const r2_c *, r2_uint64, r2_uint64 *, r2_uint64);
+
+/**
+ * @brief r2_search picks the search algorithm from the length of the pattern and the byte frequencies of the text,
+ * so callers don't have to know which matcher is fastest. r2_search_plan returns the algorithm it would pick.
+ */
+r2_uint16 r2_search_plan(const r2_c *, r2_uint64, const r2_c *, r2_uint64);
+r2_int64 r2_search(const r2_c *, r2_uint64, const r2_c *, r2_uint64);
+
+/**
+ * @brief A matcher searches a stream for a compiled KMP or DFA pattern one chunk at a time. The state of the automaton
+ * is kept between chunks so matches that span chunks are found without copying the chunks, and every match is reported
+ * at its offset from the start of the stream. Many matchers can share one compiled pattern.
+ */
+struct r2_matcher{
+        const struct r2_pattern *cp;/*compiled pattern, not owned by the matcher*/
+        r2_uint64 state;/*state of the automaton, the number of pattern bytes matched*/
+        r2_uint64 offset;/*number of bytes fed so far*/
+};
+
+struct r2_matcher* r2_create_matcher(const struct r2_pattern *);
+struct r2_matcher* r2_destroy_matcher(struct r2_matcher *);
+void r2_matcher_reset(struct r2_matcher *);
+r2_uint64 r2_matcher_feed(struct r2_matcher *, const r2_c *, r2_uint64, r2_act, void *);
+
+r2_int64 r2_bitap(const r2_c *, r2_uint64, const r2_c *, r2_uint64, r2_uint64);
+r2_int64 r2_edit_distance(const r2_c *, r2_uint64, const r2_c *, r2_uint64);
+r2_int64 r2_approx_find_all(const r2_c *, r2_uint64, const r2_c *, r2_uint64, r2_uint64, r2_uint64 *, r2_uint64);
+
+/**
+ * @brief A pattern set finds many patterns of the same length in one pass over a text (multi-pattern Rabin-Karp).
+ * The hashes of the patterns are kept in a flat open addressing table and the hash of the window is updated for every byte. 
+ */
+struct r2_patternset{
+        r2_uc *pats;/*copies of the patterns stored back to back*/
+        r2_uint64 npats;/*number of patterns*/
+        r2_uint64 len;/*length of every pattern*/
+        r2_uint64 pow;/*BASE^(len-1), weight of the first byte of the window*/
+        r2_uint64 shift;/*64 - log2 of the number of slots*/
+        r2_uint64 *hashes;/*hash of the pattern in every slot*/
+        r2_uint64 *ids;/*index of the pattern in every slot plus one, 0 when the slot is empty*/
+};
+
+struct r2_setmatch{
+        r2_uint64 pos;/*position of the match in the text*/
+        r2_uint64 id;/*index of the pattern*/
+};
+
+struct r2_patternset* r2_create_patternset(const r2_c **, r2_uint64, r2_uint64);
+struct r2_patternset* r2_destroy_patternset(struct r2_patternset *);
+r2_uint64 r2_patternset_search(const struct r2_patternset *, const r2_c *, r2_uint64, r2_act, void *);
+
+#define R2_STRING_SCALAR 0
+#define R2_STRING_SSE2   1
+#define R2_STRING_AVX2   2
+/**
+ * @brief The SIMD substring search compares the first and the last byte of the pattern with 32 (AVX2) or 16 (SSE2)
+ * positions of the text at once and only compares the rest of the pattern at positions where both bytes match. 
+ * Without SSE2 the first byte is found with memchr. The instruction set is picked at runtime, r2_string_set_simd can limit it.
+ */
+r2_int64 r2_simd_substring(const r2_c *, r2_uint64, const r2_c *, r2_uint64);
+void r2_string_set_simd(r2_uint16);
+r2_uint16 r2_string_simd();
 #endif
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include "r2_suffixarray.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#define ALPHA_SIZE 256
+#define TGET(t, i) (((t)[(i)/8] >> ((i) % 8)) & 1)
+#define TSET(t, i, b) ((b)? ((t)[(i)/8] |= (1 << ((i) % 8))) : ((t)[(i)/8] &= ~(1 << ((i) % 8))))
+#define LMS(t, i) ((i) > 0 && TGET(t, i) && !TGET(t, (i) - 1))
+/*The text is read as if every byte was one larger and a 0 sentinel followed it, recursive levels store their own sentinel.*/
+#define CHR(i) (cs == 1? ((i) == n - 1? 0 : (r2_int64)((const r2_uc *)s)[i] + 1) : ((const r2_int64 *)s)[i])
+static r2_uint16 sais(const void *, r2_int64 *, r2_int64, r2_int64, r2_uint64);
+static void sais_buckets(const void *, r2_int64 *, r2_int64, r2_int64, r2_uint64, r2_uint16);
+static void sais_induce(const void *, const r2_uc *, r2_int64 *, r2_int64 *, r2_int64, r2_int64, r2_uint64);
+static r2_uint64 sa_bound(const struct r2_suffixarray *, const r2_uc *, r2_uint64, r2_uint16);
+
+/**
+ * @brief                       Builds the suffix array and the LCP array of a text.
+ *
+ *                              The suffix array is built in O(n) time with SA-IS (Nong, Zhang and Chan). Suffixes are
+ *                              either S-type, smaller than the next suffix, or L-type. An S-type suffix that follows an
+ *                              L-type suffix is a leftmost S-type (LMS) suffix. Once the LMS suffixes are sorted every
+ *                              other suffix is placed by induced sorting: a left to right pass places the L-type suffixes and
+ *                              a right to left pass places the S-type suffixes. The LMS suffixes are sorted by naming the
+ *                              LMS substrings, which are sorted by the same induced sorting, and recursing on the string of
+ *                              names when two substrings get the same name. That string is at most half as long as the text.
+ *
+ *                              The LCP array is built in O(n) time with Kasai's algorithm, which visits the suffixes in
+ *                              text order so the common prefix of a suffix is at least one shorter than the previous one.
+ *
+ *                              The text isn't copied, it has to outlive the suffix array. It may contain any byte.
+ *
+ * @param text                  Text.
+ * @param len                   Length of text.
+ * @return struct r2_suffixarray*       Returns the suffix array, else NULL.
+ */
+struct r2_suffixarray* r2_create_suffixarray(const r2_c *text, r2_uint64 len)
+{
+        assert(text != NULL || len == 0);
+        struct r2_suffixarray *sa = calloc(1, sizeof(struct r2_suffixarray));
+        r2_int64 *buf   = NULL;
+        r2_uint64 *rank = NULL;
+        r2_uint64 h = 0, j;
+        if(sa == NULL)
+                return NULL;
+
+        sa->text = (const r2_uc *)text;
+        sa->n    = len;
+        buf = malloc(sizeof(r2_int64) * (len + 1));/*room for the sentinel suffix*/
+        sa->lcp = malloc(sizeof(r2_uint64) * (len + 1));
+        rank    = malloc(sizeof(r2_uint64) * (len + 1));
+        if(buf == NULL || sa->lcp == NULL || rank == NULL || sais(text, buf, len + 1, ALPHA_SIZE, 1) == FALSE){
+                free(buf);
+                free(rank);
+                return r2_destroy_suffixarray(sa);
+        }
+
+        /*The sentinel suffix comes first, it isn't part of the suffix array.*/
+        memmove(buf, &buf[1], sizeof(r2_int64) * len);
+        sa->sa = (r2_uint64 *)buf;
+
+        for(r2_uint64 i = 0; i < len; ++i)
+                rank[sa->sa[i]] = i;
+        for(r2_uint64 i = 0; i < len; ++i){
+                if(rank[i] == 0){
+                        sa->lcp[0] = h = 0;
+                        continue;
+                }
+
+                j = sa->sa[rank[i] - 1];
+                while(i + h < len && j + h < len && sa->text[i + h] == sa->text[j + h])
+                        ++h;
+                sa->lcp[rank[i]] = h;
+                if(h > 0)
+                        --h;
+        }
+        free(rank);
+        return sa;
+}
+
+/**
+ * @brief                       Destroys a suffix array. The text isn't freed.
+ *
+ * @param sa                    Suffix array.
+ * @return struct r2_suffixarray*       Returns NULL.
+ */
+struct r2_suffixarray* r2_destroy_suffixarray(struct r2_suffixarray *sa)
+{
+        if(sa != NULL){
+                free(sa->sa);
+                free(sa->lcp);
+                free(sa);
+        }
+        return NULL;
+}
+
+/**
+ * @brief                       Finds the range of the suffix array whose suffixes start with a pattern.
+ *                              The binary search remembers how many bytes of the pattern match the suffixes at
+ *                              both ends of the range, every suffix in between shares the smaller of the two
+ *                              so those bytes aren't compared again.
+ *
+ * @param sa                    Suffix array.
+ * @param pat                   Pattern, it doesn't have to be null terminated.
+ * @param len                   Length of pattern.
+ * @param first                 Position in the suffix array of the first suffix that starts with the pattern, can be NULL.
+ * @return r2_uint64            Returns the number of occurrences of the pattern, they start at sa->sa[*first...*first + count - 1].
+ */
+r2_uint64 r2_suffixarray_search(const struct r2_suffixarray *sa, const r2_c *pat, r2_uint64 len, r2_uint64 *first)
+{
+        assert(sa != NULL && (pat != NULL || len == 0));
+        r2_uint64 lo = sa_bound(sa, (const r2_uc *)pat, len, FALSE);
+        r2_uint64 hi = sa_bound(sa, (const r2_uc *)pat, len, TRUE);
+        if(first != NULL)
+                *first = lo;
+        return hi - lo;
+}
+
+/**
+ * @brief                       Finds every occurrence of a pattern, occurrences may overlap.
+ *
+ * @param sa                    Suffix array.
+ * @param pat                   Pattern, it doesn't have to be null terminated.
+ * @param len                   Length of pattern.
+ * @param matches               Locations of the occurrences in the lexicographic order of their suffixes, can be NULL.
+ * @param nmatches              Maximum number of locations stored in matches.
+ * @return r2_uint64            Returns the number of occurrences, which can be larger than nmatches.
+ */
+r2_uint64 r2_suffixarray_find_all(const struct r2_suffixarray *sa, const r2_c *pat, r2_uint64 len, r2_uint64 *matches, r2_uint64 nmatches)
+{
+        r2_uint64 first = 0;
+        r2_uint64 count = r2_suffixarray_search(sa, pat, len, &first);
+        if(matches != NULL)
+                memcpy(matches, &sa->sa[first], sizeof(r2_uint64) * (count < nmatches? count : nmatches));
+        return count;
+}
+
+/**
+ * @brief                       Finds the longest substring that occurs at least twice, it's the largest entry of the LCP array.
+ *
+ * @param sa                    Suffix array.
+ * @param pos                   Location of one occurrence of the substring, can be NULL.
+ * @return r2_uint64            Returns the length of the substring, 0 when no byte repeats.
+ */
+r2_uint64 r2_suffixarray_longest_repeat(const struct r2_suffixarray *sa, r2_uint64 *pos)
+{
+        r2_uint64 best = 0;
+        for(r2_uint64 i = 1; i < sa->n; ++i){
+                if(sa->lcp[i] > sa->lcp[best])
+                        best = i;
+        }
+        if(pos != NULL)
+                *pos = sa->n > 0? sa->sa[best] : 0;
+        return sa->n > 0? sa->lcp[best] : 0;
+}
+
+/**
+ * @brief                       Builds the suffix array of a string that ends with a unique smallest sentinel.
+ *
+ * @param s                     String, bytes when cs is 1 and 64 bit names otherwise.
+ * @param SA                    Suffix array, n entries.
+ * @param n                     Length of string including the sentinel.
+ * @param K                     Largest character.
+ * @param cs                    Size of a character.
+ * @return r2_uint16            Returns TRUE whenever the suffix array was built, else FALSE.
+ */
+static r2_uint16 sais(const void *s, r2_int64 *SA, r2_int64 n, r2_int64 K, r2_uint64 cs)
+{
+        r2_uc *t      = calloc(n/8 + 1, sizeof(r2_uc));/*TRUE for S-type suffixes*/
+        r2_int64 *bkt = malloc(sizeof(r2_int64) * (K + 1));
+        r2_int64 i, j, d, n1, name, prev, pos;
+        r2_int64 *s1;
+        r2_uint16 diff, ok = TRUE;
+        if(t == NULL || bkt == NULL){
+                free(t);
+                free(bkt);
+                return FALSE;
+        }
+
+        /*Classifying suffixes, the sentinel is S-type and the suffix before it is L-type.*/
+        TSET(t, n - 1, 1);
+        for(i = n - 2; i >= 0; --i)
+                TSET(t, i, CHR(i) < CHR(i + 1) || (CHR(i) == CHR(i + 1) && TGET(t, i + 1)));
+
+        /*Sorting the LMS substrings, LMS suffixes are placed at the ends of their buckets.*/
+        sais_buckets(s, bkt, n, K, cs, TRUE);
+        for(i = 0; i < n; ++i)
+                SA[i] = -1;
+        for(i = 1; i < n; ++i)
+                if(LMS(t, i))
+                        SA[--bkt[CHR(i)]] = i;
+        sais_induce(s, t, SA, bkt, n, K, cs);
+
+        /*Naming the sorted LMS substrings, two substrings get the same name when they're equal.*/
+        n1 = 0;
+        for(i = 0; i < n; ++i)
+                if(LMS(t, SA[i]))
+                        SA[n1++] = SA[i];
+        for(i = n1; i < n; ++i)
+                SA[i] = -1;
+
+        name = 0;
+        prev = -1;
+        for(i = 0; i < n1; ++i){
+                pos  = SA[i];
+                diff = FALSE;
+                for(d = 0; d < n; ++d){
+                        if(prev == -1 || CHR(pos + d) != CHR(prev + d) || TGET(t, pos + d) != TGET(t, prev + d)){
+                                diff = TRUE;
+                                break;
+                        }
+                        if(d > 0 && (LMS(t, pos + d) || LMS(t, prev + d)))
+                                break;
+                }
+
+                if(diff == TRUE){
+                        ++name;
+                        prev = pos;
+                }
+                /*LMS positions are at least two apart so pos/2 is unique.*/
+                SA[n1 + pos/2] = name - 1;
+        }
+        for(i = n - 1, j = n - 1; i >= n1; --i)
+                if(SA[i] >= 0)
+                        SA[j--] = SA[i];
+
+        /*Sorting the LMS suffixes, the string of names is kept at the end of SA.*/
+        s1 = &SA[n - n1];
+        if(name < n1)
+                ok = sais(s1, SA, n1, name - 1, sizeof(r2_int64));
+        else
+                for(i = 0; i < n1; ++i)
+                        SA[s1[i]] = i;
+
+        if(ok == TRUE){
+                /*Placing the sorted LMS suffixes at the ends of their buckets and inducing the rest.*/
+                for(i = 1, j = 0; i < n; ++i)
+                        if(LMS(t, i))
+                                s1[j++] = i;
+                for(i = 0; i < n1; ++i)
+                        SA[i] = s1[SA[i]];
+                for(i = n1; i < n; ++i)
+                        SA[i] = -1;
+
+                sais_buckets(s, bkt, n, K, cs, TRUE);
+                for(i = n1 - 1; i >= 0; --i){
+                        j = SA[i];
+                        SA[i] = -1;
+                        SA[--bkt[CHR(j)]] = j;
+                }
+                sais_induce(s, t, SA, bkt, n, K, cs);
+        }
+
+        free(t);
+        free(bkt);
+        return ok;
+}
+
+/**
+ * @brief                       Computes the start or the end of the bucket of every character.
+ *
+ * @param s                     String.
+ * @param bkt                   Buckets.
+ * @param n                     Length of string.
+ * @param K                     Largest character.
+ * @param cs                    Size of a character.
+ * @param end                   TRUE for the ends of the buckets, FALSE for the starts.
+ */
+static void sais_buckets(const void *s, r2_int64 *bkt, r2_int64 n, r2_int64 K, r2_uint64 cs, r2_uint16 end)
+{
+        r2_int64 sum = 0;
+        for(r2_int64 i = 0; i <= K; ++i)
+                bkt[i] = 0;
+        for(r2_int64 i = 0; i < n; ++i)
+                ++bkt[CHR(i)];
+        for(r2_int64 i = 0; i <= K; ++i){
+                sum += bkt[i];
+                bkt[i] = end == TRUE? sum : sum - bkt[i];
+        }
+}
+
+/**
+ * @brief                       Induces the order of the L-type suffixes from the LMS suffixes in SA and then
+ *                              the order of the S-type suffixes from the L-type suffixes.
+ *
+ * @param s                     String.
+ * @param t                     Types of the suffixes.
+ * @param SA                    Suffix array.
+ * @param bkt                   Buckets.
+ * @param n                     Length of string.
+ * @param K                     Largest character.
+ * @param cs                    Size of a character.
+ */
+static void sais_induce(const void *s, const r2_uc *t, r2_int64 *SA, r2_int64 *bkt, r2_int64 n, r2_int64 K, r2_uint64 cs)
+{
+        r2_int64 j;
+        sais_buckets(s, bkt, n, K, cs, FALSE);
+        for(r2_int64 i = 0; i < n; ++i){
+                j = SA[i] - 1;
+                if(j >= 0 && !TGET(t, j))
+                        SA[bkt[CHR(j)]++] = j;
+        }
+
+        sais_buckets(s, bkt, n, K, cs, TRUE);
+        for(r2_int64 i = n - 1; i >= 0; --i){
+                j = SA[i] - 1;
+                if(j >= 0 && TGET(t, j))
+                        SA[--bkt[CHR(j)]] = j;
+        }
+}
+
+/**
+ * @brief                       Finds the first suffix that's greater than or equal to the pattern, or greater than
+ *                              the pattern when upper is TRUE. Only the first len bytes of a suffix are compared.
+ *
+ * @param sa                    Suffix array.
+ * @param pat                   Pattern.
+ * @param len                   Length of pattern.
+ * @param upper                 TRUE to skip the suffixes that start with the pattern.
+ * @return r2_uint64            Returns the position of the suffix in the suffix array.
+ */
+static r2_uint64 sa_bound(const struct r2_suffixarray *sa, const r2_uc *pat, r2_uint64 len, r2_uint16 upper)
+{
+        r2_uint64 lo = 0, hi = sa->n, mid, p, k;
+        r2_uint64 llcp = 0, rlcp = 0;/*bytes of the pattern matched by the suffixes before lo and at hi*/
+        r2_int16 c;
+        while(lo < hi){
+                mid = lo + (hi - lo)/2;
+                p = sa->sa[mid];
+                k = llcp < rlcp? llcp : rlcp;
+                while(k < len && p + k < sa->n && sa->text[p + k] == pat[k])
+                        ++k;
+
+                if(k == len)
+                        c = 0;
+                else if(p + k == sa->n)
+                        c = -1;
+                else
+                        c = sa->text[p + k] < pat[k]? -1 : 1;
+
+                if(c < 0 || (c == 0 && upper == TRUE)){
+                        lo   = mid + 1;
+                        llcp = k;
+                }else{
+                        hi   = mid;
+                        rlcp = k;
+                }
+        }
+        return lo;
+}
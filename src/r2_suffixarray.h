@@ -0,0 +1,23 @@
+#ifndef R2_SUFFIXARRAY_H_
+#define R2_SUFFIXARRAY_H_
+#include "r2_types.h"
+
+/**
+ * @brief A suffix array lists the suffixes of a text in lexicographic order. The occurrences of a pattern are the
+ * suffixes that start with the pattern, they're next to each other in the suffix array so after building the suffix
+ * array once every query is a binary search that takes O(m log n) time.
+ *
+ */
+struct r2_suffixarray{
+        const r2_uc *text;/*indexed text, not owned by the suffix array*/
+        r2_uint64 n;/*length of text*/
+        r2_uint64 *sa;/*starting positions of the suffixes in lexicographic order*/
+        r2_uint64 *lcp;/*lcp[i] is the length of the longest common prefix of the suffixes at sa[i-1] and sa[i], lcp[0] = 0*/
+};
+
+struct r2_suffixarray* r2_create_suffixarray(const r2_c *, r2_uint64);
+struct r2_suffixarray* r2_destroy_suffixarray(struct r2_suffixarray *);
+r2_uint64 r2_suffixarray_search(const struct r2_suffixarray *, const r2_c *, r2_uint64, r2_uint64 *);
+r2_uint64 r2_suffixarray_find_all(const struct r2_suffixarray *, const r2_c *, r2_uint64, r2_uint64 *, r2_uint64);
+r2_uint64 r2_suffixarray_longest_repeat(const struct r2_suffixarray *, r2_uint64 *);
+#endif
\ No newline at end of file
@@ -93,7 +93,7 @@ r2_uint16 r2_trie_insert(struct r2_trie *trie, r2_uc *key, r2_uint64 len, void *
         r2_int64 pos = 0;
         
         /*Find the position in the tree to insert*/
-        for(;root->keys[key[pos]] != NULL && pos < len; ++pos)
+        for(;pos < len && root->keys[key[pos]] != NULL; ++pos)
                 root = root->keys[key[pos]];
 
         /*Remember this position in the trie in case we have to back up.*/
@@ -228,6 +228,151 @@ char* r2_trie_longest_prefix(struct r2_trie *trie, r2_uc *key, r2_uint64 len)
         return prefix; 
 }
 
+/**
+ * @brief                       Builds an Aho-Corasick automaton of the keys in a trie.
+ * 
+ *                              The states are the nodes of the trie numbered in breadth first order. The failure link of
+ *                              a state points to the state of its longest proper suffix that is also a prefix of a key, 
+ *                              and its output link to the next state on the failure chain where a key ends. Every missing
+ *                              transition is replaced by the transition of the failure state, so the automaton is compiled 
+ *                              into a dense table with one row per state and scanning a text takes one lookup per byte.
+ *                              Bytes that don't occur in any key share a single column of the table.
+ *                              
+ *                              The automaton keeps the data of every key but doesn't own it, the trie can be changed or 
+ *                              destroyed afterwards as long as the data stays valid.
+ * 
+ * @param trie                  Trie.
+ * @return struct r2_ac*        Returns the automaton, else NULL.
+ */
+struct r2_ac* r2_create_ac(const struct r2_trie *trie)
+{
+        assert(trie != NULL);
+        struct r2_ac *ac = calloc(1, sizeof(struct r2_ac));
+        struct r2_trienode **nodes = NULL;/*node of every state in breadth first order*/
+        r2_uint32 *fail = NULL;
+        r2_uint64 n = 1, s, u, f;
+        r2_uint16 used[ALPHABET] = {0};
+        if(ac == NULL)
+                return NULL;
+
+        /*Counting states and finding the bytes used by keys.*/
+        nodes = malloc(sizeof(struct r2_trienode *));
+        if(nodes == NULL)
+                return r2_destroy_ac(ac);
+        nodes[0] = trie->root;
+        for(s = 0; s < n; ++s){
+                for(r2_uint64 c = 0; c < ALPHABET; ++c){
+                        if(nodes[s]->keys[c] == NULL)
+                                continue;
+                        used[c] = TRUE;
+                        if((n & (n - 1)) == 0){
+                                struct r2_trienode **tmp = realloc(nodes, sizeof(struct r2_trienode *) * 2 * n);
+                                if(tmp == NULL){
+                                        free(nodes);
+                                        return r2_destroy_ac(ac);
+                                }
+                                nodes = tmp;
+                        }
+                        nodes[n++] = nodes[s]->keys[c];
+                }
+        }
+
+        /*Column 0 is shared by the bytes that aren't used by any key, it always goes back to the root.*/
+        ac->nclasses = 1;
+        for(r2_uint64 c = 0; c < ALPHABET; ++c)
+                ac->classes[c] = used[c] == TRUE? ac->nclasses++ : 0;
+
+        ac->nstates = n;
+        ac->next  = calloc(n * ac->nclasses, sizeof(r2_uint32));
+        ac->out   = calloc(n, sizeof(r2_uint32));
+        ac->link  = calloc(n, sizeof(r2_uint32));
+        ac->depth = calloc(n, sizeof(r2_uint64));
+        ac->data  = calloc(n, sizeof(void *));
+        fail = calloc(n, sizeof(r2_uint32));
+        if(ac->next == NULL || ac->out == NULL || ac->link == NULL || ac->depth == NULL || ac->data == NULL || fail == NULL){
+                free(nodes);
+                free(fail);
+                return r2_destroy_ac(ac);
+        }
+
+        /*The children of a state were numbered consecutively when it was visited, in the same order.*/
+        u = 1;
+        for(s = 0; s < n; ++s){
+                for(r2_uint64 c = 0; c < ALPHABET; ++c){
+                        if(nodes[s]->keys[c] == NULL){
+                                if(s != 0 && used[c] == TRUE)
+                                        ac->next[s*ac->nclasses + ac->classes[c]] = ac->next[fail[s]*ac->nclasses + ac->classes[c]];
+                                continue;
+                        }
+
+                        f = s == 0? 0 : ac->next[fail[s]*ac->nclasses + ac->classes[c]];
+                        fail[u] = f;
+                        ac->depth[u] = ac->depth[s] + 1;
+                        ac->data[u]  = nodes[u]->data;
+                        ac->link[u]  = ac->out[f];
+                        ac->out[u]   = nodes[u]->data != NULL? u : ac->out[f];
+                        ac->next[s*ac->nclasses + ac->classes[c]] = u++;
+                }
+        }
+
+        free(nodes);
+        free(fail);
+        return ac;
+}
+
+/**
+ * @brief                       Destroys an Aho-Corasick automaton. The data of the keys isn't freed.
+ * 
+ * @param ac                    Automaton.
+ * @return struct r2_ac*        Returns NULL.
+ */
+struct r2_ac* r2_destroy_ac(struct r2_ac *ac)
+{
+        if(ac != NULL){
+                free(ac->next);
+                free(ac->out);
+                free(ac->link);
+                free(ac->depth);
+                free(ac->data);
+                free(ac);
+        }
+        return NULL;
+}
+
+/**
+ * @brief                       Finds every occurrence of every key in a text in a single pass. For every match
+ *                              action is called with a struct r2_acmatch holding the position and length of the 
+ *                              match and the data of the key. Matches are reported in order of their last byte, 
+ *                              longest first when several keys end at the same byte.
+ * 
+ * @param ac                    Automaton.
+ * @param text                  Text.
+ * @param len                   Length of text.
+ * @param action                A callback function called for every match, can be NULL.
+ * @param arg                   Argument passed to action.
+ * @return r2_uint64            Returns the number of matches.
+ */
+r2_uint64 r2_ac_search(const struct r2_ac *ac, const r2_uc *text, r2_uint64 len, r2_act action, void *arg)
+{
+        assert(ac != NULL && (text != NULL || len == 0));
+        struct r2_acmatch match;
+        r2_uint64 count = 0;
+        r2_uint32 s = 0;
+        for(r2_uint64 i = 0; i < len; ++i){
+                s = ac->next[s*ac->nclasses + ac->classes[text[i]]];
+                for(r2_uint32 t = ac->out[s]; t != 0; t = ac->link[t]){
+                        ++count;
+                        if(action != NULL){
+                                match.pos  = i + 1 - ac->depth[t];
+                                match.len  = ac->depth[t];
+                                match.data = ac->data[t];
+                                action(&match, arg);
+                        }
+                }
+        }
+        return count;
+}
+
 static struct r2_trienode* r2_create_trienode()
 {
         struct r2_trienode *node = calloc(1, sizeof(struct r2_trienode));
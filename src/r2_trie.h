@@ -17,10 +17,30 @@ struct r2_trie{
         r2_fd fd;/*a callback function to free data*/
 }; 
 
+struct r2_ac{
+        r2_uint64 nstates;/*number of states, state 0 is the root*/
+        r2_uint64 nclasses;/*number of columns in the transition table*/
+        r2_uint16 classes[ALPHABET];/*column of every byte*/
+        r2_uint32 *next;/*transition table, nclasses entries per state*/
+        r2_uint32 *out;/*first state on the failure chain where a key ends, 0 if none*/
+        r2_uint32 *link;/*next state where a key ends after out*/
+        r2_uint64 *depth;/*length of the string spelled by a state*/
+        void **data;/*data of the key ending at a state*/
+};
+
+struct r2_acmatch{
+        r2_uint64 pos;/*position of the match in the text*/
+        r2_uint64 len;/*length of the key*/
+        void *data;/*data of the key*/
+};
+
 struct r2_trie* r2_create_trie(r2_fk, r2_fd); 
 struct r2_trie* r2_destroy_trie(const struct r2_trie *);
 r2_uint16 r2_trie_insert(struct r2_trie *, r2_uc*, r2_uint64, void *);
 r2_uint16 r2_trie_delete(struct r2_trie *, r2_uc *, r2_uint64);
 void* r2_trie_search(struct r2_trie *, r2_uc *, r2_uint64);
 char* r2_trie_longest_prefix(struct r2_trie *, r2_uc *, r2_uint64);
+struct r2_ac* r2_create_ac(const struct r2_trie *);
+struct r2_ac* r2_destroy_ac(struct r2_ac *);
+r2_uint64 r2_ac_search(const struct r2_ac *, const r2_uc *, r2_uint64, r2_act, void *);
 #endif
\ No newline at end of file
@@ -30,4 +30,10 @@ typedef void (*r2_fk)(void *);
 /*A callback function used to perform an user defined action on value*/
 typedef void (*r2_act)(void *, void *); 
 
+/*A callback function used to extract an unsigned key that preserves the order of a value.*/
+typedef r2_uint64 (*r2_key)(const void *);
+
+/*A callback function used to read the next value of a sequence into its second argument, returns FALSE when the sequence has ended.*/
+typedef r2_uint16 (*r2_next)(void *, void *);
+
 #endif
\ No newline at end of file
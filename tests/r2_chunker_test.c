@@ -0,0 +1,165 @@
+#include "..\src\r2_chunker.h"
+#include "r2_chunker_test.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#define MAX_CHUNKS 4096
+
+/*Chunks reported by a chunker.*/
+struct chunk_result{
+        r2_uint64 n;
+        struct r2_chunk chunks[MAX_CHUNKS];
+};
+
+static void chunk_collect(void *chunk, void *arg)
+{
+        struct chunk_result *res = arg;
+        assert(res->n < MAX_CHUNKS);
+        res->chunks[res->n++] = *(struct r2_chunk *)chunk;
+}
+
+/**
+ * @brief Chunks a whole buffer at once.
+ */
+static r2_uint64 chunk_all(struct r2_chunker *ck, const r2_c *buf, r2_uint64 len, struct chunk_result *res)
+{
+        res->n = 0;
+        r2_uint64 count = r2_chunker_feed(ck, buf, len, chunk_collect, res);
+        return count + r2_chunker_finish(ck, chunk_collect, res);
+}
+
+/**
+ * @brief Test that chunks cover the stream and respect the minimum and maximum lengths.
+ */
+static void test_r2_create_chunker()
+{
+        static struct chunk_result res;
+        static char buf[1 << 18];
+        assert(r2_create_chunker(64, 4, 128) == NULL);
+        assert(r2_create_chunker(128, 64, 256) == NULL);
+        assert(r2_create_chunker(64, 512, 256) == NULL);
+
+        /*A huge avg is capped so the masks are never shifted by 64 bits.*/
+        struct r2_chunker *ck = r2_create_chunker(8, (r2_uint64)1 << 63, (r2_uint64)-1);
+        assert(ck != NULL && ck->mask_s == ~(r2_uint64)1 && ck->mask_l == ~((r2_uint64)-1 >> 59));
+        ck = r2_destroy_chunker(ck);
+
+        ck = r2_create_chunker(256, 1024, 4096);
+        assert(ck != NULL && ck->pos == 0 && ck->offset == 0);
+        assert(chunk_all(ck, NULL, 0, &res) == 0 && res.n == 0);
+        assert(chunk_all(ck, "abc", 3, &res) == 1);
+        assert(res.chunks[0].offset == 0 && res.chunks[0].len == 3);
+
+        for(r2_uint64 i = 0; i < sizeof(buf); ++i)
+                buf[i] = (char)rand();
+        assert(chunk_all(ck, buf, sizeof(buf), &res) == res.n);
+        r2_uint64 offset = 0;
+        for(r2_uint64 i = 0; i < res.n; ++i){
+                assert(res.chunks[i].offset == offset);
+                assert(res.chunks[i].len <= 4096);
+                assert(res.chunks[i].len >= 256 || i == res.n - 1);
+                offset += res.chunks[i].len;
+        }
+        assert(offset == sizeof(buf));
+        /*Normalized chunking keeps the average close to avg on random data.*/
+        assert(res.n > sizeof(buf)/2048 && res.n < sizeof(buf)/512);
+
+        /*Identical chunks get identical fingerprints.*/
+        memcpy(&buf[sizeof(buf)/2], buf, sizeof(buf)/2);
+        chunk_all(ck, buf, sizeof(buf), &res);
+        r2_uint64 same = 0;
+        for(r2_uint64 i = 0; i < res.n; ++i)
+                for(r2_uint64 j = i + 1; j < res.n; ++j)
+                        if(res.chunks[i].fingerprint == res.chunks[j].fingerprint){
+                                assert(res.chunks[i].len == res.chunks[j].len);
+                                assert(memcmp(&buf[res.chunks[i].offset], &buf[res.chunks[j].offset], res.chunks[i].len) == 0);
+                                ++same;
+                        }
+        assert(same > res.n/2 - 4);
+        ck = r2_destroy_chunker(ck);
+        assert(ck == NULL);
+
+        /*A zero run has no boundary so every chunk is cut at max.*/
+        ck = r2_create_chunker(8, 8, 8);
+        memset(buf, 0, 100);
+        assert(chunk_all(ck, buf, 100, &res) == 13);
+        for(r2_uint64 i = 0; i < 12; ++i)
+                assert(res.chunks[i].len == 8 && res.chunks[i].fingerprint == res.chunks[0].fingerprint);
+        assert(res.chunks[12].len == 4 && res.chunks[12].fingerprint != res.chunks[0].fingerprint);
+        r2_destroy_chunker(ck);
+}
+
+/**
+ * @brief Test that chunks don't depend on how the stream is split into buffers.
+ */
+static void test_r2_chunker_feed()
+{
+        static struct chunk_result whole, split;
+        static char buf[1 << 16];
+        r2_uint64 i, len, count;
+        for(r2_uint64 test = 0; test < 20; ++test){
+                r2_uint64 min = rand() % 300 + 1;
+                r2_uint64 avg = min + rand() % 700 + 8;
+                r2_uint64 max = avg + rand() % 2000;
+                struct r2_chunker *ck = r2_create_chunker(min, avg, max);
+                assert(ck != NULL);
+                for(i = 0; i < sizeof(buf); ++i)
+                        buf[i] = test % 2 == 0? (char)rand() : (char)(rand() % 3);
+                chunk_all(ck, buf, sizeof(buf), &whole);
+
+                split.n = 0;
+                count = 0;
+                for(i = 0; i < sizeof(buf); i += len){
+                        len = test % 4 == 0? 1 : rand() % 100;
+                        len = len < sizeof(buf) - i? len : sizeof(buf) - i;
+                        count += r2_chunker_feed(ck, &buf[i], len, chunk_collect, &split);
+                }
+                count += r2_chunker_finish(ck, chunk_collect, &split);
+                assert(count == whole.n && split.n == whole.n);
+                for(i = 0; i < whole.n; ++i){
+                        assert(split.chunks[i].offset == whole.chunks[i].offset);
+                        assert(split.chunks[i].len == whole.chunks[i].len);
+                        assert(split.chunks[i].fingerprint == whole.chunks[i].fingerprint);
+                }
+
+                /*Resetting drops the current chunk.*/
+                r2_chunker_feed(ck, buf, 10, NULL, NULL);
+                r2_chunker_reset(ck);
+                chunk_all(ck, buf, sizeof(buf), &split);
+                assert(split.n == whole.n && split.chunks[0].fingerprint == whole.chunks[0].fingerprint);
+                r2_destroy_chunker(ck);
+        }
+}
+
+/**
+ * @brief Test that inserting bytes only changes the chunks around the insertion.
+ */
+static void test_r2_chunker_shift()
+{
+        static struct chunk_result before, after;
+        static char buf[(1 << 18) + 100];
+        struct r2_chunker *ck = r2_create_chunker(512, 2048, 8192);
+        for(r2_uint64 i = 0; i < sizeof(buf); ++i)
+                buf[i] = (char)rand();
+        chunk_all(ck, &buf[100], sizeof(buf) - 100, &before);
+        chunk_all(ck, &buf[63], sizeof(buf) - 63, &after);
+
+        r2_uint64 kept = 0, j = 0;
+        for(r2_uint64 i = 0; i < before.n; ++i){
+                while(j < after.n && after.chunks[j].offset < before.chunks[i].offset + 37)
+                        ++j;
+                if(j < after.n && after.chunks[j].offset == before.chunks[i].offset + 37){
+                        assert(after.chunks[j].fingerprint == before.chunks[i].fingerprint);
+                        ++kept;
+                }
+        }
+        assert(kept + 3 >= before.n);
+        r2_destroy_chunker(ck);
+}
+
+void test_r2_chunker_run()
+{
+        test_r2_create_chunker();
+        test_r2_chunker_feed();
+        test_r2_chunker_shift();
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#ifndef R2_CHUNKER_TEST_H_
+#define R2_CHUNKER_TEST_H_
+static void test_r2_create_chunker();
+static void test_r2_chunker_feed();
+static void test_r2_chunker_shift();
+void test_r2_chunker_run();
+#endif
\ No newline at end of file
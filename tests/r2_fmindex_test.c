@@ -0,0 +1,117 @@
+#include "..\src\r2_fmindex.h"
+#include "r2_fmindex_test.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Test building indexes and counting occurrences.
+ */
+static void test_r2_create_fmindex()
+{
+        struct r2_fmindex *fm = r2_create_fmindex("abracadabra", 11, 4);
+        assert(fm != NULL && fm->n == 11 && fm->sigma == 5 && fm->levels == 3);
+        assert(r2_fmindex_count(fm, "abra", 4) == 2);
+        assert(r2_fmindex_count(fm, "a", 1) == 5);
+        assert(r2_fmindex_count(fm, "cad", 3) == 1);
+        assert(r2_fmindex_count(fm, "abracadabra", 11) == 1);
+        assert(r2_fmindex_count(fm, "abracadabraa", 12) == 0);
+        assert(r2_fmindex_count(fm, "abx", 3) == 0);
+        assert(r2_fmindex_count(fm, "z", 1) == 0);
+        assert(r2_fmindex_count(fm, "", 0) == 11);
+        fm = r2_destroy_fmindex(fm);
+        assert(fm == NULL);
+
+        fm = r2_create_fmindex("", 0, 1);
+        assert(fm != NULL && fm->n == 0);
+        assert(r2_fmindex_count(fm, "a", 1) == 0);
+        r2_destroy_fmindex(fm);
+
+        fm = r2_create_fmindex("aaaa", 4, 1);
+        assert(fm != NULL && fm->sigma == 1);
+        assert(r2_fmindex_count(fm, "aa", 2) == 3);
+        assert(r2_fmindex_count(fm, "aaaaa", 5) == 0);
+        r2_destroy_fmindex(fm);
+}
+
+/**
+ * @brief Test that locate finds every occurrence, for every sampling rate.
+ */
+static void test_r2_fmindex_locate()
+{
+        r2_uc text[3000];
+        r2_uc pat[8];
+        r2_uint64 matches[3000];
+        r2_uint64 n, m, count, expected;
+        r2_uc *seen = NULL;
+        struct r2_fmindex *fm = NULL;
+        for(r2_uint64 test = 0; test < 200; ++test){
+                n = rand() % 3000;
+                m = rand() % 8 + 1;
+                for(r2_uint64 i = 0; i < n; ++i){
+                        if(test % 3 == 2)
+                                text[i] = (r2_uc)rand();
+                        else
+                                text[i] = (r2_uc)(rand() % (test % 5 + 1) + (test % 2 == 0? 'a' : 251));
+                }
+                for(r2_uint64 i = 0; i < m; ++i)
+                        pat[i] = (r2_uc)(rand() % (test % 5 + 1) + (test % 2 == 0? 'a' : 251));
+
+                fm = r2_create_fmindex((const r2_c *)text, n, test % 70 + 1);
+                assert(fm != NULL);
+                count = r2_fmindex_locate(fm, (const r2_c *)pat, m, matches, 3000);
+                assert(count == r2_fmindex_count(fm, (const r2_c *)pat, m));
+                seen = calloc(n + 1, sizeof(r2_uc));
+                assert(seen != NULL);
+                for(r2_uint64 i = 0; i < count; ++i){
+                        assert(matches[i] + m <= n && seen[matches[i]] == FALSE);
+                        seen[matches[i]] = TRUE;
+                }
+
+                expected = 0;
+                for(r2_uint64 i = 0; i + m <= n; ++i)
+                        if(memcmp(&text[i], pat, m) == 0)
+                                ++expected;
+                assert(count == expected);
+                free(seen);
+                r2_destroy_fmindex(fm);
+        }
+}
+
+/**
+ * @brief Test that the text can be rebuilt from the index.
+ */
+static void test_r2_fmindex_extract()
+{
+        const char *str = "mississippi";
+        char out[3000];
+        struct r2_fmindex *fm = r2_create_fmindex(str, 11, 3);
+        assert(r2_fmindex_extract(fm, 0, 11, out) == TRUE && memcmp(out, str, 11) == 0);
+        assert(r2_fmindex_extract(fm, 4, 3, out) == TRUE && memcmp(out, "iss", 3) == 0);
+        assert(r2_fmindex_extract(fm, 11, 0, out) == TRUE);
+        assert(r2_fmindex_extract(fm, 10, 2, out) == FALSE);
+        assert(r2_fmindex_extract(fm, 12, 0, out) == FALSE);
+        r2_destroy_fmindex(fm);
+
+        char text[3000];
+        r2_uint64 n, pos, len;
+        for(r2_uint64 test = 0; test < 100; ++test){
+                n = rand() % 3000 + 1;
+                for(r2_uint64 i = 0; i < n; ++i)
+                        text[i] = (char)rand();
+                fm = r2_create_fmindex(text, n, test % 50 + 1);
+                assert(r2_fmindex_size(fm) > 0);
+                pos = rand() % n;
+                len = rand() % (n - pos + 1);
+                assert(r2_fmindex_extract(fm, pos, len, out) == TRUE);
+                assert(memcmp(out, &text[pos], len) == 0);
+                r2_destroy_fmindex(fm);
+        }
+}
+
+void test_r2_fmindex_run()
+{
+        test_r2_create_fmindex();
+        test_r2_fmindex_locate();
+        test_r2_fmindex_extract();
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#ifndef R2_FMINDEX_TEST_H_
+#define R2_FMINDEX_TEST_H_
+static void test_r2_create_fmindex();
+static void test_r2_fmindex_locate();
+static void test_r2_fmindex_extract();
+void test_r2_fmindex_run();
+#endif
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <time.h>
 static r2_int16 mincmp(const void *, const void *);
 static r2_int16 maxcmp(const void *, const void *);
+static r2_int16 intcmp(const void *, const void *);
+static r2_int16 dblcmp(const void *, const void *);
 
 /**
  * @brief  Tests create functionality.
@@ -183,6 +185,260 @@ static r2_int16 maxcmp(const void *a, const void *b)
         return 1;
 }
 
+static r2_int16 intcmp(const void *a, const void *b)
+{
+        const r2_int64 *c = a; 
+        const r2_int64 *d = b; 
+        if(*c == *d)
+                return 0;
+        else if(*c < *d)
+                return -1;
+        else    return 1;
+}
+
+/**
+ * @brief  Tests create functionality of the min-max heap.
+ * 
+ */
+static void test_r2_create_mmheap()
+{
+        struct r2_mmheap *heap = r2_create_mmheap(64, intcmp, NULL, NULL);
+        assert(heap != NULL);
+        assert(heap->ncount == 0);
+        assert(heap->hsize == 64);
+        assert(heap->kcmp == intcmp);
+        assert(heap->fd == NULL);
+        assert(r2_mmheap_empty(heap) == TRUE);
+        assert(r2_mmheap_min(heap) == NULL);
+        assert(r2_mmheap_max(heap) == NULL);
+        assert(r2_destroy_mmheap(heap) == NULL);
+}
+
+/**
+ * @brief  Tests insert functionality of the min-max heap.
+ * 
+ */
+static void test_r2_mmheap_insert()
+{
+        struct r2_mmheap *heap = r2_create_mmheap(0, intcmp, NULL, NULL);
+        r2_int64 values[] = {5, 9, 1, 7, 3, 10, 0, 8, 2, 6, 4};
+        for(r2_uint64 i = 0; i < 11; ++i)
+                assert(r2_mmheap_insert(heap, &values[i]) == TRUE);
+
+        assert(heap->ncount == 11);
+        assert(*(r2_int64 *)r2_mmheap_min(heap) == 0);
+        assert(*(r2_int64 *)r2_mmheap_max(heap) == 10);
+        r2_destroy_mmheap(heap);
+}
+
+/**
+ * @brief  Tests removing the smallest element of the min-max heap.
+ * 
+ */
+static void test_r2_mmheap_remove_min()
+{
+        struct r2_mmheap *heap = r2_create_mmheap(0, intcmp, NULL, NULL);
+        r2_int64 values[] = {5, 9, 1, 7, 3, 10, 0, 8, 2, 6, 4};
+        for(r2_uint64 i = 0; i < 11; ++i)
+                r2_mmheap_insert(heap, &values[i]);
+
+        for(r2_int64 i = 0; i < 11; ++i){
+                assert(*(r2_int64 *)r2_mmheap_min(heap) == i);
+                assert(*(r2_int64 *)r2_mmheap_max(heap) == 10);
+                assert(r2_mmheap_remove_min(heap) == TRUE);
+        }
+        assert(r2_mmheap_empty(heap) == TRUE);
+        assert(r2_mmheap_remove_min(heap) == FALSE);
+        r2_destroy_mmheap(heap);
+}
+
+/**
+ * @brief  Tests removing the largest element of the min-max heap.
+ * 
+ */
+static void test_r2_mmheap_remove_max()
+{
+        struct r2_mmheap *heap = r2_create_mmheap(0, intcmp, NULL, NULL);
+        r2_int64 values[] = {5, 9, 1, 7, 3, 10, 0, 8, 2, 6, 4};
+        for(r2_uint64 i = 0; i < 11; ++i)
+                r2_mmheap_insert(heap, &values[i]);
+
+        for(r2_int64 i = 10; i >= 0; --i){
+                assert(*(r2_int64 *)r2_mmheap_max(heap) == i);
+                assert(*(r2_int64 *)r2_mmheap_min(heap) == 0);
+                assert(r2_mmheap_remove_max(heap) == TRUE);
+        }
+        assert(r2_mmheap_empty(heap) == TRUE);
+        assert(r2_mmheap_remove_max(heap) == FALSE);
+        r2_destroy_mmheap(heap);
+}
+
+/**
+ * @brief  Tests the min-max heap with random insertions and deletions from both ends.
+ * 
+ */
+static void test_r2_mmheap_random()
+{
+        const r2_uint64 size = 5000;
+        r2_uint64 count[1000] = {0};/*number of times each key is in the heap*/
+        struct r2_mmheap *heap = r2_create_mmheap(0, intcmp, free, NULL);
+        r2_int64 *key = NULL;
+        r2_int64 min  = 0;
+        r2_int64 max  = 999;
+        for(r2_uint64 i = 0; i < size; ++i){
+                key  = malloc(sizeof(r2_int64));
+                *key = rand() % 1000;
+                ++count[*key];
+                r2_mmheap_insert(heap, key);
+        }
+
+        for(r2_uint64 i = 0; i < size; ++i){
+                while(count[min] == 0)
+                        ++min;
+                while(count[max] == 0)
+                        --max;
+                assert(*(r2_int64 *)r2_mmheap_min(heap) == min);
+                assert(*(r2_int64 *)r2_mmheap_max(heap) == max);
+                if(i % 3 == 0){
+                        --count[min];
+                        r2_mmheap_remove_min(heap);
+                }else{
+                        --count[max];
+                        r2_mmheap_remove_max(heap);
+                }
+        }
+        assert(r2_mmheap_empty(heap) == TRUE);
+        r2_destroy_mmheap(heap);
+}
+
+static r2_int16 dblcmp(const void *a, const void *b)
+{
+        const r2_dbl *c = a; 
+        const r2_dbl *d = b; 
+        if(*c == *d)
+                return 0;
+        else if(*c < *d)
+                return -1;
+        else    return 1;
+}
+
+/**
+ * @brief  Tests create functionality of the top-k.
+ * 
+ */
+static void test_r2_create_topk()
+{
+        struct r2_topk *topk = r2_create_topk(10, 1, intcmp, NULL, NULL);
+        assert(topk != NULL);
+        assert(topk->k == 10);
+        assert(topk->type == 1);
+        assert(topk->ncount == 0);
+        assert(topk->kcmp == intcmp);
+        assert(r2_topk_threshold(topk) == NULL);
+        assert(r2_destroy_topk(topk) == NULL);
+}
+
+/**
+ * @brief  Tests pushing a stream into the top-k.
+ * 
+ */
+static void test_r2_topk_push()
+{
+        struct r2_topk *topk = r2_create_topk(3, 1, intcmp, NULL, NULL);
+        r2_int64 values[] = {5, 9, 1, 7, 3, 10, 0, 8, 2, 6, 4};
+        for(r2_uint64 i = 0; i < 11; ++i)
+                r2_topk_push(topk, &values[i]);
+
+        assert(topk->ncount == 3);
+        assert(*(r2_int64 *)r2_topk_threshold(topk) == 8);
+        assert(r2_topk_push(topk, &values[0]) == FALSE);
+        r2_int64 **sorted = (r2_int64 **)r2_topk_sorted(topk);
+        assert(*sorted[0] == 10 && *sorted[1] == 9 && *sorted[2] == 8);
+        free(sorted);
+
+        r2_topk_reset(topk);
+        assert(topk->ncount == 0);
+        r2_destroy_topk(topk);
+
+        /*Keeping the smallest elements*/
+        topk = r2_create_topk(4, 0, intcmp, NULL, NULL);
+        for(r2_uint64 i = 0; i < 11; ++i)
+                r2_topk_push(topk, &values[i]);
+
+        sorted = (r2_int64 **)r2_topk_sorted(topk);
+        for(r2_int64 i = 0; i < 4; ++i)
+                assert(*sorted[i] == i);
+        free(sorted);
+        r2_destroy_topk(topk);
+}
+
+/**
+ * @brief  Tests pushing an array into the top-k.
+ * 
+ */
+static void test_r2_topk_push_many()
+{
+        const r2_uint64 size = 10000;
+        r2_int64 *values = malloc(sizeof(r2_int64) * size);
+        for(r2_uint64 i = 0; i < size; ++i)
+                values[i] = (i * 7919) % size;
+
+        struct r2_topk *topk = r2_create_topk(100, 1, intcmp, NULL, NULL);
+        r2_topk_push_many(topk, values, size, sizeof(r2_int64));
+        r2_int64 **sorted = (r2_int64 **)r2_topk_sorted(topk);
+        for(r2_uint64 i = 0; i < 100; ++i)
+                assert(*sorted[i] == (r2_int64)(size - 1 - i));
+        free(sorted);
+        r2_destroy_topk(topk);
+        free(values);
+}
+
+/**
+ * @brief  Tests pushing an array of doubles into the top-k.
+ * 
+ */
+static void test_r2_topk_push_dbl()
+{
+        const r2_uint64 size = 10003;
+        r2_dbl *values = malloc(sizeof(r2_dbl) * size);
+        for(r2_uint64 i = 0; i < size; ++i)
+                values[i] = ((i * 7919) % size) / 4.0;
+
+        for(r2_uint16 type = 0; type < 2; ++type){
+                struct r2_topk *topk = r2_create_topk(100, type, dblcmp, NULL, NULL);
+                r2_topk_push_dbl(topk, values, size);
+                r2_dbl **sorted = (r2_dbl **)r2_topk_sorted(topk);
+                for(r2_uint64 i = 0; i < 100; ++i)
+                        assert(*sorted[i] == (type == 1? (size - 1 - i) / 4.0 : i / 4.0));
+                free(sorted);
+                r2_destroy_topk(topk);
+        }
+        free(values);
+}
+
+/**
+ * @brief  Tests pushing an array of integers into the top-k.
+ * 
+ */
+static void test_r2_topk_push_int64()
+{
+        const r2_uint64 size = 10003;
+        r2_int64 *values = malloc(sizeof(r2_int64) * size);
+        for(r2_uint64 i = 0; i < size; ++i)
+                values[i] = (r2_int64)((i * 7919) % size) - 5000;
+
+        for(r2_uint16 type = 0; type < 2; ++type){
+                struct r2_topk *topk = r2_create_topk(100, type, intcmp, NULL, NULL);
+                r2_topk_push_int64(topk, values, size);
+                r2_int64 **sorted = (r2_int64 **)r2_topk_sorted(topk);
+                for(r2_uint64 i = 0; i < 100; ++i)
+                        assert(*sorted[i] == (type == 1? (r2_int64)(size - 1 - i) - 5000 : (r2_int64)i - 5000));
+                free(sorted);
+                r2_destroy_topk(topk);
+        }
+        free(values);
+}
+
 /**
  * @brief Run all tests.
  * 
@@ -197,4 +453,14 @@ void test_r2_pq_run()
         test_r2_pq_empty();
         test_r2_pq_adjust();
         test_r2_pq_stats();
+        test_r2_create_mmheap();
+        test_r2_mmheap_insert();
+        test_r2_mmheap_remove_min();
+        test_r2_mmheap_remove_max();
+        test_r2_mmheap_random();
+        test_r2_create_topk();
+        test_r2_topk_push();
+        test_r2_topk_push_many();
+        test_r2_topk_push_dbl();
+        test_r2_topk_push_int64();
 }
\ No newline at end of file
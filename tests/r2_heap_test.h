@@ -9,5 +9,15 @@ static void test_r2_pq_remove_root();
 static void test_r2_pq_empty();
 static void test_r2_pq_adjust();
 static void test_r2_pq_stats();
+static void test_r2_create_mmheap();
+static void test_r2_mmheap_insert();
+static void test_r2_mmheap_remove_min();
+static void test_r2_mmheap_remove_max();
+static void test_r2_mmheap_random();
+static void test_r2_create_topk();
+static void test_r2_topk_push();
+static void test_r2_topk_push_many();
+static void test_r2_topk_push_dbl();
+static void test_r2_topk_push_int64();
 void test_r2_pq_run();
 #endif
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "r2_sort_bench.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#define QUADRATIC_MAX 10000/*largest input given to sorts that are quadratic on some distributions*/
+#define DISTRIBUTIONS 7
+#define SORTS 18
+
+static r2_uint64 ncomp = 0;/*number of comparisons made by bench_cmp*/
+
+/*A sort that is benchmarked.*/
+struct bench_sort{
+        const char *name;
+        void (*sort)(void *, r2_uint64, r2_uint64, r2_uint64, r2_cmp);/*comparison sort, NULL for integer sorts*/
+        void (*isort)(r2_int64 *, r2_uint64, r2_uint64);/*integer sort*/
+        r2_uint16 quadratic;/*TRUE when some distributions take quadratic time*/
+};
+
+static const char *distributions[DISTRIBUTIONS] = {"random", "sorted", "reversed", "few_unique", "sawtooth", "organ_pipe", "dataset"};
+
+static const struct bench_sort sorts[SORTS] = {
+        {"insertion_sort", r2_insertion_sort, NULL, TRUE},
+        {"selection_sort", r2_selection_sort, NULL, TRUE},
+        {"bubble_sort", r2_bubble_sort, NULL, TRUE},
+        {"shell_sort", r2_shell_sort, NULL, FALSE},
+        {"merge_sort", r2_merge_sort, NULL, FALSE},
+        {"merge_sort_mod", r2_merge_sort_mod, NULL, FALSE},
+        {"bmerge_sort", r2_bmerge_sort, NULL, FALSE},
+        {"bmerge_sort_mod", r2_bmerge_sort_mod, NULL, FALSE},
+        {"quick_sort", r2_quick_sort, NULL, TRUE},
+        {"quick_sort_mod", r2_quick_sort_mod, NULL, TRUE},
+        {"heap_sort", r2_heap_sort, NULL, FALSE},
+        {"pdq_sort", r2_pdq_sort, NULL, FALSE},
+        {"tim_sort", r2_tim_sort, NULL, FALSE},
+        {"inplace_merge_sort", r2_inplace_merge_sort, NULL, FALSE},
+        {"pmerge_sort", r2_pmerge_sort, NULL, FALSE},
+        {"pquick_sort", r2_pquick_sort, NULL, FALSE},
+        {"radix_sort_int64", NULL, r2_radix_sort_int64, FALSE},
+        {"simd_sort_i64", NULL, r2_simd_sort_i64, FALSE}
+};
+
+/**
+ * @brief               Runs every sort over every distribution and writes one row per run with the time in seconds,
+ *                      the number of comparisons and the number of moves. Moves are only counted when the library 
+ *                      is built with R2_SORT_STATS and comparisons include the verification pass unless it's built 
+ *                      with R2_SORT_NO_VERIFY. Comparisons and moves of the parallel sorts are estimates.
+ *                      Integer sorts don't compare elements through a callback so their comparisons are 0 and their
+ *                      moves only count block copies.
+ *
+ * @param size          Number of integers to sort, sorts that are quadratic on some distributions sort at most 10000.
+ *                      The dataset distribution sorts the integers of tests/dataset.txt.
+ * @param format        R2_BENCH_CSV or R2_BENCH_JSON.
+ * @param path          Output file, NULL writes to stdout.
+ */
+void r2_sort_bench_run(r2_uint64 size, r2_uint16 format, const char *path)
+{
+        FILE *out = path != NULL? fopen(path, "w") : stdout;
+        r2_int64 *input  = malloc(sizeof(r2_int64) * (size + 1));
+        r2_int64 *keys   = malloc(sizeof(r2_int64) * (size + 1));
+        r2_int64 *sorted = malloc(sizeof(r2_int64) * (size + 1));
+        r2_uint64 n, rows = 0;
+        r2_dbl before, seconds;
+        assert(out != NULL && input != NULL && keys != NULL && sorted != NULL);
+        if(format == R2_BENCH_CSV)
+                fprintf(out, "algorithm,distribution,n,seconds,comparisons,moves\n");
+        else    fprintf(out, "[");
+
+        for(r2_uint16 dist = 0; dist < DISTRIBUTIONS; ++dist){
+                srand(dist + 1);
+                n = dist == DISTRIBUTIONS - 1? bench_dataset(input, size) : size;
+                if(dist != DISTRIBUTIONS - 1)
+                        bench_fill(input, n, dist);
+                memcpy(sorted, input, sizeof(r2_int64) * n);
+                r2_radix_sort_int64(sorted, 0, n);
+
+                for(r2_uint16 s = 0; s < SORTS; ++s){
+                        r2_uint64 m = sorts[s].quadratic == TRUE && n > QUADRATIC_MAX? QUADRATIC_MAX : n;
+                        memcpy(keys, input, sizeof(r2_int64) * m);
+                        if(m < n){
+                                memcpy(sorted, input, sizeof(r2_int64) * m);
+                                r2_radix_sort_int64(sorted, 0, m);
+                        }
+
+                        ncomp = 0;
+                        r2_sort_reset_moves();
+                        before = bench_now();
+                        if(sorts[s].sort != NULL)
+                                sorts[s].sort(keys, 0, m, sizeof(r2_int64), bench_cmp);
+                        else    sorts[s].isort(keys, 0, m);
+                        seconds = bench_now() - before;
+                        assert(memcmp(keys, sorted, sizeof(r2_int64) * m) == 0);
+
+                        if(format == R2_BENCH_CSV){
+                                fprintf(out, "%s,%s,%llu,%.6f,%llu,", sorts[s].name, distributions[dist], m, seconds, ncomp);
+#if defined(R2_SORT_STATS)
+                                fprintf(out, "%llu", r2_sort_moves() / sizeof(r2_int64));
+#endif
+                                fprintf(out, "\n");
+                        }else{
+                                fprintf(out, "%s\n  {\"algorithm\": \"%s\", \"distribution\": \"%s\", \"n\": %llu, \"seconds\": %.6f, \"comparisons\": %llu, \"moves\": ",
+                                        rows > 0? "," : "", sorts[s].name, distributions[dist], m, seconds, ncomp);
+#if defined(R2_SORT_STATS)
+                                fprintf(out, "%llu}", r2_sort_moves() / sizeof(r2_int64));
+#else
+                                fprintf(out, "null}");
+#endif
+                        }
+                        ++rows;
+
+                        if(m < n){
+                                memcpy(sorted, input, sizeof(r2_int64) * n);
+                                r2_radix_sort_int64(sorted, 0, n);
+                        }
+                }
+        }
+
+        if(format == R2_BENCH_JSON)
+                fprintf(out, "\n]\n");
+        if(out != stdout)
+                fclose(out);
+        free(input);
+        free(keys);
+        free(sorted);
+}
+
+/**
+ * @brief               Fills keys with a distribution.
+ *
+ * @param keys          Keys.
+ * @param n             Number of keys.
+ * @param dist          Distribution, an index of distributions.
+ */
+static void bench_fill(r2_int64 *keys, r2_uint64 n, r2_uint16 dist)
+{
+        for(r2_uint64 i = 0; i < n; ++i){
+                if(dist == 0)
+                        keys[i] = ((r2_int64)rand() << 15) ^ rand();
+                else if(dist == 1)
+                        keys[i] = i;
+                else if(dist == 2)
+                        keys[i] = n - i;
+                else if(dist == 3)
+                        keys[i] = rand() % 16;
+                else if(dist == 4)/*ascending runs of 1000*/
+                        keys[i] = i % 1000;
+                else    keys[i] = i < n/2? (r2_int64)i : (r2_int64)(n - i);
+        }
+}
+
+/**
+ * @brief               Reads the integers of tests/dataset.txt.
+ *
+ * @param keys          Keys.
+ * @param size          Maximum number of keys.
+ * @return r2_uint64    Returns the number of keys read.
+ */
+static r2_uint64 bench_dataset(r2_int64 *keys, r2_uint64 size)
+{
+        FILE *fp = fopen("../tests/dataset.txt", "r");
+        r2_uint64 n = 0;
+        if(fp == NULL)
+                return 0;
+
+        while(n < size && fscanf(fp, "%lld", &keys[n]) == 1)
+                ++n;
+        fclose(fp);
+        return n;
+}
+
+/**
+ * @brief               Returns the wall clock time in seconds, parallel sorts use more processor time than wall time.
+ */
+static r2_dbl bench_now()
+{
+        struct timespec ts;
+        timespec_get(&ts, TIME_UTC);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static r2_int16 bench_cmp(const void *a, const void *b)
+{
+        const r2_int64 *c = a;
+        const r2_int64 *d = b;
+        ++ncomp;
+        return (*c > *d) - (*c < *d);
+}
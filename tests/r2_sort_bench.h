@@ -0,0 +1,11 @@
+#ifndef R2_SORT_BENCH_H_
+#define R2_SORT_BENCH_H_
+#include "../src/r2_sort.h"
+#define R2_BENCH_CSV  0
+#define R2_BENCH_JSON 1
+static void bench_fill(r2_int64 *, r2_uint64, r2_uint16);
+static r2_uint64 bench_dataset(r2_int64 *, r2_uint64);
+static r2_dbl bench_now();
+static r2_int16 bench_cmp(const void *, const void *);
+void r2_sort_bench_run(r2_uint64, r2_uint16, const char *);
+#endif
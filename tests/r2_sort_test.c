@@ -3,6 +3,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <limits.h>
+#include <string.h>
 
 static r2_int16 int_cmp(const void *, const void *);
 static r2_int16 char_cmp(const void *, const void *);
@@ -11,6 +13,40 @@ static void is_sorted(void *, r2_uint64, r2_uint64, r2_uint64 ,r2_cmp);
 static void print_ints(r2_int64 *, r2_uint64); 
 static void print_double(r2_dbl *, r2_uint64); 
 static void print_char(r2_c *, r2_uint64);
+static r2_int16 uint_cmp(const void *, const void *);
+static r2_int16 float_cmp(const void *, const void *);
+static r2_uint64 record_key(const void *);
+static r2_int16 count_cmp(const void *, const void *);
+static r2_uint64 big_key(const void *);
+static r2_int16 str_cmp(const void *, const void *);
+static r2_uint16 cursor_next(void *, void *);
+static void cursor_push(void *, void *);
+
+static r2_uint64 ncomp = 0;/*number of comparisons made by count_cmp*/
+
+/*A large record that is sorted by an unsigned key.*/
+struct big_record{
+        r2_uint64 key;
+        r2_uint64 pos;
+        char payload[496];
+};
+
+/*A position in an array of integers that is read or written one integer at a time.*/
+struct cursor{
+        r2_int64 *arr;
+        r2_uint64 n;
+        r2_uint64 pos;
+};
+
+/*A record that is sorted by key.*/
+struct record{
+        r2_int64 key;
+        r2_uint64 pos;
+        char payload[100];
+};
+
+R2_SORT_DEFINE(test_int64, r2_int64, *a < *b)
+R2_SORT_DEFINE(test_record, struct record, a->key < b->key)
 
 static void test_insertion_sort()
 {
@@ -458,6 +494,899 @@ static void test_r2_heap_sort()
         } 
 }
 
+static void test_r2_radix_sort()
+{
+        printf("\n--------------------------------Radix Sort----------------------------------------\n");
+        r2_int64 unsorted[] = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        r2_int64 sorted[]   = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        r2_int64 mixed[]    = {1, 10, 5, 4, 2, 10, 9, 8, 7, -6};
+        void *seq[] = {unsorted, sorted, mixed};
+        for(r2_uint16 i = 0; i < 3; ++i){
+                printf("\nBefore:");
+                print_ints(seq[i], 10);
+                r2_radix_sort_int64(seq[i], 0, 10);
+                is_sorted(seq[i], 0, 10, sizeof(r2_int64), int_cmp);
+                printf("\nAfter:");
+                print_ints(seq[i], 10);
+        }
+
+        r2_dbl vals[][10] = {{.12, 0.002, 5.14, -.0111, 3.14, 1.498, .451, -99, 100, 8},
+                             {1, 2, 3, 4, 5, 6, 7, 8, 9, 10},
+                             {1, 10, 5, 4, 2, 10, 9, 8, 7, -6}};
+
+        for(r2_uint16 i = 0; i < 3; ++i){
+                printf("\nBefore:");
+                print_double(vals[i], 10);
+                r2_radix_sort_dbl(vals[i], 0, 10);
+                is_sorted(vals[i], 0, 10, sizeof(r2_dbl), double_cmp);
+                printf("\nAfter:");
+                print_double(vals[i], 10);
+        }
+
+        float fvals[] = {.12f, 0.002f, 5.14f, -.0111f, 3.14f, -1.498f, .451f, -99.0f, 100.0f, 8.0f};
+        r2_radix_sort_flt(fvals, 0, 10);
+        is_sorted(fvals, 0, 10, sizeof(float), float_cmp);
+
+        /*Testing radix sort not starting from zero*/
+        r2_uint64 keys[] = {5, 1, 5, 2, 4, 3};
+        r2_radix_sort_u64(keys, 1, 6);
+        is_sorted(keys, 1, 6, sizeof(r2_uint64), uint_cmp);
+        assert(keys[0] == 5);
+
+        const r2_uint64 size = 400000;
+        r2_uint32 *ukeys = malloc(sizeof(r2_uint32) * size);
+        r2_int64 *ikeys = malloc(sizeof(r2_int64) * size);
+        r2_int64 *qkeys = malloc(sizeof(r2_int64) * size);
+        for(r2_uint64 i = 0; i < size; ++i){
+                ukeys[i] = rand() % 1000000;
+                ikeys[i] = qkeys[i] = (r2_int64)(rand() % 1000000) - 500000;
+        }
+
+        r2_radix_sort_u32(ukeys, 0, size);
+        for(r2_uint64 i = 1; i < size; ++i)
+                assert(ukeys[i-1] <= ukeys[i]);
+
+        clock_t before = clock();
+        r2_radix_sort_int64(ikeys, 0, size);
+        double radix = (double)(clock() - before) / CLOCKS_PER_SEC;
+        before = clock();
+        r2_quick_sort(qkeys, 0, size, sizeof(r2_int64), int_cmp);
+        double quick = (double)(clock() - before) / CLOCKS_PER_SEC;
+        for(r2_uint64 i = 0; i < size; ++i)
+                assert(ikeys[i] == qkeys[i]);
+        printf("\nRadix Sort: %lf Quick Sort: %lf", radix, quick);
+
+        /*Sorting records by key must be stable*/
+        struct record *records = malloc(sizeof(struct record) * 1000);
+        for(r2_uint64 i = 0; i < 1000; ++i){
+                records[i].key = (r2_int64)(rand() % 50) - 25;
+                records[i].pos = i;
+        }
+        r2_radix_sort_key(records, 0, 1000, sizeof(struct record), record_key);
+        for(r2_uint64 i = 1; i < 1000; ++i){
+                assert(records[i-1].key <= records[i].key);
+                if(records[i-1].key == records[i].key)
+                        assert(records[i-1].pos < records[i].pos);
+        }
+
+        free(ukeys);
+        free(ikeys);
+        free(qkeys);
+        free(records);
+}
+
+static void test_r2_parallel_sort()
+{
+        printf("\n--------------------------------Parallel Sort----------------------------------------\n");
+        r2_int64 unsorted[] = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        r2_int64 sorted[]   = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        r2_int64 mixed[]    = {1, 10, 5, 4, 2, 10, 9, 8, 7, -6};
+        void *seq[] = {unsorted, sorted, mixed};
+        for(r2_uint16 i = 0; i < 3; ++i){
+                printf("\nBefore:");
+                print_ints(seq[i], 10);
+                if(i % 2 == 0)
+                        r2_pmerge_sort(seq[i], 0, 10, sizeof(r2_int64), int_cmp);
+                else    r2_pquick_sort(seq[i], 0, 10, sizeof(r2_int64), int_cmp);
+                is_sorted(seq[i], 0, 10, sizeof(r2_int64), int_cmp);
+                printf("\nAfter:");
+                print_ints(seq[i], 10);
+        }
+
+        const r2_uint64 size = 1000000;
+        r2_int64 *mkeys = malloc(sizeof(r2_int64) * size);
+        r2_int64 *qkeys = malloc(sizeof(r2_int64) * size);
+        r2_int64 *rkeys = malloc(sizeof(r2_int64) * size);
+        struct record *records = malloc(sizeof(struct record) * size);
+        r2_uint64 threads[] = {1, 4, 0};
+        for(r2_uint16 t = 0; t < 3; ++t){
+                r2_sort_set_threads(threads[t]);
+                for(r2_uint16 dist = 0; dist < 3; ++dist){
+                        for(r2_uint64 i = 0; i < size; ++i){
+                                if(dist == 0)
+                                        mkeys[i] = rand() % 1000000;
+                                else if(dist == 1)
+                                        mkeys[i] = i % 1000;
+                                else    mkeys[i] = rand() % 3;
+                                qkeys[i] = rkeys[i] = mkeys[i];
+                                records[i].key = mkeys[i];
+                                records[i].pos = i;
+                        }
+
+                        r2_radix_sort_int64(rkeys, 0, size);
+                        r2_pmerge_sort(mkeys, 0, size, sizeof(r2_int64), int_cmp);
+                        r2_pquick_sort(qkeys, 0, size, sizeof(r2_int64), int_cmp);
+                        for(r2_uint64 i = 0; i < size; ++i)
+                                assert(mkeys[i] == rkeys[i] && qkeys[i] == rkeys[i]);
+
+                        /*Parallel merge sort must be stable*/
+                        r2_pmerge_sort(records, 0, size, sizeof(struct record), int_cmp);
+                        for(r2_uint64 i = 1; i < size; ++i){
+                                assert(records[i-1].key <= records[i].key);
+                                if(records[i-1].key == records[i].key)
+                                        assert(records[i-1].pos < records[i].pos);
+                        }
+                }
+        }
+        r2_sort_set_threads(0);
+
+        /*Testing parallel sort not starting from zero*/
+        r2_uint64 keys[] = {5, 1, 5, 2, 4, 3};
+        r2_pquick_sort(keys, 1, 6, sizeof(r2_uint64), int_cmp);
+        is_sorted(keys, 1, 6, sizeof(r2_uint64), int_cmp);
+        assert(keys[0] == 5);
+
+        free(mkeys);
+        free(qkeys);
+        free(rkeys);
+        free(records);
+}
+
+static void test_r2_pdq_sort()
+{
+        printf("\n--------------------------------Pdq Sort----------------------------------------\n");
+        r2_int64 unsorted[] = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        r2_int64 sorted[]   = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        r2_int64 mixed[]    = {1, 10, 5, 4, 2, 10, 9, 8, 7, -6};
+        void *seq[] = {unsorted, sorted, mixed};
+        for(r2_uint16 i = 0; i < 3; ++i){
+                printf("\nBefore:");
+                print_ints(seq[i], 10);
+                r2_pdq_sort(seq[i], 0, 10, sizeof(r2_int64), int_cmp);
+                is_sorted(seq[i], 0, 10, sizeof(r2_int64), int_cmp);
+                printf("\nAfter:");
+                print_ints(seq[i], 10);
+        }
+
+        const r2_uint64 size = 1000000;
+        r2_int64 *keys  = malloc(sizeof(r2_int64) * size);
+        r2_int64 *rkeys = malloc(sizeof(r2_int64) * size);
+        struct record *records = malloc(sizeof(struct record) * 10000);
+        for(r2_uint16 dist = 0; dist < 6; ++dist){
+                for(r2_uint64 i = 0; i < size; ++i){
+                        if(dist == 0)
+                                keys[i] = rand() % 1000000;
+                        else if(dist == 1)
+                                keys[i] = i;
+                        else if(dist == 2)
+                                keys[i] = size - i;
+                        else if(dist == 3)
+                                keys[i] = i % 100 == 0? rand() : (r2_int64)i;
+                        else if(dist == 4)
+                                keys[i] = rand() % 4;
+                        else    keys[i] = i < size/2? (r2_int64)i : (r2_int64)(size - i);
+                        rkeys[i] = keys[i];
+                }
+
+                r2_radix_sort_int64(rkeys, 0, size);
+                r2_pdq_sort(keys, 0, size, sizeof(r2_int64), int_cmp);
+                for(r2_uint64 i = 0; i < size; ++i)
+                        assert(keys[i] == rkeys[i]);
+        }
+
+        /*Testing large elements*/
+        for(r2_uint64 i = 0; i < 10000; ++i){
+                records[i].key = rand() % 100;
+                records[i].pos = i;
+        }
+        r2_pdq_sort(records, 0, 10000, sizeof(struct record), int_cmp);
+        is_sorted(records, 0, 10000, sizeof(struct record), int_cmp);
+
+        /*Testing pdq sort not starting from zero*/
+        r2_int64 part[] = {5, 1, 5, 2, 4, 3};
+        r2_pdq_sort(part, 1, 6, sizeof(r2_int64), int_cmp);
+        is_sorted(part, 1, 6, sizeof(r2_int64), int_cmp);
+        assert(part[0] == 5);
+
+        free(keys);
+        free(rkeys);
+        free(records);
+}
+
+static void test_r2_simd_sort()
+{
+        printf("\n--------------------------------SIMD Sort----------------------------------------\n");
+        const r2_uint64 size = 1000000;
+        r2_int32 *ikeys  = malloc(sizeof(r2_int32) * size);
+        r2_int64 *lkeys  = malloc(sizeof(r2_int64) * size);
+        r2_int64 *rkeys  = malloc(sizeof(r2_int64) * size);
+        float *fkeys     = malloc(sizeof(float) * size);
+        float *frkeys    = malloc(sizeof(float) * size);
+        r2_dbl *dkeys    = malloc(sizeof(r2_dbl) * size);
+        r2_dbl *drkeys   = malloc(sizeof(r2_dbl) * size);
+        r2_uint64 sizes[] = {0, 1, 2, 7, 8, 9, 15, 16, 17, 31, 33, 63, 64, 65, 100, 129, 1000, 100000, size};
+        r2_uint16 level = r2_sort_simd();
+        printf("\nInstruction set: %u", level);
+        for(r2_uint16 simd = R2_SORT_SCALAR; simd <= level; ++simd){
+                r2_sort_set_simd(simd);
+                assert(r2_sort_simd() == simd);
+                for(r2_uint16 s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s){
+                        r2_uint64 n = sizes[s];
+                        for(r2_uint16 dist = 0; dist < 4; ++dist){
+                                for(r2_uint64 i = 0; i < n; ++i){
+                                        if(dist == 0)
+                                                lkeys[i] = rand() - RAND_MAX/2;
+                                        else if(dist == 1)
+                                                lkeys[i] = rand() % 3;
+                                        else if(dist == 2)
+                                                lkeys[i] = n - i;
+                                        else    lkeys[i] = i % 100 == 0? rand() : (r2_int64)i;
+                                        ikeys[i]  = (r2_int32)lkeys[i];
+                                        rkeys[i]  = lkeys[i];
+                                        fkeys[i]  = frkeys[i] = (float)lkeys[i] / 7;
+                                        dkeys[i]  = drkeys[i] = (r2_dbl)lkeys[i] / 7;
+                                }
+                                if(n > 2){
+                                        lkeys[0] = rkeys[0] = LLONG_MIN;
+                                        ikeys[0] = INT_MIN;
+                                        ikeys[n - 1] = INT_MAX;
+                                        fkeys[0] = frkeys[0] = -0.0f;
+                                        dkeys[0] = drkeys[0] = -0.0;
+                                }
+
+                                r2_radix_sort_int64(rkeys, 0, n);
+                                r2_radix_sort_flt(frkeys, 0, n);
+                                r2_radix_sort_dbl(drkeys, 0, n);
+                                r2_simd_sort_i64(lkeys, 0, n);
+                                r2_simd_sort_flt(fkeys, 0, n);
+                                r2_simd_sort_dbl(dkeys, 0, n);
+                                for(r2_uint64 i = 0; i < n; ++i)
+                                        assert(lkeys[i] == rkeys[i] && fkeys[i] == frkeys[i] && dkeys[i] == drkeys[i]);
+
+                                for(r2_uint64 i = 0; i < n; ++i)
+                                        rkeys[i] = ikeys[i];
+                                r2_radix_sort_int64(rkeys, 0, n);
+                                r2_simd_sort_i32(ikeys, 0, n);
+                                for(r2_uint64 i = 0; i < n; ++i)
+                                        assert(ikeys[i] == rkeys[i]);
+                        }
+                }
+        }
+
+        /*Testing the AVX2 networks on their own, even when AVX-512 is available*/
+        if(level >= R2_SORT_AVX2){
+                r2_sort_set_simd(R2_SORT_AVX2);
+                for(r2_uint64 n = 5; n <= 64; ++n){
+                        for(r2_uint64 i = 0; i < n; ++i){
+                                lkeys[i] = rkeys[i] = (r2_int64)((i*7919) % n) - (r2_int64)n/2;
+                                ikeys[i] = (r2_int32)lkeys[i];
+                                fkeys[i] = frkeys[i] = (float)lkeys[i] / 3;
+                                dkeys[i] = drkeys[i] = (r2_dbl)lkeys[i] / 3;
+                        }
+                        r2_radix_sort_int64(rkeys, 0, n);
+                        r2_radix_sort_flt(frkeys, 0, n);
+                        r2_radix_sort_dbl(drkeys, 0, n);
+                        r2_simd_sort_i64(lkeys, 0, n);
+                        r2_simd_sort_i32(ikeys, 0, n);
+                        r2_simd_sort_flt(fkeys, 0, n);
+                        r2_simd_sort_dbl(dkeys, 0, n);
+                        for(r2_uint64 i = 0; i < n; ++i){
+                                assert(lkeys[i] != LLONG_MAX && ikeys[i] != INT_MAX);
+                                assert(lkeys[i] == rkeys[i] && ikeys[i] == rkeys[i]);
+                                assert(fkeys[i] == frkeys[i] && dkeys[i] == drkeys[i]);
+                        }
+                }
+        }
+        r2_sort_set_simd(R2_SORT_AVX512);
+
+        /*Testing SIMD sort not starting from zero*/
+        r2_int64 keys[] = {5, 1, 5, 2, 4, 3};
+        r2_simd_sort_i64(keys, 1, 6);
+        is_sorted(keys, 1, 6, sizeof(r2_int64), int_cmp);
+        assert(keys[0] == 5);
+
+        free(ikeys);
+        free(lkeys);
+        free(rkeys);
+        free(fkeys);
+        free(frkeys);
+        free(dkeys);
+        free(drkeys);
+}
+
+static void test_r2_tim_sort()
+{
+        printf("\n--------------------------------Tim Sort----------------------------------------\n");
+        r2_int64 unsorted[] = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        r2_int64 sorted[]   = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        r2_int64 mixed[]    = {1, 10, 5, 4, 2, 10, 9, 8, 7, -6};
+        void *seq[] = {unsorted, sorted, mixed};
+        for(r2_uint16 i = 0; i < 3; ++i){
+                printf("\nBefore:");
+                print_ints(seq[i], 10);
+                r2_tim_sort(seq[i], 0, 10, sizeof(r2_int64), int_cmp);
+                is_sorted(seq[i], 0, 10, sizeof(r2_int64), int_cmp);
+                printf("\nAfter:");
+                print_ints(seq[i], 10);
+        }
+
+        const r2_uint64 size = 1000000;
+        struct record *records = malloc(sizeof(struct record) * size);
+        r2_int64 *keys  = malloc(sizeof(r2_int64) * size);
+        r2_int64 *rkeys = malloc(sizeof(r2_int64) * size);
+        for(r2_uint16 dist = 0; dist < 7; ++dist){
+                for(r2_uint64 i = 0; i < size; ++i){
+                        if(dist == 0)
+                                keys[i] = rand() % 1000000;
+                        else if(dist == 1)
+                                keys[i] = i;
+                        else if(dist == 2)
+                                keys[i] = size - i;
+                        else if(dist == 3)/*95% ordered by timestamp*/
+                                keys[i] = rand() % 100 < 95? (r2_int64)i : (r2_int64)(rand() % size);
+                        else if(dist == 4)/*sorted with a random tail appended*/
+                                keys[i] = i < size - 1000? (r2_int64)i : (r2_int64)(rand() % size);
+                        else if(dist == 5)
+                                keys[i] = rand() % 4;
+                        else    keys[i] = (i / 5000) % 2 == 0? (r2_int64)i : (r2_int64)(size - i);
+                        rkeys[i] = keys[i];
+                }
+
+                ncomp = 0;
+                r2_radix_sort_int64(rkeys, 0, size);
+                r2_tim_sort(keys, 0, size, sizeof(r2_int64), count_cmp);
+                for(r2_uint64 i = 0; i < size; ++i)
+                        assert(keys[i] == rkeys[i]);
+
+                /*is_sorted is counted as well unless it's compiled out*/
+                printf("\nDistribution %u: %llu comparisons", dist, ncomp);
+                #if defined(R2_SORT_NO_VERIFY)
+                        if(dist == 1)
+                                assert(ncomp == size - 1);
+                #else
+                        if(dist == 1)
+                                assert(ncomp == 2*(size - 1));
+                #endif
+                if(dist == 4)
+                        assert(ncomp < 3*size);
+        }
+
+        /*Tim sort must be stable*/
+        for(r2_uint64 i = 0; i < size; ++i){
+                records[i].key = rand() % 100 < 90? (r2_int64)(i / 10) : rand() % 1000;
+                records[i].pos = i;
+        }
+        r2_tim_sort(records, 0, size, sizeof(struct record), int_cmp);
+        for(r2_uint64 i = 1; i < size; ++i){
+                assert(records[i-1].key <= records[i].key);
+                if(records[i-1].key == records[i].key)
+                        assert(records[i-1].pos < records[i].pos);
+        }
+
+        /*Testing tim sort not starting from zero*/
+        r2_int64 part[] = {5, 1, 5, 2, 4, 3};
+        r2_tim_sort(part, 1, 6, sizeof(r2_int64), int_cmp);
+        is_sorted(part, 1, 6, sizeof(r2_int64), int_cmp);
+        assert(part[0] == 5);
+
+        free(records);
+        free(keys);
+        free(rkeys);
+}
+
+static void test_r2_inplace_merge_sort()
+{
+        printf("\n--------------------------------In-place Merge Sort----------------------------------------\n");
+        r2_int64 unsorted[] = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        r2_int64 sorted[]   = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        r2_int64 mixed[]    = {1, 10, 5, 4, 2, 10, 9, 8, 7, -6};
+        void *seq[] = {unsorted, sorted, mixed};
+        for(r2_uint16 i = 0; i < 3; ++i){
+                r2_inplace_merge_sort(seq[i], 0, 10, sizeof(r2_int64), int_cmp);
+                is_sorted(seq[i], 0, 10, sizeof(r2_int64), int_cmp);
+        }
+
+        const r2_uint64 size = 1000000;
+        struct record *records = malloc(sizeof(struct record) * size);
+        r2_int64 *keys  = malloc(sizeof(r2_int64) * size);
+        r2_int64 *rkeys = malloc(sizeof(r2_int64) * size);
+        for(r2_uint16 dist = 0; dist < 5; ++dist){
+                for(r2_uint64 i = 0; i < size; ++i){
+                        if(dist == 0)
+                                keys[i] = rand() % 1000000;
+                        else if(dist == 1)
+                                keys[i] = size - i;
+                        else if(dist == 2)
+                                keys[i] = rand() % 4;
+                        else if(dist == 3)
+                                keys[i] = rand() % 100 < 95? (r2_int64)i : (r2_int64)(rand() % size);
+                        else    keys[i] = (i / 5000) % 2 == 0? (r2_int64)i : (r2_int64)(size - i);
+                        rkeys[i] = keys[i];
+                }
+
+                r2_radix_sort_int64(rkeys, 0, size);
+                r2_inplace_merge_sort(keys, 0, size, sizeof(r2_int64), int_cmp);
+                for(r2_uint64 i = 0; i < size; ++i)
+                        assert(keys[i] == rkeys[i]);
+        }
+
+        /*In-place merge sort must be stable*/
+        for(r2_uint16 dist = 0; dist < 2; ++dist){
+                for(r2_uint64 i = 0; i < size; ++i){
+                        records[i].key = dist == 0? rand() % 1000 : (r2_int64)((size - i) / 3);
+                        records[i].pos = i;
+                }
+                r2_inplace_merge_sort(records, 0, size, sizeof(struct record), int_cmp);
+                for(r2_uint64 i = 1; i < size; ++i){
+                        assert(records[i-1].key <= records[i].key);
+                        if(records[i-1].key == records[i].key)
+                                assert(records[i-1].pos < records[i].pos);
+                }
+        }
+
+        /*Testing in-place merge sort not starting from zero*/
+        r2_int64 part[] = {5, 1, 5, 2, 4, 3};
+        r2_inplace_merge_sort(part, 1, 6, sizeof(r2_int64), int_cmp);
+        is_sorted(part, 1, 6, sizeof(r2_int64), int_cmp);
+        assert(part[0] == 5);
+
+        free(records);
+        free(keys);
+        free(rkeys);
+}
+
+static void test_r2_sort_define()
+{
+        printf("\n--------------------------------Typed Sorts----------------------------------------\n");
+        const r2_uint64 size = 300000;
+        struct record *records = malloc(sizeof(struct record) * size);
+        r2_int64 *keys  = malloc(sizeof(r2_int64) * size);
+        r2_int64 *rkeys = malloc(sizeof(r2_int64) * size);
+        for(r2_uint16 sort = 0; sort < 4; ++sort){
+                for(r2_uint16 dist = 0; dist < 5; ++dist){
+                        for(r2_uint64 i = 0; i < size; ++i){
+                                if(dist == 0)
+                                        keys[i] = ((r2_int64)rand() << 16) - ((r2_int64)rand() << 8);
+                                else if(dist == 1)
+                                        keys[i] = i;
+                                else if(dist == 2)
+                                        keys[i] = size - i;
+                                else if(dist == 3)
+                                        keys[i] = rand() % 3;
+                                else    keys[i] = i < size/2? (r2_int64)i : (r2_int64)(size - i);
+                                rkeys[i] = keys[i];
+                        }
+
+                        r2_radix_sort_int64(rkeys, 0, size);
+                        /*Insertion sort is quadratic so it only sorts a prefix.*/
+                        if(sort == 0){
+                                test_int64_insertion_sort(keys, 0, 2000);
+                                is_sorted(keys, 0, 2000, sizeof(r2_int64), int_cmp);
+                                continue;
+                        }
+
+                        if(sort == 1)
+                                test_int64_quick_sort(keys, 0, size);
+                        else if(sort == 2)
+                                test_int64_merge_sort(keys, 0, size);
+                        else    test_int64_heap_sort(keys, 0, size);
+                        for(r2_uint64 i = 0; i < size; ++i)
+                                assert(keys[i] == rkeys[i]);
+                }
+        }
+
+        /*The typed merge sort must be stable*/
+        for(r2_uint64 i = 0; i < size; ++i){
+                records[i].key = rand() % 1000;
+                records[i].pos = i;
+        }
+        test_record_merge_sort(records, 0, size);
+        for(r2_uint64 i = 1; i < size; ++i){
+                assert(records[i-1].key <= records[i].key);
+                if(records[i-1].key == records[i].key)
+                        assert(records[i-1].pos < records[i].pos);
+        }
+        test_record_quick_sort(records, 0, size);
+        is_sorted(records, 0, size, sizeof(struct record), int_cmp);
+
+        /*Testing typed sorts not starting from zero*/
+        r2_int64 part[] = {5, 1, 5, 2, 4, 3};
+        test_int64_quick_sort(part, 1, 6);
+        is_sorted(part, 1, 6, sizeof(r2_int64), int_cmp);
+        assert(part[0] == 5);
+
+        free(records);
+        free(keys);
+        free(rkeys);
+}
+
+static void test_r2_select()
+{
+        printf("\n--------------------------------Selection----------------------------------------\n");
+        r2_int64 mixed[] = {1, 10, 5, 4, 2, 10, 9, 8, 7, -6};
+        r2_nth_element(mixed, 0, 10, sizeof(r2_int64), 4, int_cmp);
+        assert(mixed[4] == 5);
+        for(r2_uint64 i = 0; i < 10; ++i)
+                assert(i < 4? mixed[i] <= 5 : mixed[i] >= 5);
+
+        const r2_uint64 size = 200000;
+        r2_int64 *keys   = malloc(sizeof(r2_int64) * size);
+        r2_int64 *sorted = malloc(sizeof(r2_int64) * size);
+        r2_uint64 ranks[] = {size - 1, 0, size / 2, 17, size / 2, size / 3};
+        r2_dbl qs[] = {0, 0.25, 0.5, 0.75, 0.99, 1};
+        r2_uint64 pos[6];
+        for(r2_uint16 dist = 0; dist < 5; ++dist){
+                for(r2_uint16 test = 0; test < 4; ++test){
+                        for(r2_uint64 i = 0; i < size; ++i){
+                                if(dist == 0)
+                                        keys[i] = rand();
+                                else if(dist == 1)
+                                        keys[i] = rand() % 4;
+                                else if(dist == 2)
+                                        keys[i] = 7;
+                                else if(dist == 3)
+                                        keys[i] = i;
+                                else    keys[i] = size - i;
+                                sorted[i] = keys[i];
+                        }
+                        r2_radix_sort_int64(sorted, 0, size);
+
+                        if(test == 0){
+                                r2_uint64 nth = rand() % size;
+                                r2_nth_element(keys, 0, size, sizeof(r2_int64), nth, int_cmp);
+                                assert(keys[nth] == sorted[nth]);
+                                for(r2_uint64 i = 0; i < size; ++i)
+                                        assert(i < nth? keys[i] <= keys[nth] : keys[i] >= keys[nth]);
+                        }else if(test == 1){
+                                /*The 100 smallest elements must be sorted*/
+                                r2_partial_sort(keys, 0, 100, size, sizeof(r2_int64), int_cmp);
+                                for(r2_uint64 i = 0; i < size; ++i)
+                                        assert(i < 100? keys[i] == sorted[i] : keys[i] >= keys[99]);
+                        }else if(test == 2){
+                                r2_multi_select(keys, 0, size, sizeof(r2_int64), ranks, 6, int_cmp);
+                                for(r2_uint64 i = 0; i < 6; ++i)
+                                        assert(keys[ranks[i]] == sorted[ranks[i]]);
+                                for(r2_uint64 i = 0; i < size; ++i)
+                                        assert(i < 17? keys[i] <= keys[17] : keys[i] >= keys[17]);
+                                for(r2_uint64 i = size / 3; i < size / 2; ++i)
+                                        assert(keys[i] >= keys[size / 3] && keys[i] <= keys[size / 2]);
+                        }else{
+                                r2_quantiles(keys, 0, size, sizeof(r2_int64), qs, 6, pos, int_cmp);
+                                assert(pos[0] == 0 && pos[2] == (size - 1) / 2 && pos[5] == size - 1);
+                                for(r2_uint64 i = 0; i < 6; ++i)
+                                        assert(keys[pos[i]] == sorted[pos[i]]);
+                        }
+                }
+        }
+
+        /*Testing selection not starting from zero*/
+        r2_int64 part[] = {5, 1, 5, 2, 4, 3};
+        r2_nth_element(part, 1, 6, sizeof(r2_int64), 2, int_cmp);
+        assert(part[0] == 5 && part[2] == 2);
+        r2_partial_sort(part, 1, 3, 6, sizeof(r2_int64), int_cmp);
+        assert(part[0] == 5 && part[1] == 1 && part[2] == 2);
+
+        free(keys);
+        free(sorted);
+}
+
+static void test_r2_string_sort()
+{
+        printf("\n--------------------------------String Sort----------------------------------------\n");
+        char *words[] = {"she", "sells", "seashells", "by", "the", "sea", "shore", "", "the", "shells", "she", "sells", "are", "surely", "seashells"};
+        char *copy[15];
+        for(r2_uint16 sort = 0; sort < 2; ++sort){
+                memcpy(copy, words, sizeof(words));
+                if(sort == 0)
+                        r2_string_sort(copy, 0, 15);
+                else    r2_string_radix_sort(copy, 0, 15);
+                for(r2_uint64 i = 1; i < 15; ++i)
+                        assert(strcmp(copy[i-1], copy[i]) <= 0);
+                assert(strcmp(copy[0], "") == 0 && strcmp(copy[14], "the") == 0);
+        }
+
+        const r2_uint64 size = 200000;
+        char *pool = malloc(size * 64);
+        char **strs   = malloc(sizeof(char *) * size);
+        char **sorted = malloc(sizeof(char *) * size);
+        r2_uint64 len;
+        for(r2_uint16 dist = 0; dist < 4; ++dist){
+                for(r2_uint64 i = 0; i < size; ++i){
+                        strs[i] = &pool[i*64];
+                        if(dist == 0){/*random lengths and bytes, including bytes above 127*/
+                                len = rand() % 63;
+                                for(r2_uint64 j = 0; j < len; ++j)
+                                        strs[i][j] = (char)(rand() % 255 + 1);
+                                strs[i][len] = '\0';
+                        }else if(dist == 1)/*long common prefix*/
+                                sprintf(strs[i], "https://example.com/items/%llu", (unsigned long long)(rand() % 50000));
+                        else if(dist == 2)/*few distinct strings*/
+                                sprintf(strs[i], "key%d", rand() % 3);
+                        else    sprintf(strs[i], "%020llu", (unsigned long long)(size - i));
+                        sorted[i] = strs[i];
+                }
+                r2_merge_sort(sorted, 0, size, sizeof(char *), str_cmp);
+
+                for(r2_uint16 sort = 0; sort < 2; ++sort){
+                        for(r2_uint64 i = 0; i < size; ++i)
+                                strs[i] = &pool[i*64];
+                        if(sort == 0)
+                                r2_string_sort(strs, 0, size);
+                        else    r2_string_radix_sort(strs, 0, size);
+                        for(r2_uint64 i = 0; i < size; ++i)
+                                assert(strcmp(strs[i], sorted[i]) == 0);
+                }
+        }
+
+        /*Testing strings nested in each other, "a", "aa", ... share a prefix as long as the shorter string*/
+        const r2_uint64 nested = 5000;
+        char *as = malloc(nested + 1);
+        memset(as, 'a', nested);
+        as[nested] = '\0';
+        for(r2_uint16 sort = 0; sort < 2; ++sort){
+                for(r2_uint64 i = 0; i < nested; ++i)
+                        strs[i] = &as[i];
+                for(r2_uint64 i = nested - 1; i > 0; --i){
+                        r2_uint64 j = rand() % (i + 1);
+                        char *t = strs[i];
+                        strs[i] = strs[j];
+                        strs[j] = t;
+                }
+                if(sort == 0)
+                        r2_string_sort(strs, 0, nested);
+                else    r2_string_radix_sort(strs, 0, nested);
+                for(r2_uint64 i = 0; i < nested; ++i)
+                        assert(strs[i] == &as[nested - 1 - i]);
+        }
+        free(as);
+
+        /*Testing string sorts not starting from zero*/
+        char *part[] = {"z", "d", "c", "b", "a"};
+        r2_string_sort(part, 1, 5);
+        assert(strcmp(part[0], "z") == 0 && strcmp(part[1], "a") == 0 && strcmp(part[4], "d") == 0);
+        r2_string_radix_sort(part, 0, 4);
+        assert(strcmp(part[0], "a") == 0 && strcmp(part[3], "z") == 0 && strcmp(part[4], "d") == 0);
+
+        free(pool);
+        free(strs);
+        free(sorted);
+}
+
+static void test_r2_kway_merge()
+{
+        printf("\n--------------------------------K-way Merge----------------------------------------\n");
+        r2_uint64 ks[] = {1, 2, 3, 7, 64, 1000};
+        const r2_uint64 size = 200000;
+        struct record *records = malloc(sizeof(struct record) * size);
+        struct record *merged  = malloc(sizeof(struct record) * size);
+        r2_int64 *keys    = malloc(sizeof(r2_int64) * size);
+        r2_int64 *out     = malloc(sizeof(r2_int64) * size);
+        r2_int64 *sorted  = malloc(sizeof(r2_int64) * size);
+        void **arrs       = malloc(sizeof(void *) * 1000);
+        r2_int64 **iarrs  = malloc(sizeof(r2_int64 *) * 1000);
+        struct cursor *cursors = malloc(sizeof(struct cursor) * 1000);
+        void **iters      = malloc(sizeof(void *) * 1000);
+        r2_uint64 *sizes  = malloc(sizeof(r2_uint64) * 1000);
+        struct cursor dest;
+        r2_uint64 k, lg, n;
+        for(r2_uint16 t = 0; t < 6; ++t){
+                k = ks[t];
+                /*Runs of random sizes, some of them empty.*/
+                n = 0;
+                for(r2_uint64 i = 0; i < k; ++i){
+                        sizes[i] = i + 1 == k? size - n : (r2_uint64)rand() % (2*size/k + 1);
+                        if(sizes[i] > size - n)
+                                sizes[i] = size - n;
+                        n += sizes[i];
+                }
+
+                for(r2_uint64 i = 0; i < size; ++i){
+                        records[i].key = rand() % 1000;
+                        keys[i] = sorted[i] = ((r2_int64)rand() << 16) - ((r2_int64)rand() << 8);
+                }
+
+                n = 0;
+                for(r2_uint64 i = 0; i < k; ++i){
+                        arrs[i]  = &records[n];
+                        iarrs[i] = &keys[n];
+                        r2_tim_sort(&records[n], 0, sizes[i], sizeof(struct record), int_cmp);
+                        r2_radix_sort_int64(keys, n, n + sizes[i]);
+                        for(r2_uint64 j = n; j < n + sizes[i]; ++j)
+                                records[j].pos = j;
+                        cursors[i].arr = &keys[n];
+                        cursors[i].n   = sizes[i];
+                        cursors[i].pos = 0;
+                        iters[i] = &cursors[i];
+                        n += sizes[i];
+                }
+                r2_radix_sort_int64(sorted, 0, size);
+
+                /*Equal keys must keep the order of their runs, positions grow with the run.*/
+                ncomp = 0;
+                r2_kway_merge(arrs, sizes, k, sizeof(struct record), merged, count_cmp);
+                for(r2_uint64 i = 1; i < size; ++i){
+                        assert(merged[i-1].key <= merged[i].key);
+                        if(merged[i-1].key == merged[i].key)
+                                assert(merged[i-1].pos < merged[i].pos);
+                }
+
+                for(lg = 0; ((r2_uint64)1 << lg) < k; ++lg);
+                printf("\nk = %llu: %.2f comparisons per element", k, (r2_dbl)ncomp / size);
+                assert(ncomp <= (lg + 1) * size);
+
+                r2_kway_merge_int64(iarrs, sizes, k, out);
+                for(r2_uint64 i = 0; i < size; ++i)
+                        assert(out[i] == sorted[i]);
+
+                dest.arr = out;
+                dest.n   = 0;
+                memset(out, 0, sizeof(r2_int64) * size);
+                n = r2_kway_merge_iter(iters, k, sizeof(r2_int64), cursor_next, cursor_push, &dest, int_cmp);
+                assert(n == size && dest.n == size);
+                for(r2_uint64 i = 0; i < size; ++i)
+                        assert(out[i] == sorted[i]);
+        }
+
+        free(records);
+        free(merged);
+        free(keys);
+        free(out);
+        free(sorted);
+        free(arrs);
+        free(iarrs);
+        free(cursors);
+        free(iters);
+        free(sizes);
+}
+
+static void test_r2_argsort()
+{
+        printf("\n--------------------------------Argsort----------------------------------------\n");
+        r2_int64 mixed[] = {1, 10, 5, 4, 2, 10, 9, 8, 7, -6};
+        r2_uint64 expected[] = {9, 0, 4, 3, 2, 8, 7, 6, 1, 5};
+        r2_uint64 *perm = r2_argsort(mixed, 0, 10, sizeof(r2_int64), int_cmp);
+        for(r2_uint64 i = 0; i < 10; ++i)
+                assert(perm[i] == expected[i]);
+        r2_permute(mixed, 0, 10, sizeof(r2_int64), perm);
+        is_sorted(mixed, 0, 10, sizeof(r2_int64), int_cmp);
+        free(perm);
+
+        const r2_uint64 size = 100000;
+        struct big_record *records = malloc(sizeof(struct big_record) * size);
+        struct big_record *copy    = malloc(sizeof(struct big_record) * size);
+        for(r2_uint16 dist = 0; dist < 3; ++dist){
+                for(r2_uint64 i = 0; i < size; ++i){
+                        if(dist == 0)
+                                records[i].key = ((r2_uint64)rand() << 31) ^ rand();
+                        else if(dist == 1)
+                                records[i].key = rand() % 10;
+                        else    records[i].key = size - i;
+                        records[i].pos = i;
+                        memset(records[i].payload, (char)(i % 128), sizeof(records[i].payload));
+                }
+                memcpy(copy, records, sizeof(struct big_record) * size);
+
+                /*Both argsorts must return the same stable permutation.*/
+                perm = r2_argsort(records, 0, size, sizeof(struct big_record), uint_cmp);
+                r2_uint64 *kperm = r2_key_argsort(records, 0, size, sizeof(struct big_record), big_key);
+                for(r2_uint64 i = 0; i < size; ++i)
+                        assert(perm[i] == kperm[i]);
+
+                r2_key_sort(records, 0, size, sizeof(struct big_record), big_key);
+                for(r2_uint64 i = 0; i < size; ++i){
+                        assert(records[i].pos == perm[i]);
+                        assert(records[i].payload[0] == (char)(perm[i] % 128) && records[i].payload[495] == (char)(perm[i] % 128));
+                        if(i > 0){
+                                assert(records[i-1].key <= records[i].key);
+                                if(records[i-1].key == records[i].key)
+                                        assert(records[i-1].pos < records[i].pos);
+                        }
+                }
+
+                r2_radix_sort_key(copy, 0, size, sizeof(struct big_record), big_key);
+                assert(memcmp(copy, records, sizeof(struct big_record) * size) == 0);
+                free(perm);
+                free(kperm);
+        }
+
+        /*Testing argsort not starting from zero*/
+        r2_int64 part[] = {5, 1, 5, 2, 4, 3};
+        perm = r2_argsort(part, 1, 6, sizeof(r2_int64), int_cmp);
+        r2_permute(part, 1, 6, sizeof(r2_int64), perm);
+        is_sorted(part, 1, 6, sizeof(r2_int64), int_cmp);
+        assert(part[0] == 5);
+        free(perm);
+
+        free(records);
+        free(copy);
+}
+
+static void test_r2_external_sort()
+{
+        printf("\n--------------------------------External Sort----------------------------------------\n");
+        const r2_uint64 size = 200000;
+        r2_int64 *keys = malloc(sizeof(r2_int64) * size);
+        struct record *records = malloc(sizeof(struct record) * 1000);
+        r2_uint64 mem[] = {1 << 20, 1 << 16, 1 << 13, 1 << 30};
+        FILE *fp = NULL;
+        r2_int64 key;
+        r2_uint64 n;
+
+        /*Testing text integers, with 64KB and 8KB of memory the runs are merged in several passes.*/
+        fp = fopen("external.txt", "w");
+        for(r2_uint64 i = 0; i < size; ++i){
+                keys[i] = rand() % 100000 - 50000;
+                fprintf(fp, "%lld%c", keys[i], i % 10 == 9? '\n' : ' ');
+        }
+        fclose(fp);
+        r2_radix_sort_int64(keys, 0, size);
+        for(r2_uint16 i = 0; i < 4; ++i){
+                assert(r2_external_sort_ints("external.txt", "external_sorted.txt", mem[i]) == TRUE);
+                fp = fopen("external_sorted.txt", "r");
+                n  = 0;
+                while(fscanf(fp, "%lld", &key) == 1){
+                        assert(n < size && key == keys[n]);
+                        ++n;
+                }
+                assert(n == size);
+                fclose(fp);
+        }
+
+        /*Testing fixed width records*/
+        fp = fopen("external.bin", "wb");
+        for(r2_uint64 i = 0; i < 1000; ++i){
+                records[i].key = rand() % 50;
+                records[i].pos = i;
+                fwrite(&records[i], sizeof(struct record), 1, fp);
+        }
+        fclose(fp);
+        assert(r2_external_sort("external.bin", "external_sorted.bin", sizeof(struct record), sizeof(struct record) * 10, int_cmp) == TRUE);
+        fp = fopen("external_sorted.bin", "rb");
+        n  = fread(records, sizeof(struct record), 1000, fp);
+        fclose(fp);
+        assert(n == 1000);
+        is_sorted(records, 0, 1000, sizeof(struct record), int_cmp);
+
+        /*Testing a truncated record and a malformed token, nothing may be dropped silently*/
+        fp = fopen("external.bin", "wb");
+        fwrite(records, sizeof(struct record), 10, fp);
+        fwrite(records, 1, sizeof(struct record) / 2, fp);
+        fclose(fp);
+        assert(r2_external_sort("external.bin", "external_sorted.bin", sizeof(struct record), 1 << 20, int_cmp) == FALSE);
+        assert(r2_external_sort("external.bin", "external_sorted.bin", sizeof(struct record), sizeof(struct record) * 3, int_cmp) == FALSE);
+        fp = fopen("external.txt", "w");
+        fprintf(fp, "3 1 2\n4 x 5\n");
+        fclose(fp);
+        assert(r2_external_sort_ints("external.txt", "external_sorted.txt", 1 << 20) == FALSE);
+        assert(r2_external_sort_ints("external.txt", "external_sorted.txt", 16) == FALSE);
+
+        /*Testing empty input and missing input*/
+        fp = fopen("external.bin", "wb");
+        fclose(fp);
+        assert(r2_external_sort("external.bin", "external_sorted.bin", sizeof(struct record), 1 << 20, int_cmp) == TRUE);
+        fp = fopen("external_sorted.bin", "rb");
+        assert(fread(records, sizeof(struct record), 1, fp) == 0);
+        fclose(fp);
+        assert(r2_external_sort("missing.bin", "external_sorted.bin", sizeof(struct record), 1 << 20, int_cmp) == FALSE);
+
+        remove("external.txt");
+        remove("external_sorted.txt");
+        remove("external.bin");
+        remove("external_sorted.bin");
+        free(keys);
+        free(records);
+}
+
 static void test_r2_sort_stats()
 {
         FILE *fp = fopen("partially_sorted.txt", "r"); 
@@ -526,6 +1455,68 @@ static r2_int16 double_cmp(const void *a, const void *b)
                 return -1; 
         else    return 1;
 }
+static r2_int16 uint_cmp(const void *a, const void *b)
+{
+        const r2_uint64 *c = a; 
+        const r2_uint64 *d = b; 
+        if(*c == *d)
+                return 0; 
+        else if(*c < *d)
+                return -1; 
+        else    return 1;
+}
+
+static r2_int16 float_cmp(const void *a, const void *b)
+{
+        const float *c = a; 
+        const float *d = b; 
+        if(*c == *d)
+                return 0; 
+        else if(*c < *d)
+                return -1; 
+        else    return 1;
+}
+
+static r2_int16 count_cmp(const void *a, const void *b)
+{
+        ++ncomp;
+        return int_cmp(a, b);
+}
+
+static r2_uint64 big_key(const void *a)
+{
+        const struct big_record *r = a;
+        return r->key;
+}
+
+static r2_int16 str_cmp(const void *a, const void *b)
+{
+        const char *const *c = a;
+        const char *const *d = b;
+        return strcmp(*c, *d);
+}
+
+static r2_uint16 cursor_next(void *iter, void *elem)
+{
+        struct cursor *c = iter;
+        if(c->pos == c->n)
+                return FALSE;
+        memcpy(elem, &c->arr[c->pos++], sizeof(r2_int64));
+        return TRUE;
+}
+
+static void cursor_push(void *elem, void *arg)
+{
+        struct cursor *c = arg;
+        memcpy(&c->arr[c->n++], elem, sizeof(r2_int64));
+}
+
+static r2_uint64 record_key(const void *a)
+{
+        const struct record *r = a;
+        return r2_radix_key_int64(r->key);
+}
+
 void r2_sort_test_run()
 {
         test_insertion_sort();
@@ -538,6 +1529,18 @@ void r2_sort_test_run()
         test_bmerge_sort_mod();
         test_r2_quick_sort();
         test_r2_heap_sort();
+        test_r2_radix_sort();
+        test_r2_parallel_sort();
+        test_r2_pdq_sort();
+        test_r2_simd_sort();
+        test_r2_tim_sort();
+        test_r2_inplace_merge_sort();
+        test_r2_select();
+        test_r2_sort_define();
+        test_r2_string_sort();
+        test_r2_kway_merge();
+        test_r2_argsort();
+        test_r2_external_sort();
         test_r2_sort_stats();
 }
 
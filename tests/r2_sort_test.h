@@ -12,6 +12,18 @@ static void test_bmerge_sort();
 static void test_bmerge_sort_mod();
 static void test_r2_quick_sort();
 static void test_r2_heap_sort();
+static void test_r2_radix_sort();
+static void test_r2_parallel_sort();
+static void test_r2_pdq_sort();
+static void test_r2_simd_sort();
+static void test_r2_tim_sort();
+static void test_r2_inplace_merge_sort();
+static void test_r2_select();
+static void test_r2_sort_define();
+static void test_r2_string_sort();
+static void test_r2_kway_merge();
+static void test_r2_argsort();
+static void test_r2_external_sort();
 void r2_sort_test_run();
 
 #endif
\ No newline at end of file
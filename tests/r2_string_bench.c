@@ -0,0 +1,206 @@
+#include "r2_string_bench.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#define CORPORA 6
+#define LENGTHS 9
+#define MATCHERS 10
+#define CUBIC_MAX 8/*longest pattern given to r2_naive_dfa, it builds its DFA in O(256*m^3)*/
+#define REPEATS 3
+
+/*A matcher that is benchmarked.*/
+struct bench_matcher{
+        const char *name;
+        r2_int64 (*search)(const r2_c *, const r2_c *);/*null terminated search, NULL for length delimited searches*/
+        r2_uint16 algo;/*algorithm of r2_pattern_compile, R2_PATTERN_AUTO for r2_search*/
+};
+
+static const char *corpora[CORPORA] = {"random", "english", "dna", "binary", "periodic", "repetitive"};
+
+static const r2_uint64 lengths[LENGTHS] = {1, 2, 3, 4, 8, 16, 32, 64, 256};
+
+static const struct bench_matcher matchers[MATCHERS] = {
+        {"naive_substring", r2_naive_substring, 0},
+        {"rabin_karp", r2_rabin_karp, 0},
+        {"naive_dfa", r2_naive_dfa, 0},
+        {"kmp", r2_kmp, 0},
+        {"bmh", r2_bmh, 0},
+        {"pattern_kmp", NULL, R2_PATTERN_KMP},
+        {"pattern_bmh", NULL, R2_PATTERN_BMH},
+        {"pattern_dfa", NULL, R2_PATTERN_DFA},
+        {"pattern_simd", NULL, R2_PATTERN_SIMD},
+        {"search", NULL, R2_PATTERN_AUTO}
+};
+
+static const char *algorithms[] = {"kmp", "bmh", "dfa", "simd"};
+
+/**
+ * @brief               Runs every matcher over every corpus and pattern length and writes one row per run with the
+ *                      best time in seconds of a few runs, the algorithm r2_search picked and the time of the run 
+ *                      divided by the time of the fastest matcher. The time of a search includes building its tables,
+ *                      which is what a single r2_search pays. Every pattern is placed at the end of the corpus
+ *                      so searches scan all of it, unless a short pattern happens to occur earlier.
+ *
+ *                      random:     bytes 1 to 255
+ *                      english:    words of a small English vocabulary
+ *                      dna:        ACGT
+ *                      binary:     01
+ *                      periodic:   a run of 'a' with patterns a...ab
+ *                      repetitive: a run of 'a' with patterns a...aba...a
+ *
+ * @param size          Length of every corpus.
+ * @param format        R2_BENCH_CSV or R2_BENCH_JSON.
+ * @param path          Output file, NULL writes to stdout.
+ */
+void r2_string_bench_run(r2_uint64 size, r2_uint16 format, const char *path)
+{
+        FILE *out = path != NULL? fopen(path, "w") : stdout;
+        r2_c *text = malloc(size + 1);
+        r2_c pat[257];
+        r2_dbl seconds[MATCHERS], before, best;
+        r2_int64 pos, expected;
+        r2_uint64 m, rows = 0;
+        r2_uint16 plan;
+        assert(out != NULL && text != NULL && size > 512);
+        if(format == R2_BENCH_CSV)
+                fprintf(out, "algorithm,corpus,n,m,seconds,plan,ratio\n");
+        else    fprintf(out, "[");
+
+        for(r2_uint16 c = 0; c < CORPORA; ++c){
+                for(r2_uint16 l = 0; l < LENGTHS; ++l){
+                        srand(c*LENGTHS + l + 1);
+                        m = lengths[l];
+                        bench_corpus(text, size, c);
+                        bench_pattern(text, size, pat, m, c);
+                        expected = bench_compiled(text, size, pat, m, R2_PATTERN_KMP);
+                        plan = r2_search_plan(text, size, pat, m);
+
+                        best = -1;
+                        for(r2_uint16 s = 0; s < MATCHERS; ++s){
+                                seconds[s] = -1;
+                                if(matchers[s].search == r2_naive_dfa && m > CUBIC_MAX)
+                                        continue;
+                                for(r2_uint16 r = 0; r < REPEATS; ++r){
+                                        before = bench_now();
+                                        if(matchers[s].search != NULL)
+                                                pos = matchers[s].search(text, pat);
+                                        else if(matchers[s].algo == R2_PATTERN_AUTO)
+                                                pos = r2_search(text, size, pat, m);
+                                        else    pos = bench_compiled(text, size, pat, m, matchers[s].algo);
+                                        before = bench_now() - before;
+                                        assert(pos == expected);
+                                        if(seconds[s] < 0 || before < seconds[s])
+                                                seconds[s] = before;
+                                }
+                                if(best < 0 || seconds[s] < best)
+                                        best = seconds[s];
+                        }
+
+                        for(r2_uint16 s = 0; s < MATCHERS; ++s){
+                                if(seconds[s] < 0)
+                                        continue;
+                                if(format == R2_BENCH_CSV){
+                                        fprintf(out, "%s,%s,%llu,%llu,%.6f,%s,%.2f\n", matchers[s].name, corpora[c], size, m,
+                                                seconds[s], algorithms[plan], seconds[s]/best);
+                                }else{
+                                        fprintf(out, "%s\n  {\"algorithm\": \"%s\", \"corpus\": \"%s\", \"n\": %llu, \"m\": %llu, \"seconds\": %.6f, \"plan\": \"%s\", \"ratio\": %.2f}",
+                                                rows > 0? "," : "", matchers[s].name, corpora[c], size, m, seconds[s], algorithms[plan], seconds[s]/best);
+                                }
+                                ++rows;
+                        }
+                }
+        }
+
+        if(format == R2_BENCH_JSON)
+                fprintf(out, "\n]\n");
+        if(out != stdout)
+                fclose(out);
+        free(text);
+}
+
+/**
+ * @brief               Fills text with a corpus, the text is null terminated. The runs of 'a' of the periodic corpora
+ *                      are the worst case of naive searches, the first and last byte filter of the SIMD search
+ *                      and BMH only match their patterns with a mismatch in the middle.
+ *
+ * @param text          Text.
+ * @param n             Length of text.
+ * @param corpus        Corpus, an index of corpora.
+ */
+static void bench_corpus(r2_c *text, r2_uint64 n, r2_uint16 corpus)
+{
+        static const char *words[] = {"the", "of", "and", "to", "in", "is", "that", "for", "it", "as", "was", "with",
+                                      "be", "by", "on", "not", "he", "this", "are", "or", "his", "from", "at", "which",
+                                      "but", "have", "an", "had", "they", "you", "were", "their", "one", "all", "we",
+                                      "can", "her", "has", "there", "been", "if", "more", "when", "will", "would", 
+                                      "who", "so", "no", "search", "pattern", "string", "algorithm", "matching", "text"};
+        const char *w;
+        r2_uint64 i = 0;
+        while(i < n){
+                if(corpus == 0)
+                        text[i++] = (r2_c)(rand() % 255 + 1);
+                else if(corpus == 1){
+                        for(w = words[rand() % (sizeof(words)/sizeof(words[0]))]; *w != '\0' && i < n; ++w)
+                                text[i++] = *w;
+                        if(i < n)
+                                text[i++] = rand() % 12 == 0? '.' : ' ';
+                }else if(corpus == 2)
+                        text[i++] = "ACGT"[rand() % 4];
+                else if(corpus == 3)
+                        text[i++] = "01"[rand() % 2];
+                else    text[i++] = 'a';
+        }
+        text[n] = '\0';
+}
+
+/**
+ * @brief               Makes a pattern from the same source as the corpus and places it at the end of the text.
+ *                      The pattern of the periodic corpus is a...ab, the pattern of the repetitive corpus has 
+ *                      a 'b' in the middle.
+ *
+ * @param text          Text.
+ * @param n             Length of text.
+ * @param pat           Pattern, null terminated.
+ * @param m             Length of pattern.
+ * @param corpus        Corpus, an index of corpora.
+ */
+static void bench_pattern(r2_c *text, r2_uint64 n, r2_c *pat, r2_uint64 m, r2_uint16 corpus)
+{
+        bench_corpus(pat, m, corpus);
+        if(corpus == 4)
+                pat[m - 1] = 'b';
+        else if(corpus == 5)
+                pat[m/2] = 'b';
+        memcpy(&text[n - m], pat, m);
+}
+
+/**
+ * @brief               Compiles a pattern, searches the text and destroys the pattern.
+ *
+ * @param text          Text.
+ * @param n             Length of text.
+ * @param pat           Pattern.
+ * @param m             Length of pattern.
+ * @param algo          Algorithm of r2_pattern_compile.
+ * @return r2_int64     Returns the location of the first match found, else -1.
+ */
+static r2_int64 bench_compiled(const r2_c *text, r2_uint64 n, const r2_c *pat, r2_uint64 m, r2_uint16 algo)
+{
+        struct r2_pattern *cp = r2_pattern_compile(pat, m, algo);
+        assert(cp != NULL);
+        r2_int64 pos = r2_pattern_search(cp, text, n);
+        r2_destroy_pattern(cp);
+        return pos;
+}
+
+/**
+ * @brief               Returns the wall clock time in seconds.
+ */
+static r2_dbl bench_now()
+{
+        struct timespec ts;
+        timespec_get(&ts, TIME_UTC);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
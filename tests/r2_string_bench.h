@@ -0,0 +1,13 @@
+#ifndef R2_STRING_BENCH_H_
+#define R2_STRING_BENCH_H_
+#include "../src/r2_string.h"
+#ifndef R2_BENCH_CSV
+#define R2_BENCH_CSV  0
+#define R2_BENCH_JSON 1
+#endif
+static void bench_corpus(r2_c *, r2_uint64, r2_uint16);
+static void bench_pattern(r2_c *, r2_uint64, r2_c *, r2_uint64, r2_uint16);
+static r2_int64 bench_compiled(const r2_c *, r2_uint64, const r2_c *, r2_uint64, r2_uint16);
+static r2_dbl bench_now();
+void r2_string_bench_run(r2_uint64, r2_uint16, const char *);
+#endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "..\src\r2_string.h"
 #include <stdio.h>
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 /**
@@ -38,6 +40,23 @@ static void test_r2_rabin_karp_substring()
         assert(r2_rabin_karp("", str) == -1);
         assert(r2_rabin_karp("", "") == 0); 
 
+        /*Long patterns make the rolling hash subtract a larger value than the hash of the window.*/
+        char text[200];
+        char pat[24];
+        char *found = NULL;
+        r2_uint64 n, m;
+        for(r2_uint64 test = 0; test < 2000; ++test){
+                n = rand() % 199 + 1;
+                m = rand() % 23 + 1;
+                for(r2_uint64 i = 0; i < n; ++i)
+                        text[i] = (char)(rand() % 3 + (test % 2 == 0? 'a' : 253));
+                text[n] = '\0';
+                for(r2_uint64 i = 0; i < m; ++i)
+                        pat[i] = (char)(rand() % 3 + (test % 2 == 0? 'a' : 253));
+                pat[m] = '\0';
+                found = strstr(text, pat);
+                assert(r2_rabin_karp(text, pat) == (found != NULL? found - text : -1));
+        }
 }
 
 /**
@@ -56,6 +75,9 @@ static void test_r2_naive_dfa()
         assert(r2_naive_dfa(str, str) == 0);
         assert(r2_naive_dfa("", str) == -1);
         assert(r2_naive_dfa("", "") == 0); 
+        assert(r2_naive_dfa("aabaabaaab", "aaab") == 6);
+        assert(r2_naive_dfa("abababac", "ababac") == 2);
+        assert(r2_naive_dfa("\xff\xfe\xff\xff", "\xff\xff") == 2);
 }
 
 static void test_r2_kmp()
@@ -82,6 +104,428 @@ static void test_r2_bmh()
         assert(r2_bmh(str, str) == 0);
         assert(r2_bmh("", str) == -1);
         assert(r2_bmh("", "") == 0); 
+        assert(r2_bmh("\xff\xfe\xfd\xff\xfe", "\xfd\xff") == 2);
+}
+
+/**
+ * @brief Test compiled patterns against a brute force search.
+ * 
+ */
+static void test_r2_pattern()
+{
+        const char *str = "bacbababaabcbab";
+        r2_uint64 matches[64];
+        r2_uint64 expected[64];
+        struct r2_pattern *cp = NULL;
+        for(r2_uint16 algo = R2_PATTERN_KMP; algo <= R2_PATTERN_SIMD; ++algo){
+                cp = r2_pattern_compile("cbab", 4, algo);
+                assert(cp != NULL);
+                assert(r2_pattern_search(cp, str, 15) == 2);
+                assert(r2_pattern_search(cp, str, 5) == -1);
+                assert(r2_pattern_find_all(cp, str, 15, matches, 64) == 2);
+                assert(matches[0] == 2 && matches[1] == 11);
+                cp = r2_destroy_pattern(cp);
+
+                /*Overlapping matches*/
+                cp = r2_pattern_compile("aba", 3, algo);
+                assert(r2_pattern_find_all(cp, "abababa", 7, matches, 64) == 3);
+                assert(matches[0] == 0 && matches[1] == 2 && matches[2] == 4);
+                assert(r2_pattern_find_all(cp, "abababa", 7, NULL, 0) == 3);
+                cp = r2_destroy_pattern(cp);
+
+                /*Texts and patterns may contain null bytes*/
+                cp = r2_pattern_compile("a\0b", 3, algo);
+                assert(r2_pattern_search(cp, "xxa\0bxa\0b", 9) == 2);
+                assert(r2_pattern_find_all(cp, "xxa\0bxa\0b", 9, matches, 1) == 2);
+                assert(matches[0] == 2);
+                cp = r2_destroy_pattern(cp);
+
+                cp = r2_pattern_compile("", 0, algo);
+                assert(r2_pattern_search(cp, str, 15) == 0);
+                assert(r2_pattern_search(cp, "", 0) == 0);
+                cp = r2_destroy_pattern(cp);
+        }
+        assert(r2_pattern_compile("aba", 3, R2_PATTERN_AUTO + 1) == NULL);
+
+        char text[2000];
+        char pat[8];
+        r2_uint64 m, n, count;
+        for(r2_uint64 test = 0; test < 300; ++test){
+                n = rand() % 2000;
+                m = rand() % 8 + 1;
+                for(r2_uint64 i = 0; i < n; ++i)
+                        text[i] = (char)(rand() % 3 + (test % 2 == 0? 'a' : 254));
+                for(r2_uint64 i = 0; i < m; ++i)
+                        pat[i] = (char)(rand() % 3 + (test % 2 == 0? 'a' : 254));
+
+                count = 0;
+                for(r2_uint64 i = 0; i + m <= n; ++i)
+                        if(memcmp(&text[i], pat, m) == 0 && count < 64)
+                                expected[count++] = i;
+
+                for(r2_uint16 algo = R2_PATTERN_KMP; algo <= R2_PATTERN_SIMD; ++algo){
+                        cp = r2_pattern_compile(pat, m, algo);
+                        assert(r2_pattern_search(cp, text, n) == (count > 0? (r2_int64)expected[0] : -1));
+                        assert(r2_pattern_find_all(cp, text, n, matches, 64) >= count);
+                        for(r2_uint64 i = 0; i < count; ++i)
+                                assert(matches[i] == expected[i]);
+                        cp = r2_destroy_pattern(cp);
+                }
+        }
+}
+
+static void test_r2_simd_substring()
+{
+        r2_uint16 level = r2_string_simd();
+        char text[3000];
+        char pat[48];
+        r2_uint64 matches[3000];
+        r2_uint64 m, n, count;
+        struct r2_pattern *cp = NULL;
+        for(r2_uint16 simd = R2_STRING_SCALAR; simd <= level; ++simd){
+                r2_string_set_simd(simd);
+                assert(r2_string_simd() == simd);
+                assert(r2_simd_substring("bacbababaabcbab", 15, "cbab", 4) == 2);
+                assert(r2_simd_substring("bacbababaabcbab", 15, "abab", 4) == 4);
+                assert(r2_simd_substring("bacbababaabcbab", 15, "bab", 3) == 3);
+                assert(r2_simd_substring("bacbababaabcbab", 15, "cbabx", 5) == -1);
+                assert(r2_simd_substring("bacbababaabcbab", 15, "", 0) == 0);
+                assert(r2_simd_substring("ab", 2, "abc", 3) == -1);
+                assert(r2_simd_substring("xxa\0bxa\0b", 9, "a\0b", 3) == 2);
+
+                /*Matches at the end of the text are found by the scalar loop after the vector loop.*/
+                memset(text, 'a', 100);
+                text[99] = 'b';
+                for(m = 1; m <= 40; ++m)
+                        assert(r2_simd_substring(text, 100, &text[100 - m], m) == (r2_int64)(100 - m));
+
+                for(r2_uint64 test = 0; test < 300; ++test){
+                        n = rand() % 3000;
+                        m = rand() % (test % 3 == 0? 48 : 4) + 1;
+                        for(r2_uint64 i = 0; i < n; ++i)
+                                text[i] = (char)(rand() % 2 + (test % 2 == 0? 'a' : 255));
+                        for(r2_uint64 i = 0; i < m; ++i)
+                                pat[i] = (char)(rand() % 2 + (test % 2 == 0? 'a' : 255));
+                        /*Long patterns rarely occur by chance.*/
+                        if(m > 8 && n > m)
+                                memcpy(pat, &text[rand() % (n - m)], m);
+
+                        cp = r2_pattern_compile(pat, m, R2_PATTERN_SIMD);
+                        count = r2_pattern_find_all(cp, text, n, matches, 3000);
+                        assert(r2_simd_substring(text, n, pat, m) == (count > 0? (r2_int64)matches[0] : -1));
+                        for(r2_uint64 i = 0, j = 0; i + m <= n; ++i){
+                                if(memcmp(&text[i], pat, m) == 0){
+                                        assert(j < count && matches[j] == i);
+                                        ++j;
+                                }
+                                if(i + m == n)
+                                        assert(j == count);
+                        }
+                        cp = r2_destroy_pattern(cp);
+                }
+        }
+        r2_string_set_simd(R2_STRING_AVX2);
+}
+
+/**
+ * @brief Test that r2_search finds the same matches as a brute force search whatever algorithm it picks.
+ * 
+ */
+static void test_r2_search()
+{
+        r2_uint16 level = r2_string_simd();
+        static char text[20000];
+        char pat[300];
+        r2_uint64 n, m, alpha;
+        r2_int64 expected;
+        struct r2_pattern *cp = NULL;
+        assert(r2_search("bacbababaabcbab", 15, "cbab", 4) == 2);
+        assert(r2_search("bacbababaabcbab", 15, "", 0) == 0);
+        assert(r2_search("ab", 2, "abc", 3) == -1);
+        assert(r2_search_plan("bacbababaabcbab", 15, "c", 1) == R2_PATTERN_SIMD);
+
+        /*A run of 'a' makes the SIMD filter and BMH compare half of the pattern at every position.*/
+        memset(text, 'a', 20000);
+        memset(pat, 'a', 64);
+        pat[32] = 'b';
+        assert(r2_search_plan(text, 20000, pat, 64) == R2_PATTERN_KMP || r2_search_plan(text, 20000, pat, 64) == R2_PATTERN_DFA);
+        assert(r2_search(text, 20000, pat, 64) == -1);
+        memcpy(&text[20000 - 64], pat, 64);
+        assert(r2_search(text, 20000, pat, 64) == 20000 - 64);
+        cp = r2_pattern_compile(pat, 64, R2_PATTERN_AUTO);
+        assert(cp != NULL && cp->algo != R2_PATTERN_AUTO);
+        assert(r2_pattern_search(cp, text, 20000) == 20000 - 64);
+        cp = r2_destroy_pattern(cp);
+
+        for(r2_uint16 simd = R2_STRING_SCALAR; simd <= level; ++simd){
+                r2_string_set_simd(simd);
+                for(r2_uint64 test = 0; test < 200; ++test){
+                        n = rand() % 20000;
+                        m = rand() % (test % 4 == 0? 300 : 8) + 1;
+                        alpha = test % 3 == 0? 2 : test % 3 == 1? 4 : 256;
+                        for(r2_uint64 i = 0; i < n; ++i)
+                                text[i] = (char)(rand() % alpha);
+                        for(r2_uint64 i = 0; i < m; ++i)
+                                pat[i] = (char)(rand() % alpha);
+                        /*Long patterns rarely occur by chance, place them after the sample used by the plan.*/
+                        if(test % 2 == 0 && n > m)
+                                memcpy(&text[n - m - rand() % (n - m + 1)/8], pat, m);
+
+                        expected = -1;
+                        for(r2_uint64 i = 0; i + m <= n && expected < 0; ++i)
+                                if(memcmp(&text[i], pat, m) == 0)
+                                        expected = i;
+                        assert(r2_search(text, n, pat, m) == expected);
+                        assert(r2_search_plan(text, n, pat, m) <= R2_PATTERN_SIMD);
+                }
+        }
+        r2_string_set_simd(R2_STRING_AVX2);
+}
+
+struct stream_result{
+        r2_uint64 n;
+        r2_uint64 pos[3000];
+};
+
+static void stream_collect(void *pos, void *arg)
+{
+        struct stream_result *res = arg;
+        res->pos[res->n++] = *(r2_uint64 *)pos;
+}
+
+static void test_r2_matcher()
+{
+        struct r2_pattern *cp = r2_pattern_compile("abab", 4, R2_PATTERN_BMH);
+        assert(r2_create_matcher(cp) == NULL);
+        cp = r2_destroy_pattern(cp);
+        cp = r2_pattern_compile("", 0, R2_PATTERN_KMP);
+        assert(r2_create_matcher(cp) == NULL);
+        cp = r2_destroy_pattern(cp);
+
+        /*The match at 2 spans three chunks, the one at 4 overlaps it.*/
+        static struct stream_result res;
+        const r2_uint16 algos[] = {R2_PATTERN_KMP, R2_PATTERN_DFA};
+        struct r2_matcher *sm = NULL;
+        for(r2_uint64 k = 0; k < 2; ++k){
+                cp = r2_pattern_compile("abab", 4, algos[k]);
+                sm = r2_create_matcher(cp);
+                assert(sm != NULL);
+                res.n = 0;
+                assert(r2_matcher_feed(sm, "xxa", 3, stream_collect, &res) == 0);
+                assert(r2_matcher_feed(sm, "b", 1, stream_collect, &res) == 0);
+                assert(r2_matcher_feed(sm, "", 0, stream_collect, &res) == 0);
+                assert(r2_matcher_feed(sm, "abab", 4, stream_collect, &res) == 2);
+                assert(res.n == 2 && res.pos[0] == 2 && res.pos[1] == 4);
+                assert(sm->offset == 8);
+
+                /*A new stream doesn't continue the partial match.*/
+                r2_matcher_reset(sm);
+                assert(r2_matcher_feed(sm, "ab", 2, NULL, NULL) == 0);
+                assert(sm->offset == 2);
+                sm = r2_destroy_matcher(sm);
+                assert(sm == NULL);
+                cp = r2_destroy_pattern(cp);
+        }
+
+        /*Random streams cut into random chunks give the same matches as searching the whole text.*/
+        char text[3000];
+        char pat[8];
+        r2_uint64 matches[3000];
+        r2_uint64 n, m, count, i, c;
+        for(r2_uint64 test = 0; test < 200; ++test){
+                n = rand() % 3000;
+                m = rand() % 8 + 1;
+                for(i = 0; i < n; ++i)
+                        text[i] = (char)(rand() % 2 + (test % 2 == 0? 'a' : 255));
+                for(i = 0; i < m; ++i)
+                        pat[i] = (char)(rand() % 2 + (test % 2 == 0? 'a' : 255));
+
+                for(r2_uint64 k = 0; k < 2; ++k){
+                        cp = r2_pattern_compile(pat, m, algos[k]);
+                        sm = r2_create_matcher(cp);
+                        count = r2_pattern_find_all(cp, text, n, matches, 3000);
+                        res.n = 0;
+                        for(i = 0; i < n; i += c){
+                                c = rand() % 16;
+                                if(c > n - i)
+                                        c = n - i;
+                                r2_matcher_feed(sm, &text[i], c, stream_collect, &res);
+                        }
+                        assert(res.n == count && sm->offset == n);
+                        assert(memcmp(res.pos, matches, sizeof(r2_uint64) * count) == 0);
+                        r2_destroy_matcher(sm);
+                        r2_destroy_pattern(cp);
+                }
+        }
+}
+
+/**
+ * @brief Computes the smallest edit distance of the pattern to a substring ending at every position of text,
+ * or the edit distance of the pattern and the whole text when global is TRUE, with the dynamic programming table.
+ */
+static r2_uint64 approx_dp(const char *text, r2_uint64 n, const char *pat, r2_uint64 m, r2_uint16 global, r2_uint64 *best)
+{
+        r2_uint64 *col = malloc(sizeof(r2_uint64) * (m + 1));
+        r2_uint64 diag, up, c;
+        assert(col != NULL);
+        for(r2_uint64 i = 0; i <= m; ++i)
+                col[i] = i;
+        best[0] = m;
+        for(r2_uint64 j = 1; j <= n; ++j){
+                diag   = col[0];
+                col[0] = global == TRUE? j : 0;
+                for(r2_uint64 i = 1; i <= m; ++i){
+                        up = col[i];
+                        c  = diag + (pat[i - 1] != text[j - 1]);
+                        if(col[i - 1] + 1 < c)
+                                c = col[i - 1] + 1;
+                        if(up + 1 < c)
+                                c = up + 1;
+                        col[i] = c;
+                        diag   = up;
+                }
+                best[j] = col[m];
+        }
+        c = col[m];
+        free(col);
+        return c;
+}
+
+static void test_r2_approx()
+{
+        r2_uint64 ends[1100];
+        assert(r2_edit_distance("kitten", 6, "sitting", 7) == 3);
+        assert(r2_edit_distance("sitting", 7, "kitten", 6) == 3);
+        assert(r2_edit_distance("", 0, "abc", 3) == 3);
+        assert(r2_edit_distance("abc", 3, "abc", 3) == 0);
+        assert(r2_bitap("the quick brown fox", 19, "quick", 5, 0) == 9);
+        assert(r2_bitap("the quick brown fox", 19, "quikc", 5, 0) == -1);
+        assert(r2_bitap("the quick brown fox", 19, "quikc", 5, 1) == 8);
+        assert(r2_bitap("the quick brown fox", 19, "quikc", 5, 2) == 7);
+        assert(r2_bitap("abc", 3, "xy", 2, 2) == 0);
+        assert(r2_approx_find_all("abcabd", 6, "abd", 3, 1, ends, 1100) == 4);
+        assert(ends[0] == 2 && ends[1] == 3 && ends[2] == 5 && ends[3] == 6);
+        assert(r2_approx_find_all("ab", 2, "x", 1, 1, ends, 1100) == 3);
+
+        /*Random strings over small alphabets, patterns of one to four blocks, checked against the table.*/
+        char text[1000];
+        char pat[260];
+        r2_uint64 best[1001];
+        r2_uint64 n, m, k, count, expected;
+        r2_int64 first;
+        for(r2_uint64 test = 0; test < 300; ++test){
+                n = rand() % 1000;
+                m = test % 3 == 0? rand() % 260 + 1 : rand() % 70 + 1;
+                k = rand() % (m < 8? m + 1 : 8);
+                for(r2_uint64 i = 0; i < n; ++i)
+                        text[i] = (char)(rand() % (test % 4 + 2) + (test % 2 == 0? 'a' : 250));
+                for(r2_uint64 i = 0; i < m; ++i)
+                        pat[i] = (char)(rand() % (test % 4 + 2) + (test % 2 == 0? 'a' : 250));
+                /*Copies of a piece of the text with a few edits so there are matches.*/
+                if(test % 2 == 1 && n > m){
+                        memcpy(pat, &text[rand() % (n - m)], m);
+                        for(r2_uint64 e = 0; e < k/2 + 1; ++e)
+                                pat[rand() % m] = 'z';
+                }
+
+                assert(r2_edit_distance(pat, m, text, n) == (r2_int64)approx_dp(text, n, pat, m, TRUE, best));
+                approx_dp(text, n, pat, m, FALSE, best);
+                count = r2_approx_find_all(text, n, pat, m, k, ends, 1100);
+                expected = 0;
+                first = -1;
+                for(r2_uint64 j = 0; j <= n; ++j){
+                        if(best[j] <= k){
+                                assert(expected < count && ends[expected] == j);
+                                if(first == -1)
+                                        first = j;
+                                ++expected;
+                        }
+                }
+                assert(count == expected);
+                assert(r2_bitap(text, n, pat, m, k) == first);
+        }
+}
+
+struct set_result{
+        r2_uint64 n;
+        r2_uint64 pos[4096];
+        r2_uint64 id[4096];
+};
+
+static void set_collect(void *match, void *arg)
+{
+        struct r2_setmatch *m = match;
+        struct set_result *res = arg;
+        assert(res->n < 4096);
+        res->pos[res->n] = m->pos;
+        res->id[res->n]  = m->id;
+        ++res->n;
+}
+
+static void test_r2_patternset()
+{
+        static struct set_result res;
+        const char *sigs[] = {"abc", "bca", "xyz", "abc"};
+        struct r2_patternset *ps = r2_create_patternset(sigs, 4, 3);
+        assert(ps != NULL && ps->npats == 4);
+        res.n = 0;
+        assert(r2_patternset_search(ps, "abcabxyz", 8, set_collect, &res) == 4);
+        assert(res.pos[0] == 0 && res.pos[1] == 0 && res.id[0] + res.id[1] == 3);
+        assert(res.pos[2] == 1 && res.id[2] == 1);
+        assert(res.pos[3] == 5 && res.id[3] == 2);
+        assert(r2_patternset_search(ps, "ab", 2, NULL, NULL) == 0);
+        assert(r2_patternset_search(ps, "abc", 3, NULL, NULL) == 2);
+        ps = r2_destroy_patternset(ps);
+        assert(ps == NULL);
+        assert(r2_create_patternset(sigs, 4, 0) == NULL);
+
+        ps = r2_create_patternset(NULL, 0, 4);
+        assert(ps != NULL && r2_patternset_search(ps, "abcd", 4, NULL, NULL) == 0);
+        r2_destroy_patternset(ps);
+
+        /*Thousands of random signatures over small alphabets, including bytes with the high bit set.*/
+        static char pats[3000][8];
+        const char *ptrs[3000];
+        char text[4000];
+        r2_uint64 n, m, npats, expected, k;
+        for(r2_uint64 test = 0; test < 40; ++test){
+                n = rand() % 4000;
+                m = rand() % 8 + 1;
+                npats = rand() % 3000;
+                for(r2_uint64 i = 0; i < n; ++i)
+                        text[i] = (char)(rand() % 4 + (test % 2 == 0? 'a' : 252));
+                for(r2_uint64 p = 0; p < npats; ++p){
+                        for(r2_uint64 i = 0; i < m; ++i)
+                                pats[p][i] = (char)(rand() % 4 + (test % 2 == 0? 'a' : 252));
+                        ptrs[p] = pats[p];
+                }
+
+                ps = r2_create_patternset(ptrs, npats, m);
+                assert(ps != NULL);
+                res.n = 0;
+                r2_uint64 count = r2_patternset_search(ps, text, n, NULL, NULL);
+                if(count <= 4096)
+                        assert(r2_patternset_search(ps, text, n, set_collect, &res) == count);
+
+                expected = 0;
+                k = 0;
+                for(r2_uint64 pos = 0; pos + m <= n; ++pos){
+                        for(r2_uint64 p = 0; p < npats; ++p){
+                                if(memcmp(&text[pos], pats[p], m) != 0)
+                                        continue;
+                                ++expected;
+                                if(count > 4096)
+                                        continue;
+                                /*Every match at this position is reported once.*/
+                                for(k = 0; k < res.n && (res.pos[k] != pos || res.id[k] != p); ++k);
+                                assert(k < res.n);
+                        }
+                }
+                assert(count == expected);
+                for(k = 1; k < res.n; ++k)
+                        assert(res.pos[k - 1] <= res.pos[k]);
+                r2_destroy_patternset(ps);
+        }
 }
 
 void test_r2_string_run()
@@ -91,4 +535,10 @@ void test_r2_string_run()
         test_r2_naive_dfa();
         test_r2_kmp();
         test_r2_bmh();
+        test_r2_pattern();
+        test_r2_simd_substring();
+        test_r2_search();
+        test_r2_matcher();
+        test_r2_approx();
+        test_r2_patternset();
 }
\ No newline at end of file
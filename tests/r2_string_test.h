@@ -5,5 +5,11 @@ static void test_r2_rabin_karp_substring();
 static void test_r2_naive_dfa();
 static void test_r2_kmp();
 static void test_r2_bmh();
+static void test_r2_pattern();
+static void test_r2_simd_substring();
+static void test_r2_search();
+static void test_r2_matcher();
+static void test_r2_approx();
+static void test_r2_patternset();
 void test_r2_string_run();
 #endif
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "..\src\r2_suffixarray.h"
+#include "r2_suffixarray_test.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const r2_uc *suffix_text;/*text being tested*/
+static r2_uint64 suffix_len;
+
+/**
+ * @brief Compares two suffixes of the text being tested.
+ */
+static r2_int16 suffix_cmp(const r2_uint64 a, const r2_uint64 b)
+{
+        r2_uint64 la = suffix_len - a;
+        r2_uint64 lb = suffix_len - b;
+        int c = memcmp(&suffix_text[a], &suffix_text[b], la < lb? la : lb);
+        if(c != 0)
+                return c < 0? -1 : 1;
+        return la < lb? -1 : 1;
+}
+
+/**
+ * @brief Test that the suffixes are sorted and that the LCP array is right.
+ */
+static void test_r2_create_suffixarray()
+{
+        struct r2_suffixarray *sa = r2_create_suffixarray("banana", 6);
+        const r2_uint64 expected[] = {5, 3, 1, 0, 4, 2};
+        const r2_uint64 lcp[] = {0, 1, 3, 0, 0, 2};
+        assert(sa != NULL && sa->n == 6);
+        assert(memcmp(sa->sa, expected, sizeof(expected)) == 0);
+        assert(memcmp(sa->lcp, lcp, sizeof(lcp)) == 0);
+        sa = r2_destroy_suffixarray(sa);
+        assert(sa == NULL);
+
+        sa = r2_create_suffixarray("", 0);
+        assert(sa != NULL && sa->n == 0);
+        r2_destroy_suffixarray(sa);
+
+        sa = r2_create_suffixarray("a", 1);
+        assert(sa != NULL && sa->sa[0] == 0 && sa->lcp[0] == 0);
+        r2_destroy_suffixarray(sa);
+
+        /*Random texts over small alphabets, including bytes 0 and 255, and periodic texts that recurse deeply.*/
+        r2_uc text[2000];
+        r2_uint64 n, h;
+        for(r2_uint64 test = 0; test < 200; ++test){
+                n = rand() % 2000;
+                for(r2_uint64 i = 0; i < n; ++i){
+                        if(test % 4 == 3)
+                                text[i] = (r2_uc)(i % (test % 7 + 1));
+                        else
+                                text[i] = (r2_uc)(rand() % (test % 3 + 1) + (test % 2 == 0? 0 : 254));
+                }
+
+                sa = r2_create_suffixarray((const r2_c *)text, n);
+                assert(sa != NULL);
+                suffix_text = text;
+                suffix_len  = n;
+                for(r2_uint64 i = 1; i < n; ++i){
+                        assert(suffix_cmp(sa->sa[i - 1], sa->sa[i]) < 0);
+                        for(h = 0; sa->sa[i - 1] + h < n && sa->sa[i] + h < n && text[sa->sa[i - 1] + h] == text[sa->sa[i] + h]; ++h);
+                        assert(sa->lcp[i] == h);
+                }
+                r2_destroy_suffixarray(sa);
+        }
+}
+
+/**
+ * @brief Test that searches find every occurrence.
+ */
+static void test_r2_suffixarray_search()
+{
+        const char *str = "bacbababaabcbab";
+        struct r2_suffixarray *sa = r2_create_suffixarray(str, 15);
+        r2_uint64 matches[2000];
+        r2_uint64 first, count;
+        assert(r2_suffixarray_search(sa, "bab", 3, &first) == 3);
+        for(r2_uint64 i = 0; i < 3; ++i)
+                assert(memcmp(&str[sa->sa[first + i]], "bab", 3) == 0);
+        assert(r2_suffixarray_find_all(sa, "cbab", 4, matches, 2000) == 2);
+        assert((matches[0] == 2 && matches[1] == 11) || (matches[0] == 11 && matches[1] == 2));
+        assert(r2_suffixarray_search(sa, "cbabx", 5, NULL) == 0);
+        assert(r2_suffixarray_search(sa, "bacbababaabcbabb", 16, NULL) == 0);
+        assert(r2_suffixarray_search(sa, "", 0, NULL) == 15);
+        assert(r2_suffixarray_find_all(sa, "b", 1, matches, 1) == 7);
+        r2_destroy_suffixarray(sa);
+
+        r2_uc text[2000];
+        r2_uc pat[8];
+        r2_uint64 n, m, expected;
+        r2_uc *seen = NULL;
+        for(r2_uint64 test = 0; test < 200; ++test){
+                n = rand() % 2000;
+                m = rand() % 8 + 1;
+                for(r2_uint64 i = 0; i < n; ++i)
+                        text[i] = (r2_uc)(rand() % 2 + (test % 2 == 0? 'a' : 255));
+                for(r2_uint64 i = 0; i < m; ++i)
+                        pat[i] = (r2_uc)(rand() % 2 + (test % 2 == 0? 'a' : 255));
+
+                sa = r2_create_suffixarray((const r2_c *)text, n);
+                count = r2_suffixarray_find_all(sa, (const r2_c *)pat, m, matches, 2000);
+                seen  = calloc(n + 1, sizeof(r2_uc));
+                assert(seen != NULL);
+                for(r2_uint64 i = 0; i < count; ++i)
+                        seen[matches[i]] = TRUE;
+
+                expected = 0;
+                for(r2_uint64 i = 0; i + m <= n; ++i){
+                        if(memcmp(&text[i], pat, m) == 0){
+                                assert(seen[i] == TRUE);
+                                ++expected;
+                        }
+                }
+                assert(count == expected);
+                free(seen);
+                r2_destroy_suffixarray(sa);
+        }
+}
+
+/**
+ * @brief Test the longest repeated substring.
+ */
+static void test_r2_suffixarray_longest_repeat()
+{
+        struct r2_suffixarray *sa = r2_create_suffixarray("banana", 6);
+        r2_uint64 pos = 0;
+        assert(r2_suffixarray_longest_repeat(sa, &pos) == 3);
+        assert(memcmp(&sa->text[pos], "ana", 3) == 0);
+        r2_destroy_suffixarray(sa);
+
+        sa = r2_create_suffixarray("abcd", 4);
+        assert(r2_suffixarray_longest_repeat(sa, NULL) == 0);
+        r2_destroy_suffixarray(sa);
+
+        sa = r2_create_suffixarray("", 0);
+        assert(r2_suffixarray_longest_repeat(sa, &pos) == 0);
+        r2_destroy_suffixarray(sa);
+}
+
+void test_r2_suffixarray_run()
+{
+        test_r2_create_suffixarray();
+        test_r2_suffixarray_search();
+        test_r2_suffixarray_longest_repeat();
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#ifndef R2_SUFFIXARRAY_TEST_H_
+#define R2_SUFFIXARRAY_TEST_H_
+static void test_r2_create_suffixarray();
+static void test_r2_suffixarray_search();
+static void test_r2_suffixarray_longest_repeat();
+void test_r2_suffixarray_run();
+#endif
\ No newline at end of file
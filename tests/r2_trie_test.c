@@ -64,6 +64,107 @@ static void test_r2_trie_longgest_prefix()
         assert(strcmp(r2_trie_longest_prefix(trie, (r2_uc *)str[3], strlen(str[3])), str[0]) == 0);
         r2_destroy_trie(trie);
 }
+struct ac_result{
+        r2_uint64 n;
+        r2_uint64 pos[64];
+        r2_uint64 len[64];
+        void *data[64];
+};
+
+static void ac_collect(void *match, void *arg)
+{
+        struct r2_acmatch *m   = match;
+        struct ac_result *res = arg;
+        assert(res->n < 64);
+        res->pos[res->n]  = m->pos;
+        res->len[res->n]  = m->len;
+        res->data[res->n] = m->data;
+        ++res->n;
+}
+
+static void ac_count(void *match, void *arg)
+{
+        struct r2_acmatch *m = match;
+        r2_uint64 *count = arg;
+        count[m->pos*4 + m->len - 1] += 1;
+}
+
+static void test_r2_ac()
+{
+        /*Classic example, all four keys overlap in ushers.*/
+        struct r2_trie *trie = r2_create_trie(NULL, NULL);
+        const char *keys[] = {"he", "she", "his", "hers"};
+        for(r2_uint64 i = 0; i < 4; ++i)
+                assert(r2_trie_insert(trie, (r2_uc *)keys[i], strlen(keys[i]), (void *)keys[i]) == TRUE);
+
+        struct r2_ac *ac = r2_create_ac(trie);
+        struct ac_result res = {0};
+        assert(ac != NULL);
+        assert(r2_ac_search(ac, (const r2_uc *)"ushers", 6, ac_collect, &res) == 3);
+        assert(res.n == 3);
+        assert(res.pos[0] == 1 && res.len[0] == 3 && res.data[0] == keys[1]);
+        assert(res.pos[1] == 2 && res.len[1] == 2 && res.data[1] == keys[0]);
+        assert(res.pos[2] == 2 && res.len[2] == 4 && res.data[2] == keys[3]);
+        assert(r2_ac_search(ac, (const r2_uc *)"", 0, ac_collect, &res) == 0);
+        assert(r2_ac_search(ac, (const r2_uc *)"hishe", 5, NULL, NULL) == 3);
+        ac = r2_destroy_ac(ac);
+        assert(ac == NULL);
+        r2_destroy_trie(trie);
+
+        /*An empty trie has no matches.*/
+        trie = r2_create_trie(NULL, NULL);
+        ac   = r2_create_ac(trie);
+        assert(ac != NULL && ac->nstates == 1);
+        assert(r2_ac_search(ac, (const r2_uc *)"abc", 3, NULL, NULL) == 0);
+        r2_destroy_ac(ac);
+        r2_destroy_trie(trie);
+
+        /*Random keys over small alphabets, including bytes 0 and 255, are checked against a naive search.*/
+        const r2_uc alphabet[] = {'a', 'b', 0, 255};
+        r2_uc pats[32][4];
+        r2_uint64 plens[32];
+        r2_uc text[512];
+        r2_uint64 *expected = calloc(sizeof(text) * 4, sizeof(r2_uint64));
+        r2_uint64 *actual   = calloc(sizeof(text) * 4, sizeof(r2_uint64));
+        r2_uint64 total;
+        assert(expected != NULL && actual != NULL);
+        srand(42);
+        for(r2_uint64 round = 0; round < 50; ++round){
+                r2_uint64 sigma = 2 + round % 3;
+                r2_uint64 npats = 1 + rand() % 32;
+                trie  = r2_create_trie(NULL, NULL);
+                for(r2_uint64 i = 0; i < npats; ++i){
+                        plens[i] = 1 + rand() % 4;
+                        for(r2_uint64 j = 0; j < plens[i]; ++j)
+                                pats[i][j] = alphabet[round % 2 == 0? rand() % sigma : 3 - rand() % sigma];
+                        r2_trie_insert(trie, pats[i], plens[i], pats[i]);
+                }
+                for(r2_uint64 i = 0; i < sizeof(text); ++i)
+                        text[i] = alphabet[rand() % 4];
+
+                memset(expected, 0, sizeof(text) * 4 * sizeof(r2_uint64));
+                memset(actual, 0, sizeof(text) * 4 * sizeof(r2_uint64));
+                total = 0;
+                for(r2_uint64 pos = 0; pos < sizeof(text); ++pos){
+                        for(r2_uint64 len = 1; len <= 4 && pos + len <= sizeof(text); ++len){
+                                if(r2_trie_search(trie, &text[pos], len) != NULL){
+                                        expected[pos*4 + len - 1] = 1;
+                                        ++total;
+                                }
+                        }
+                }
+
+                ac = r2_create_ac(trie);
+                assert(ac != NULL);
+                assert(r2_ac_search(ac, text, sizeof(text), ac_count, actual) == total);
+                assert(memcmp(expected, actual, sizeof(text) * 4 * sizeof(r2_uint64)) == 0);
+                r2_destroy_ac(ac);
+                r2_destroy_trie(trie);
+        }
+        free(expected);
+        free(actual);
+}
+
 void test_r2_trie_run()
 {
         test_r2_create_trie(); 
@@ -71,4 +172,5 @@ void test_r2_trie_run()
         test_r2_trie_search();
         test_r2_trie_delete();
         test_r2_trie_longgest_prefix();
+        test_r2_ac();
 }
\ No newline at end of file
@@ -5,5 +5,6 @@ static void test_r2_trie_insert();
 static void test_r2_trie_search();
 static void test_r2_trie_delete();
 static void test_r2_trie_longgest_prefix();
+static void test_r2_ac();
 void test_r2_trie_run();
 #endif
\ No newline at end of file